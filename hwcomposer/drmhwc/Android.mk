@@ -93,7 +93,9 @@ LOCAL_SRC_FILES := \
 	worker.cpp \
 	hwc_util.cpp \
 	hwc_rockchip.cpp \
-	hwc_debug.cpp
+	hwc_debug.cpp \
+	hwc_config.cpp \
+	hwc_vop_bw.cpp
 
 # API 30 -> Android 11.0
 ifneq (1,$(strip $(shell expr $(PLATFORM_SDK_VERSION) \< 30)))
@@ -487,4 +489,6 @@ LOCAL_MODULE_CLASS := SHARED_LIBRARIES
 LOCAL_MODULE_SUFFIX := $(TARGET_SHLIB_SUFFIX)
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif
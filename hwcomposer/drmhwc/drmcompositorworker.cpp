@@ -96,6 +96,8 @@ void DrmCompositorWorker::Routine() {
         return;
 //close pre-comp for static screen.
       case -ETIMEDOUT:
+        // nothing is imported or released on a static screen
+        compositor_->EvictIdle();
 #if 0
         ret = compositor_->SquashAll();
         if (ret)
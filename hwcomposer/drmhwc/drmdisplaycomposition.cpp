@@ -42,6 +42,7 @@
 #include "drmresources.h"
 #include "platform.h"
 #include "hwc_rockchip.h"
+#include "hwc_config.h"
 
 #include <stdlib.h>
 
@@ -362,9 +363,7 @@ int DrmDisplayComposition::CreateAndAssignReleaseFences() {
   }
   timeline_pre_comp_done_ = timeline_;
 
-  char value[PROPERTY_VALUE_MAX];
-  property_get( PROPERTY_TYPE ".hwc.disable_releaseFence", value, "0");
-  if(atoi(value) == 0){
+  if(hwc_config()->disable_release_fence == 0){
       char acBuf[50];
       for (DrmHwcLayer *layer : comp_layers) {
         if (!layer->release_fence){
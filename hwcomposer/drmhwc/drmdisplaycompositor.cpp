@@ -64,6 +64,7 @@
 #include "hwc_util.h"
 #include "hwc_debug.h"
 #include "hwc_rockchip.h"
+#include "hwc_config.h"
 
 #if USE_GRALLOC_4
 #include "drmgralloc4.h"
@@ -856,7 +857,7 @@ int DrmDisplayCompositor::DisablePlanes(DrmDisplayComposition *display_comp) {
 
   int ret;
 #ifdef USE_PLANE_RESERVED
-  int win1_reserved = hwc_get_int_property( PROPERTY_TYPE ".hwc.win1.reserved", "0");
+  int win1_reserved = hwc_config()->win1_reserved;
 #endif
   std::vector<DrmCompositionPlane> &comp_planes =
       display_comp->composition_planes();
@@ -1077,6 +1078,7 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
   uint32_t afbc_plane_id = 0;
   uint32_t plane_size = 0;
   uint32_t vop_bandwidth = 0, total_bandwidth = 0;
+  std::vector<hwc_vop_bw_plane_t> vop_bw_planes;
 
   std::vector<DrmHwcLayer> &layers = display_comp->layers();
   std::vector<DrmCompositionPlane> &comp_planes =
@@ -1114,23 +1116,7 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
     }
     else
     {
-      if (display_ == HWC_DISPLAY_PRIMARY){
-        if(hwc_have_baseparameter()){
-          property_get("persist." PROPERTY_TYPE ".overscan.main", overscan, "use_baseparameter");
-          if(!strcmp(overscan,"use_baseparameter"))
-            hwc_get_baseparameter_config(overscan,display_,BP_OVERSCAN,0);
-        }else{
-          property_get("persist." PROPERTY_TYPE ".overscan.main", overscan, "overscan 100,100,100,100");
-        }
-      }else{
-        if(hwc_have_baseparameter()){
-          property_get("persist." PROPERTY_TYPE ".overscan.aux", overscan, "use_baseparameter");
-          if(!strcmp(overscan,"use_baseparameter"))
-            hwc_get_baseparameter_config(overscan,display_,BP_OVERSCAN,0);
-        }else{
-          property_get("persist." PROPERTY_TYPE ".overscan.aux", overscan, "overscan 100,100,100,100");
-        }
-      }
+      hwc_get_overscan(display_, overscan);
       sscanf(overscan, "overscan %d,%d,%d,%d", &left_margin, &top_margin,
                &right_margin, &bottom_margin);
       ALOGD_IF(log_level(DBG_VERBOSE),"vop post scale overscan(%d,%d,%d,%d)",
@@ -1160,8 +1146,8 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
 
 #if RK_VR
   float w_scale=1.0,h_scale=1.0;
-  int xxx_w =  hwc_get_int_property( PROPERTY_TYPE ".xxx.x_w","720");
-  int xxx_h =  hwc_get_int_property( PROPERTY_TYPE ".xxx.x_h","1280");
+  int xxx_w =  hwc_config()->vr_x_w;
+  int xxx_h =  hwc_config()->vr_x_h;
   uint32_t act_w, act_h;
   std::tie(act_w, act_h, ret) = GetActiveModeResolution();
   if (ret) {
@@ -1186,7 +1172,7 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
     //Find out the fb target for clone layer.
     int fb_target_fb_id = -1;
 #ifdef USE_PLANE_RESERVED
-    int win1_reserved = hwc_get_int_property( PROPERTY_TYPE ".hwc.win1.reserved", "0");
+    int win1_reserved = hwc_config()->win1_reserved;
 #endif
 
 #if RK_3D_VIDEO
@@ -1401,9 +1387,7 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
 
     int dst_l,dst_t,dst_w,dst_h;
     int src_l,src_t,src_w,src_h;
-    float hfactor;
-    int scale_factor;
-    float src_bpp;
+    hwc_vop_bw_plane_t vop_bw_plane;
 
     src_l = (int)source_crop.left;
     src_t = (int)source_crop.top;
@@ -1487,13 +1471,20 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
       break;
     }
 
-    hfactor = (float)src_w/dst_w;
-    scale_factor = hfactor > 1.0 ? 2:1;
-    src_bpp = getPixelWidthByAndroidFormat(format);
-    vop_bandwidth = src_w * src_h * src_bpp * scale_factor;
-    total_bandwidth += vop_bandwidth;
-    ALOGD_IF(log_level(DBG_VERBOSE),"vop_bw: plane=%d,w=%d,h=%d,bpp=%f,scale_factor=%d,vop_bandwidth=%d bytes",
-                (plane ? plane->id() : -1),src_w,src_h,src_bpp,scale_factor,vop_bandwidth);
+    hwc_vop_bw_format(format, &vop_bw_plane.bpp, &vop_bw_plane.chroma);
+#if USE_AFBC_LAYER
+    vop_bw_plane.afbc = is_afbc;
+#else
+    vop_bw_plane.afbc = false;
+#endif
+    vop_bw_plane.src_w = src_w;
+    vop_bw_plane.src_h = src_h;
+    vop_bw_plane.dst_top = dst_t;
+    vop_bw_plane.dst_h = dst_h;
+    vop_bw_planes.push_back(vop_bw_plane);
+    vop_bandwidth = (uint32_t)hwc_vop_bw_frame_bytes(&vop_bw_plane);
+    ALOGD_IF(log_level(DBG_VERBOSE),"vop_bw: plane=%d,w=%d,h=%d,bpp=%f,chroma=%f,vop_bandwidth=%d bytes",
+                (plane ? plane->id() : -1),src_w,src_h,vop_bw_plane.bpp,vop_bw_plane.chroma,vop_bandwidth);
 
     plane_size++;
 
@@ -1595,8 +1586,27 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
     char vop_bw_str[50];
     int w_len = 0;
     char buf[80];
+    DrmConnector *vop_bw_conn = drm_->GetConnectorFromType(display_);
+    hwc_vop_bw_mode_t vop_bw_mode;
 
-    total_bandwidth = total_bandwidth /(1024.0 * 1024.0) * 60;
+    //the dmc feeds the average over the active lines, the line buffers of the vop take the peaks
+    if(vop_bw_conn && vop_bw_conn->current_mode().v_display() > 0)
+    {
+        DrmMode mode = vop_bw_conn->current_mode();
+        vop_bw_mode.v_display = mode.v_display();
+        vop_bw_mode.v_total = mode.v_total() > 0 ? mode.v_total() : mode.v_display();
+        vop_bw_mode.vrefresh = mode.v_refresh() > 0 ? mode.v_refresh() : 60;
+        vop_bw_mode.frame_h = mode.v_display();
+    }
+    else
+    {
+        vop_bw_mode.v_display = 1;
+        vop_bw_mode.v_total = 1;
+        vop_bw_mode.vrefresh = 60;
+        vop_bw_mode.frame_h = 1;
+    }
+    total_bandwidth = hwc_vop_bw_average(vop_bw_planes.data(), vop_bw_planes.size(),
+                                         &vop_bw_mode) / (1024.0 * 1024.0);
     sprintf(vop_bw_str,"%d,%d", plane_size, total_bandwidth);
     ALOGD_IF(log_level(DBG_VERBOSE),"vop_bw: plane_size=%d, total_bandwidth=%d M, vop_bw_str=%s", plane_size, total_bandwidth, vop_bw_str);
     if(vop_bw_fd_ > 0)
@@ -1613,11 +1623,9 @@ int DrmDisplayCompositor::CommitFrame(DrmDisplayComposition *display_comp,
       flags |= DRM_MODE_ATOMIC_TEST_ONLY;
 
 PRINT_TIME_START;
-    char value[PROPERTY_VALUE_MAX];
-    int new_value;
-    property_get( PROPERTY_TYPE ".hwc.msleep", value, "0");
-    new_value = atoi(value);
-    usleep(new_value*1000);
+    int new_value = hwc_config()->msleep;
+    if (new_value > 0)
+      usleep(new_value*1000);
 
     ret = drmModeAtomicCommit(drm_->fd(), pset, flags, drm_);
     if (ret) {
@@ -1783,6 +1791,19 @@ void DrmDisplayCompositor::ApplyFrame(
     ret = pthread_mutex_unlock(&lock_);
   if (ret)
     ALOGE("Failed to release lock for active_composition swap");
+
+  EvictIdle();
+}
+
+// The framebuffers cached by the importer are otherwise only evicted when a
+// buffer is imported or released
+void DrmDisplayCompositor::EvictIdle() {
+  AutoLock lock(&lock_, "compositor");
+  if (lock.Lock())
+    return;
+
+  if (active_composition_ && active_composition_->importer())
+    active_composition_->importer()->EvictIdle();
 }
 
 int DrmDisplayCompositor::Composite() {
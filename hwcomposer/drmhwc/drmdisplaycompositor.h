@@ -124,6 +124,7 @@ class DrmDisplayCompositor {
   int Composite();
   void ClearDisplay();
   int SquashAll();
+  void EvictIdle();
   void Dump(std::ostringstream *out) const;
 
   std::tuple<uint32_t, uint32_t, int> GetActiveModeResolution();
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2018 Fuzhou Rockchip Electronics Co.Ltd.
+ *
+ * Modification based on code covered by the Apache License, Version 2.0 (the "License").
+ * You may not use this software except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS TO YOU ON AN "AS IS" BASIS
+ * AND ANY AND ALL WARRANTIES AND REPRESENTATIONS WITH RESPECT TO SUCH SOFTWARE, WHETHER EXPRESS,
+ * IMPLIED, STATUTORY OR OTHERWISE, INCLUDING WITHOUT LIMITATION, ANY IMPLIED WARRANTIES OF TITLE,
+ * NON-INFRINGEMENT, MERCHANTABILITY, SATISFACTROY QUALITY, ACCURACY OR FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "hwc_config"
+
+#include "hwc_config.h"
+#include "hwc_rockchip.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+
+#include <cutils/properties.h>
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h>
+
+namespace android {
+
+enum {
+    HWC_CONFIG_INT,         /* atoi() of the value */
+    HWC_CONFIG_TRUE,        /* 1 if the value is "true" */
+    HWC_CONFIG_BOOL,        /* like property_get_bool() */
+    HWC_CONFIG_NOT_OFF,     /* 0 if the value is "off" */
+    HWC_CONFIG_STRING,      /* the value, in a PROPERTY_VALUE_MAX field */
+};
+
+typedef struct {
+    const char *name;
+    const char *default_value;
+    int type;
+    size_t offset;
+} hwc_config_property_t;
+
+#define HWC_CONFIG_PROPERTY(name, default_value, type, field) \
+    { name, default_value, type, offsetof(hwc_config_t, field) }
+
+static const hwc_config_property_t g_config_properties[] = {
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.log", "0", HWC_CONFIG_INT, log_level),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.compose_policy", "0", HWC_CONFIG_INT, compose_policy),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc", "1", HWC_CONFIG_INT, hwc_enable),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.win1.reserved", "0", HWC_CONFIG_INT, win1_reserved),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.win1.zpos", "0", HWC_CONFIG_INT, win1_zpos),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.force3d.primary", "0", HWC_CONFIG_INT, force3d_primary),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.msleep", "0", HWC_CONFIG_INT, msleep),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.disable_releaseFence", "0", HWC_CONFIG_INT, disable_release_fence),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.force_wait_acquireFence", "0", HWC_CONFIG_INT, force_wait_acquire_fence),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.fps", "0", HWC_CONFIG_BOOL, fps),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".vwb.time", "2500", HWC_CONFIG_INT, vwb_time),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".gmali.fbdc_target", "0", HWC_CONFIG_INT, fbdc_target),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".video.cvrs", "0", HWC_CONFIG_INT, video_cvrs),
+    HWC_CONFIG_PROPERTY("vendor.video.skipline", "0", HWC_CONFIG_INT, video_skipline),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".xxx.x_w", "720", HWC_CONFIG_INT, vr_x_w),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".xxx.x_h", "1280", HWC_CONFIG_INT, vr_x_h),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".dump", "", HWC_CONFIG_TRUE, dump),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hdmi_status.aux", "on", HWC_CONFIG_NOT_OFF, hdmi_status_aux),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".dp_status.aux", "on", HWC_CONFIG_NOT_OFF, dp_status_aux),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.plan_cache", "1", HWC_CONFIG_INT, plan_cache),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.plane_allocator", "1", HWC_CONFIG_INT, plane_allocator),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.plan_budget_us", "1000", HWC_CONFIG_INT, plan_budget_us),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".hwc.vop_bw_max", "0", HWC_CONFIG_INT, vop_bw_max),
+    HWC_CONFIG_PROPERTY(PROPERTY_TYPE ".display.timeline", "-1", HWC_CONFIG_INT, display_timeline),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".overscan.main", "", HWC_CONFIG_STRING, overscan_main),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".overscan.aux", "", HWC_CONFIG_STRING, overscan_aux),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".dualModeEnable", "0", HWC_CONFIG_INT, dual_mode_enable),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".dualModeTB", "0", HWC_CONFIG_INT, dual_mode_tb),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".dualModeRatioPri", "0", HWC_CONFIG_INT, dual_mode_ratio_pri),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".dualModeRatioAux", "0", HWC_CONFIG_INT, dual_mode_ratio_aux),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".framebuffer.main", "main", HWC_CONFIG_STRING, dual_framebuffer_main),
+    HWC_CONFIG_PROPERTY("persist." PROPERTY_TYPE ".framebuffer.aux", "aux", HWC_CONFIG_STRING, dual_framebuffer_aux),
+};
+
+#define HWC_CONFIG_COUNT    (sizeof(g_config_properties) / sizeof(g_config_properties[0]))
+
+/*
+ * Two snapshots, the one not published is rewritten by a reload. A reader
+ * is only affected if it holds a snapshot across two reloads, that is two
+ * frames.
+ */
+static hwc_config_t g_configs[2];
+static std::atomic<int> g_config_index(0);
+static pthread_mutex_t g_config_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t g_config_serial;
+
+/* for the dump */
+static uint64_t g_config_frames;
+static uint64_t g_config_reloads;
+static uint64_t g_config_reload_ns;
+static uint64_t g_config_check_ns;
+
+static uint64_t hwc_config_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+static void hwc_config_load(hwc_config_t *config)
+{
+    char value[PROPERTY_VALUE_MAX];
+
+    for (size_t i = 0; i < HWC_CONFIG_COUNT; i++) {
+        const hwc_config_property_t *p = &g_config_properties[i];
+        int *field = (int *)((char *)config + p->offset);
+
+        if (p->type == HWC_CONFIG_STRING) {
+            property_get(p->name, (char *)config + p->offset, p->default_value);
+            continue;
+        }
+
+        property_get(p->name, value, p->default_value);
+        switch (p->type) {
+            case HWC_CONFIG_TRUE:
+                *field = !strcmp(value, "true");
+                break;
+            case HWC_CONFIG_BOOL:
+                *field = !strcmp(value, "1") || !strcmp(value, "y") || !strcmp(value, "yes") ||
+                         !strcmp(value, "on") || !strcmp(value, "true");
+                break;
+            case HWC_CONFIG_NOT_OFF:
+                *field = !!strcmp(value, "off");
+                break;
+            default:
+                *field = atoi(value);
+                break;
+        }
+    }
+}
+
+/* with g_config_lock held */
+static void hwc_config_reload(void)
+{
+    int next = !g_config_index.load(std::memory_order_relaxed);
+    uint64_t start = hwc_config_now_ns();
+
+    /* read first, a change while loading is seen by the next frame */
+    g_config_serial = __system_property_area_serial();
+    hwc_config_load(&g_configs[next]);
+    g_config_index.store(next, std::memory_order_release);
+
+    g_config_reloads++;
+    g_config_reload_ns += hwc_config_now_ns() - start;
+}
+
+void hwc_config_init(void)
+{
+    pthread_mutex_lock(&g_config_lock);
+    hwc_config_reload();
+    pthread_mutex_unlock(&g_config_lock);
+}
+
+void hwc_config_refresh(bool force)
+{
+    uint64_t start = hwc_config_now_ns();
+
+    pthread_mutex_lock(&g_config_lock);
+
+    g_config_frames++;
+    if (force || __system_property_area_serial() != g_config_serial)
+        hwc_config_reload();
+    else
+        g_config_check_ns += hwc_config_now_ns() - start;
+
+    pthread_mutex_unlock(&g_config_lock);
+}
+
+const hwc_config_t *hwc_config(void)
+{
+    return &g_configs[g_config_index.load(std::memory_order_acquire)];
+}
+
+void hwc_config_dump(std::ostringstream *out)
+{
+    pthread_mutex_lock(&g_config_lock);
+
+    uint64_t skipped = g_config_frames > g_config_reloads ? g_config_frames - g_config_reloads : 0;
+    uint64_t reload_ns = g_config_reloads ? g_config_reload_ns / g_config_reloads : 0;
+    uint64_t check_ns = skipped ? g_config_check_ns / skipped : 0;
+
+    /* a skipped reload is the property_get() calls a frame used to make */
+    *out << "--HwcConfig: properties=" << HWC_CONFIG_COUNT
+         << " frames=" << g_config_frames << " reloads=" << g_config_reloads
+         << " reload_us=" << reload_ns / 1000 << " check_ns=" << check_ns << "\n"
+         << "    property_get saved=" << skipped * HWC_CONFIG_COUNT
+         << " cpu saved_ms=" << (skipped * (reload_ns > check_ns ? reload_ns - check_ns : 0)) / 1000000
+         << " per frame " << reload_ns / 1000 << "us -> " << check_ns << "ns\n";
+
+    pthread_mutex_unlock(&g_config_lock);
+}
+
+}
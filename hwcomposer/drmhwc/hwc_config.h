@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2018 Fuzhou Rockchip Electronics Co.Ltd.
+ *
+ * Modification based on code covered by the Apache License, Version 2.0 (the "License").
+ * You may not use this software except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS TO YOU ON AN "AS IS" BASIS
+ * AND ANY AND ALL WARRANTIES AND REPRESENTATIONS WITH RESPECT TO SUCH SOFTWARE, WHETHER EXPRESS,
+ * IMPLIED, STATUTORY OR OTHERWISE, INCLUDING WITHOUT LIMITATION, ANY IMPLIED WARRANTIES OF TITLE,
+ * NON-INFRINGEMENT, MERCHANTABILITY, SATISFACTROY QUALITY, ACCURACY OR FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HWC_CONFIG_H_
+#define _HWC_CONFIG_H_
+
+#include <stdint.h>
+#include <sstream>
+
+#include <cutils/properties.h>
+
+namespace android {
+
+/*
+ * Snapshot of the properties read on the composition path.
+ *
+ * The properties are loaded by hwc_config_init() and loaded again by
+ * hwc_config_refresh() only when the serial of the property area changed,
+ * so that a frame reads them from memory instead of calling property_get()
+ * per layer. The snapshot returned by hwc_config() is read without a lock;
+ * read the fields it needs and do not keep the pointer across frames.
+ */
+typedef struct hwc_config {
+    int log_level;                  /* PROPERTY_TYPE.hwc.log */
+    int compose_policy;             /* PROPERTY_TYPE.hwc.compose_policy */
+    int hwc_enable;                 /* PROPERTY_TYPE.hwc */
+    int win1_reserved;              /* PROPERTY_TYPE.hwc.win1.reserved */
+    int win1_zpos;                  /* PROPERTY_TYPE.hwc.win1.zpos */
+    int force3d_primary;            /* PROPERTY_TYPE.hwc.force3d.primary */
+    int msleep;                     /* PROPERTY_TYPE.hwc.msleep */
+    int disable_release_fence;      /* PROPERTY_TYPE.hwc.disable_releaseFence */
+    int force_wait_acquire_fence;   /* PROPERTY_TYPE.hwc.force_wait_acquireFence */
+    int fps;                        /* PROPERTY_TYPE.hwc.fps */
+    int vwb_time;                   /* PROPERTY_TYPE.vwb.time */
+    int fbdc_target;                /* PROPERTY_TYPE.gmali.fbdc_target */
+    int video_cvrs;                 /* persist.PROPERTY_TYPE.video.cvrs */
+    int video_skipline;             /* vendor.video.skipline */
+    int vr_x_w;                     /* PROPERTY_TYPE.xxx.x_w */
+    int vr_x_h;                     /* PROPERTY_TYPE.xxx.x_h */
+    int dump;                       /* PROPERTY_TYPE.dump is "true" */
+    int hdmi_status_aux;            /* PROPERTY_TYPE.hdmi_status.aux is not "off" */
+    int dp_status_aux;              /* PROPERTY_TYPE.dp_status.aux is not "off" */
+    int plan_cache;                 /* PROPERTY_TYPE.hwc.plan_cache */
+    int plane_allocator;            /* PROPERTY_TYPE.hwc.plane_allocator */
+    int plan_budget_us;             /* PROPERTY_TYPE.hwc.plan_budget_us */
+    int vop_bw_max;                 /* PROPERTY_TYPE.hwc.vop_bw_max, MB/s, 0: scale factor check */
+    int display_timeline;           /* PROPERTY_TYPE.display.timeline, -1 if not set */
+    char overscan_main[PROPERTY_VALUE_MAX]; /* persist.PROPERTY_TYPE.overscan.main, "" if not set */
+    char overscan_aux[PROPERTY_VALUE_MAX];  /* persist.PROPERTY_TYPE.overscan.aux, "" if not set */
+    int dual_mode_enable;           /* persist.PROPERTY_TYPE.dualModeEnable */
+    int dual_mode_tb;               /* persist.PROPERTY_TYPE.dualModeTB */
+    int dual_mode_ratio_pri;        /* persist.PROPERTY_TYPE.dualModeRatioPri */
+    int dual_mode_ratio_aux;        /* persist.PROPERTY_TYPE.dualModeRatioAux */
+    char dual_framebuffer_main[PROPERTY_VALUE_MAX]; /* persist.PROPERTY_TYPE.framebuffer.main, "main" if not set */
+    char dual_framebuffer_aux[PROPERTY_VALUE_MAX];  /* persist.PROPERTY_TYPE.framebuffer.aux, "aux" if not set */
+} hwc_config_t;
+
+void hwc_config_init(void);
+
+/*
+ * Called once per frame. force loads the properties even if the serial did
+ * not change, as the dump does.
+ */
+void hwc_config_refresh(bool force);
+
+const hwc_config_t *hwc_config(void);
+
+void hwc_config_dump(std::ostringstream *out);
+
+}
+
+#endif
@@ -39,6 +39,7 @@
 
 #include "hwc_debug.h"
 #include "hwc_rockchip.h"
+#include "hwc_config.h"
 #include <sstream>
 #include "drmgralloc4.h"
 
@@ -64,9 +65,7 @@ int get_frame()
 
 int init_log_level()
 {
-    char value[PROPERTY_VALUE_MAX];
-    property_get( PROPERTY_TYPE ".hwc.log", value, "0");
-    g_log_level = atoi(value);
+    g_log_level = hwc_config()->log_level;
     return 0;
 }
 
@@ -186,9 +185,7 @@ int DumpLayer(const char* layer_name,buffer_handle_t handle)
 
 int DumpLayerList(hwc_display_contents_1_t *dc, const gralloc_module_t *gralloc)
 {
-    char pro_value[PROPERTY_VALUE_MAX];
-    property_get( PROPERTY_TYPE ".dump",pro_value,0);
-    if(strcmp(pro_value,"true"))
+    if(!hwc_config()->dump)
         return 0;
 
     bool dumpFrame = false;
@@ -322,7 +319,7 @@ void hwc_dump_fps(void)
 
 	++n_frames;
 
-	if (property_get_bool( PROPERTY_TYPE ".hwc.fps", 0))
+	if (hwc_config()->fps)
 	{
 		unsigned int time = HWC_Clockms();
 		unsigned int intv = time - lastTime;
@@ -37,11 +37,14 @@
 #define LOG_TAG "hwc_rk"
 
 #include <inttypes.h>
+#include <time.h>
+#include <algorithm>
 #ifdef TARGET_BOARD_PLATFORM_RK3368
 #include <hardware/img_gralloc_public.h>
 #endif
 #include "hwc_rockchip.h"
 #include "hwc_util.h"
+#include "hwc_config.h"
 
 #if USE_GRALLOC_4
 #include "src/mali_gralloc_formats.h"
@@ -173,7 +176,7 @@ int hwc_static_screen_opt_set(bool isGLESComp)
 {
     struct itimerval tv = {{0,0},{0,0}};
     if (!isGLESComp) {
-        int interval_value = hwc_get_int_property( PROPERTY_TYPE ".vwb.time", "2500");
+        int interval_value = hwc_config()->vwb_time;
         interval_value = interval_value > 5000? 5000:interval_value;
         interval_value = interval_value < 250? 250:interval_value;
         TimeInt2Obj(interval_value,&tv.it_value);
@@ -209,7 +212,7 @@ int detect_3d_mode(hwc_drm_display_t *hd, hwc_display_contents_1_t *display_cont
 
     if(!needStereo)
     {
-        force3d = hwc_get_int_property( PROPERTY_TYPE ".hwc.force3d.primary","0");
+        force3d = hwc_config()->force3d_primary;
 
         if(1==force3d || 2==force3d){
             if(display == 0 || display == 1)
@@ -282,7 +285,7 @@ int detect_3d_mode(hwc_drm_display_t *hd, hwc_display_contents_1_t *display_cont
 
     if(!needStereo)
     {
-        force3d = hwc_get_int_property( PROPERTY_TYPE ".hwc.force3d.primary","0");
+        force3d = hwc_config()->force3d_primary;
 
         if(1==force3d || 2==force3d){
             if(display == 0 || display == 1)
@@ -1881,8 +1884,8 @@ bool MatchPlanes(
     bool bMatch = false;
 
 #ifdef USE_PLANE_RESERVED
-        uint64_t win1_reserved = hwc_get_int_property( PROPERTY_TYPE ".hwc.win1.reserved", "0");
-        uint64_t win1_zpos = hwc_get_int_property( PROPERTY_TYPE ".hwc.win1.zpos", "0");
+        uint64_t win1_reserved = hwc_config()->win1_reserved;
+        uint64_t win1_zpos = hwc_config()->win1_zpos;
 #endif
 
 
@@ -1980,6 +1983,62 @@ float getPixelWidthByAndroidFormat(int format)
        return pixelWidth;
 }
 
+void hwc_vop_bw_format(int format, float *bpp, float *chroma)
+{
+    *bpp = getPixelWidthByAndroidFormat(format);
+    *chroma = 0;
+
+    switch (format) {
+        case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+        case HAL_PIXEL_FORMAT_YCrCb_NV12:
+        case HAL_PIXEL_FORMAT_YCrCb_NV12_VIDEO:
+            *chroma = 0.5;
+            break;
+        case HAL_PIXEL_FORMAT_YCbCr_422_SP:
+        case HAL_PIXEL_FORMAT_YCbCr_422_I:
+            *chroma = 1.0;
+            break;
+        //10 bit samples are packed: 1.25 bytes of luma per pixel
+        case HAL_PIXEL_FORMAT_YCrCb_NV12_10:
+        case HAL_PIXEL_FORMAT_YCrCb_420_SP_10:
+            *bpp = 1.25;
+            *chroma = 0.5;
+            break;
+        case HAL_PIXEL_FORMAT_YCbCr_422_SP_10:
+            *bpp = 1.25;
+            *chroma = 1.0;
+            break;
+        default:
+            break;
+    }
+}
+
+void hwc_vop_bw_from_layer(const DrmHwcLayer& layer, hwc_vop_bw_plane_t *plane)
+{
+    hwc_vop_bw_format(layer.format, &plane->bpp, &plane->chroma);
+#if USE_AFBC_LAYER
+    plane->afbc = layer.is_afbc;
+#else
+    plane->afbc = false;
+#endif
+    plane->src_w = (int)(layer.source_crop.right - layer.source_crop.left);
+    plane->src_h = (int)(layer.source_crop.bottom - layer.source_crop.top);
+#if RK_VIDEO_SKIP_LINE
+    if (layer.SkipLine)
+        plane->src_h /= layer.SkipLine;
+#endif
+    plane->dst_top = layer.display_frame.top;
+    plane->dst_h = layer.display_frame.bottom - layer.display_frame.top;
+}
+
+static void hwc_vop_bw_display_mode(hwc_drm_display_t *hd, hwc_vop_bw_mode_t *mode)
+{
+    mode->v_display = hd->rel_yres;
+    mode->v_total = hd->v_total;
+    mode->vrefresh = hd->vrefresh;
+    mode->frame_h = hd->framebuffer_height;
+}
+
 static float vop_band_width(hwc_drm_display_t *hd, std::vector<DrmHwcLayer>& layers)
 {
     float scale_factor = 0;
@@ -1998,6 +2057,59 @@ static float vop_band_width(hwc_drm_display_t *hd, std::vector<DrmHwcLayer>& lay
     return scale_factor;
 }
 
+/*
+ * bytes/s the vop can fetch on a line: PROPERTY_TYPE.hwc.vop_bw_max in MB/s,
+ * 0 when unset. It depends on the soc and the dmc setup, there is no value
+ * to fall back to.
+ */
+uint64_t hwc_vop_bw_limit(hwc_drm_display_t *hd)
+{
+    UN_USED(hd);
+
+    if (hwc_config()->vop_bw_max > 0)
+        return (uint64_t)hwc_config()->vop_bw_max * 1024 * 1024;
+
+    return 0;
+}
+
+/*
+ * whether the vop can fetch the layers of a plan without underflow, without
+ * a limit it takes the scale factor check of the mix policy
+ */
+bool hwc_vop_bw_admit(hwc_drm_display_t *hd, std::vector<DrmHwcLayer>& layers)
+{
+    std::vector<hwc_vop_bw_plane_t> planes(layers.size());
+    hwc_vop_bw_mode_t mode;
+    uint64_t peak, limit;
+
+    limit = hwc_vop_bw_limit(hd);
+    if (limit == 0)
+    {
+        float scale_factor = vop_band_width(hd, layers);
+
+        if (scale_factor > 4.5)
+        {
+            ALOGD_IF(log_level(DBG_DEBUG), "%s: scale_factor=%f is so big", __FUNCTION__, scale_factor);
+            return false;
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < layers.size(); ++i)
+        hwc_vop_bw_from_layer(layers[i], &planes[i]);
+    hwc_vop_bw_display_mode(hd, &mode);
+
+    peak = hwc_vop_bw_peak(planes.data(), planes.size(), &mode);
+    if (peak > limit)
+    {
+        ALOGD_IF(log_level(DBG_DEBUG), "%s: peak %" PRIu64 " MB/s over the limit %" PRIu64 " MB/s",
+                 __FUNCTION__, peak >> 20, limit >> 20);
+        return false;
+    }
+
+    return true;
+}
+
 bool GetCrtcSupported(const DrmCrtc &crtc, uint32_t possible_crtc_mask) {
   return !!((1 << crtc.pipe()) & possible_crtc_mask);
 }
@@ -2522,6 +2634,469 @@ FailMatch:
     return false;
 }
 
+/*
+ * Cost based plane allocation.
+ *
+ * The layers a frame cannot put on planes are composed by GLES into the fb
+ * target, which takes a single zpos, so a plan is a range [first, last] of
+ * the stack mixed into the fb target, or no range at all. Every range is
+ * costed, then tried in the order of its cost; the first one MatchPlanes()
+ * can place under the constraints of the plane groups (AFBC, YUV, scale,
+ * alpha, EOTF) and hwc_vop_bw_admit() lets through is the cheapest feasible
+ * plan. An HDR display skips the bandwidth check like the mix policy does,
+ * its video layer cannot go to GLES.
+ */
+#define PLAN_GPU_PIXEL_COST     4.0     //cost of a pixel composed by GLES, in DDR bytes
+
+typedef struct plan_candidate {
+    int first;          //-1: no layer goes to GLES
+    int last;
+    double cost;
+} plan_candidate_t;
+
+static uint64_t plan_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double plan_layer_bytes(const DrmHwcLayer& layer)
+{
+    double w = layer.source_crop.right - layer.source_crop.left;
+    double h = layer.source_crop.bottom - layer.source_crop.top;
+
+    return w * h * (layer.bpp > 0 ? layer.bpp : (layer.is_yuv ? 1.5 : 4.0));
+}
+
+static int plan_layer_area(const DrmHwcLayer& layer)
+{
+    return (layer.display_frame.right - layer.display_frame.left) *
+           (layer.display_frame.bottom - layer.display_frame.top);
+}
+
+/*
+ * DDR bytes of a frame: the vop reads the layers on planes and the fb target,
+ * GLES reads the mixed layers and writes the fb target.
+ */
+static double plan_cost(std::vector<DrmHwcLayer>& layers, int first, int last, int fbSize)
+{
+    double cost = 0;
+
+    for (int i = 0; i < (int)layers.size(); ++i)
+    {
+        if (first >= 0 && i >= first && i <= last)
+            cost += plan_layer_bytes(layers[i]) + plan_layer_area(layers[i]) * PLAN_GPU_PIXEL_COST;
+        else
+            cost += plan_layer_bytes(layers[i]);
+    }
+
+    if (first >= 0)
+        cost += 2.0 * fbSize * 4;
+
+    return cost;
+}
+
+static bool plan_candidate_cmp(const plan_candidate_t& a, const plan_candidate_t& b)
+{
+    return a.cost < b.cost;
+}
+
+bool cost_policy(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
+                std::vector<DrmCompositionPlane>& composition_planes)
+{
+    std::vector<DrmHwcLayer> tmp_layers;
+    std::vector<plan_candidate_t> candidates;
+    std::pair<int, int> skip_layer_indices(-1, -1);
+    uint64_t budget_ns = (uint64_t)hwc_config()->plan_budget_us * 1000;
+    uint64_t start = plan_now_ns();
+    hwc_plan_cache_t *stat = &hd->plan_cache;
+    bool bHasFb = false;
+    int n, tried = 0;
+
+    if(!crtc)
+    {
+        ALOGE("%s:line=%d crtc is null",__FUNCTION__,__LINE__);
+        return false;
+    }
+
+    //the layout of a 3d stack is left to the mix policies.
+    if(hd->is_3d)
+        return mix_policy(drm, crtc, hd, layers, iPlaneSize, fbSize, composition_planes);
+
+    move_fb_layer_to_tmp(layers, tmp_layers);
+    bHasFb = !tmp_layers.empty();
+    n = layers.size();
+
+    for (int i = 0; i < n; ++i) {
+      if (!layers[i].bSkipLayer)
+        continue;
+
+      if (skip_layer_indices.first == -1)
+        skip_layer_indices.first = i;
+      skip_layer_indices.second = i;
+    }
+
+    if (skip_layer_indices.first == -1)
+    {
+        plan_candidate_t c = { -1, -1, plan_cost(layers, -1, -1, fbSize) };
+        candidates.push_back(c);
+    }
+
+    //a range must hold the skip layers, and leave a layer on a plane
+    for (int first = 0; bHasFb && first < n; ++first)
+    {
+        if (skip_layer_indices.first != -1 && first > skip_layer_indices.first)
+            break;
+
+        for (int last = first; last < n; ++last)
+        {
+            if (last < skip_layer_indices.second || (first == 0 && last == n - 1))
+                continue;
+            //try_mix_policy() does not move a clone layer
+            if (layers[last].bClone_)
+                break;
+            if (n - (last - first) > iPlaneSize)
+                continue;
+
+            plan_candidate_t c = { first, last, plan_cost(layers, first, last, fbSize) };
+            candidates.push_back(c);
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), plan_candidate_cmp);
+    stat->searches++;
+
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        plan_candidate_t& c = candidates[i];
+        bool bAllMatch;
+
+        if (tried > 0 && plan_now_ns() - start > budget_ns)
+        {
+            stat->search_expired++;
+            stat->expired = true;
+            ALOGD_IF(log_level(DBG_DEBUG), "%s: time budget of %" PRIu64 "ns spent after %d plans",
+                     __FUNCTION__, budget_ns, tried);
+            break;
+        }
+        tried++;
+
+        if (c.first < 0)
+        {
+            hd->mixMode = HWC_DEFAULT;
+            bAllMatch = match_process(drm, crtc, hd->is_interlaced, layers, iPlaneSize, fbSize, composition_planes);
+        }
+        else
+        {
+            if (c.first == 0)
+                hd->mixMode = HWC_MIX_DOWN;
+            else if (c.last == n - 1)
+                hd->mixMode = HWC_MIX_UP;
+            else
+                hd->mixMode = HWC_MIX_CROSS;
+            bAllMatch = try_mix_policy(drm, crtc, hd->is_interlaced, layers, tmp_layers, iPlaneSize,
+                                       composition_planes, c.first, c.last, fbSize);
+        }
+
+        if (bAllMatch && (hd->isHdr || hwc_vop_bw_admit(hd, layers)))
+        {
+            stat->search_tried += tried;
+            ALOGD_IF(log_level(DBG_DEBUG), "%s: plan (%d,%d) cost=%f, %d of %zu plans tried",
+                     __FUNCTION__, c.first, c.last, c.cost, tried, candidates.size());
+            return true;
+        }
+
+        if (c.first >= 0)
+            resore_tmp_layers_except_fb(layers, tmp_layers);
+    }
+
+    stat->search_tried += tried;
+    ALOGD_IF(log_level(DBG_DEBUG), "%s:line=%d no feasible plan in %zu",__FUNCTION__,__LINE__,candidates.size());
+    resore_all_tmp_layers(layers, tmp_layers);
+    hd->mixMode = HWC_DEFAULT;
+
+    return false;
+}
+
+/*
+ * The allocator PROPERTY_TYPE.hwc.plane_allocator selects: 1 is the cost
+ * based search, 0 the cascade of mix policies.
+ */
+static bool plane_policy(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
+                std::vector<DrmCompositionPlane>& composition_planes)
+{
+    if (hwc_config()->plane_allocator)
+        return cost_policy(drm, crtc, hd, layers, iPlaneSize, fbSize, composition_planes);
+
+    return mix_policy(drm, crtc, hd, layers, iPlaneSize, fbSize, composition_planes);
+}
+
+static inline void plan_push_float(std::vector<uint32_t>& fp, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    fp.push_back(bits);
+}
+
+/*
+ * Everything the plane policies decide on: the display state, the plane groups
+ * and, per layer, the handle format, crop, frame, transform, blending and
+ * alpha with the flags derived from them.
+ */
+static void plan_fingerprint(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
+                std::vector<uint32_t>& fp)
+{
+    std::vector<PlaneGroup *>& plane_groups = drm->GetPlaneGroups();
+
+    fp.clear();
+    fp.push_back(drm->timeline());
+    fp.push_back(crtc->id());
+    fp.push_back(iPlaneSize);
+    fp.push_back(fbSize);
+    fp.push_back(hd->rel_xres);
+    fp.push_back(hd->rel_yres);
+    fp.push_back(hd->v_total);
+    fp.push_back(hd->vrefresh);
+    fp.push_back(hd->framebuffer_height);
+    fp.push_back(hd->is_3d | hd->is_interlaced << 1 | hd->isVideo << 2 |
+                 hd->isHdr << 3 | hd->bPreferMixDown << 4);
+    fp.push_back(hd->stereo_mode);
+    fp.push_back(hwc_config()->plane_allocator);
+    fp.push_back(hwc_config()->vop_bw_max);
+#ifdef USE_PLANE_RESERVED
+    fp.push_back(hwc_config()->win1_reserved);
+    fp.push_back(hwc_config()->win1_zpos);
+#endif
+
+    for (std::vector<PlaneGroup *> ::const_iterator iter = plane_groups.begin();
+       iter != plane_groups.end(); ++iter) {
+        fp.push_back((*iter)->possible_crtcs);
+        fp.push_back((*iter)->b_reserved);
+    }
+
+    for (size_t i = 0; i < layers.size(); ++i) {
+        DrmHwcLayer& layer = layers[i];
+        uint32_t same_handle = 0;
+
+        //combine_layer() keeps the layers of one handle apart
+        for (size_t j = 0; j < i; ++j) {
+            if (layers[j].sf_handle == layer.sf_handle) {
+                same_handle = j + 1;
+                break;
+            }
+        }
+
+        fp.push_back(layer.index);
+        fp.push_back(layer.raw_sf_layer->compositionType);
+        fp.push_back(layer.format);
+        plan_push_float(fp, layer.source_crop.left);
+        plan_push_float(fp, layer.source_crop.top);
+        plan_push_float(fp, layer.source_crop.right);
+        plan_push_float(fp, layer.source_crop.bottom);
+        fp.push_back(layer.display_frame.left);
+        fp.push_back(layer.display_frame.top);
+        fp.push_back(layer.display_frame.right);
+        fp.push_back(layer.display_frame.bottom);
+        plan_push_float(fp, layer.h_scale_mul);
+        plan_push_float(fp, layer.v_scale_mul);
+        fp.push_back(layer.transform);
+        fp.push_back((uint32_t)layer.blending);
+        fp.push_back(layer.alpha);
+        fp.push_back(layer.eotf);
+        fp.push_back(layer.stereo);
+        fp.push_back(same_handle);
+        fp.push_back(layer.bSkipLayer | layer.bClone_ << 1 | layer.bUse << 2 |
+                     layer.is_yuv << 3 | layer.is_scale << 4);
+#if USE_AFBC_LAYER
+        fp.push_back(layer.is_afbc);
+#endif
+#if RK_VIDEO_SKIP_LINE
+        fp.push_back(layer.SkipLine);
+#endif
+    }
+}
+
+static void plan_record(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, std::vector<hwc_layer_1_t *>& sf_layers,
+                std::vector<DrmCompositionPlane>& composition_planes, bool bAllMatch)
+{
+    hwc_plan_cache_t *cache = &hd->plan_cache;
+    std::vector<PlaneGroup *>& plane_groups = drm->GetPlaneGroups();
+
+    cache->bAllMatch = bAllMatch;
+    cache->mixMode = hd->mixMode;
+    cache->kept.clear();
+    cache->composition_types.clear();
+    cache->planes.clear();
+    cache->group_use.clear();
+    cache->plane_use.clear();
+
+    for (size_t i = 0; i < sf_layers.size(); ++i)
+        cache->composition_types.push_back(sf_layers[i]->compositionType);
+
+    for (size_t i = 0; i < layers.size(); ++i) {
+        hwc_plan_layer_t layer;
+
+        layer.index = layers[i].index;
+        layer.zpos = layers[i].zpos;
+        layer.is_match = layers[i].is_match;
+        layer.bMix = layers[i].bMix;
+        cache->kept.push_back(layer);
+    }
+
+    for (size_t i = 0; i < composition_planes.size(); ++i) {
+        DrmCompositionPlane& comp_plane = composition_planes[i];
+        hwc_plan_plane_t plane;
+
+        plane.type = comp_plane.type();
+        plane.plane = comp_plane.plane();
+        plane.source_layers = comp_plane.source_layers();
+        plane.zpos = comp_plane.get_zpos();
+        cache->planes.push_back(plane);
+    }
+
+    for (std::vector<PlaneGroup *> ::const_iterator iter = plane_groups.begin();
+       iter != plane_groups.end(); ++iter) {
+        cache->group_use.push_back((*iter)->bUse);
+        for(std::vector<DrmPlane *> ::const_iterator iter_plane=(*iter)->planes.begin();
+            iter_plane != (*iter)->planes.end(); ++iter_plane) {
+            if((*iter_plane)->GetCrtcSupported(*crtc))
+                cache->plane_use.push_back((*iter_plane)->is_use());
+        }
+    }
+
+    cache->valid = true;
+}
+
+static bool plan_replay(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, std::vector<hwc_layer_1_t *>& sf_layers,
+                std::vector<DrmCompositionPlane>& composition_planes)
+{
+    hwc_plan_cache_t *cache = &hd->plan_cache;
+    std::vector<PlaneGroup *>& plane_groups = drm->GetPlaneGroups();
+    size_t group = 0, plane = 0;
+
+    hd->mixMode = cache->mixMode;
+    for (size_t i = 0; i < sf_layers.size(); ++i)
+        sf_layers[i]->compositionType = cache->composition_types[i];
+
+    //drop the layers gone to the fb target, in the order the policy left
+    std::vector<DrmHwcLayer> kept_layers;
+    kept_layers.reserve(cache->kept.size());
+    for (size_t i = 0; i < cache->kept.size(); ++i) {
+        hwc_plan_layer_t& kept = cache->kept[i];
+
+        for (auto k = layers.begin(); k != layers.end(); ++k) {
+            if ((*k).index == kept.index) {
+                (*k).zpos = kept.zpos;
+                (*k).is_match = kept.is_match;
+                (*k).bMix = kept.bMix;
+                kept_layers.emplace_back(std::move(*k));
+                layers.erase(k);
+                break;
+            }
+        }
+    }
+    layers.swap(kept_layers);
+
+    composition_planes.clear();
+    for (size_t i = 0; i < cache->planes.size(); ++i) {
+        hwc_plan_plane_t& p = cache->planes[i];
+
+        composition_planes.emplace_back(p.type, p.plane, crtc);
+        composition_planes.back().source_layers() = p.source_layers;
+        composition_planes.back().set_zpos(p.zpos);
+    }
+
+    for (std::vector<PlaneGroup *> ::const_iterator iter = plane_groups.begin();
+       iter != plane_groups.end(); ++iter, ++group) {
+        (*iter)->bUse = cache->group_use[group];
+        for(std::vector<DrmPlane *> ::const_iterator iter_plane=(*iter)->planes.begin();
+            iter_plane != (*iter)->planes.end(); ++iter_plane) {
+            if((*iter_plane)->GetCrtcSupported(*crtc))
+                (*iter_plane)->set_use(cache->plane_use[plane++]);
+        }
+    }
+
+    return cache->bAllMatch;
+}
+
+/*
+ * plane_policy() with the plane assignment of the previous frame reused when
+ * the layer stack has not changed, as with video playback or a static UI.
+ */
+bool mix_policy_cached(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
+                std::vector<DrmCompositionPlane>& composition_planes)
+{
+    hwc_plan_cache_t *cache = &hd->plan_cache;
+    std::vector<hwc_layer_1_t *> sf_layers;
+    std::vector<uint32_t> fp;
+    bool bAllMatch;
+
+    if(!crtc)
+    {
+        ALOGE("%s:line=%d crtc is null",__FUNCTION__,__LINE__);
+        return false;
+    }
+
+    if (!hwc_config()->plan_cache)
+    {
+        hwc_plan_cache_invalidate(hd);
+        return plane_policy(drm, crtc, hd, layers, iPlaneSize, fbSize, composition_planes);
+    }
+
+    for (size_t i = 0; i < layers.size(); ++i)
+        sf_layers.push_back(layers[i].raw_sf_layer);
+
+    plan_fingerprint(drm, crtc, hd, layers, iPlaneSize, fbSize, fp);
+    if (cache->valid && cache->fingerprint == fp)
+    {
+        cache->hits++;
+        ALOGD_IF(log_level(DBG_DEBUG), "%s: reuse the plan of the last frame, mixMode=%d",
+                 __FUNCTION__, cache->mixMode);
+        return plan_replay(drm, crtc, hd, layers, sf_layers, composition_planes);
+    }
+
+    cache->misses++;
+    cache->expired = false;
+    bAllMatch = plane_policy(drm, crtc, hd, layers, iPlaneSize, fbSize, composition_planes);
+
+    //the fallback of a search cut short is not kept, the next frame searches again
+    if (cache->expired)
+        return bAllMatch;
+
+    cache->fingerprint.swap(fp);
+    plan_record(drm, crtc, hd, layers, sf_layers, composition_planes, bAllMatch);
+
+    return bAllMatch;
+}
+
+void hwc_plan_cache_invalidate(hwc_drm_display_t *hd)
+{
+    if (hd->plan_cache.valid)
+        hd->plan_cache.invalidations++;
+    hd->plan_cache.valid = false;
+}
+
+void hwc_plan_cache_dump(int display, hwc_drm_display_t *hd, std::ostringstream *out)
+{
+    hwc_plan_cache_t *cache = &hd->plan_cache;
+    uint64_t total = cache->hits + cache->misses;
+
+    *out << "--PlanCache display=" << display << ": hits=" << cache->hits
+         << " misses=" << cache->misses << " invalidations=" << cache->invalidations
+         << " hit rate=" << (total ? cache->hits * 100 / total : 0) << "%\n"
+         << "    searches=" << cache->searches << " plans tried=" << cache->search_tried
+         << " budget expired=" << cache->search_expired << "\n";
+}
+
 #if RK_VIDEO_UI_OPT
 void video_ui_optimize(const gralloc_module_t *gralloc, hwc_display_contents_1_t *display_content, hwc_drm_display_t *hd)
 {
@@ -2686,6 +3261,24 @@ bool hwc_have_baseparameter(void)
 }
 
 
+/*
+ * The "overscan l,t,r,b" of a display, from the snapshot of
+ * persist.PROPERTY_TYPE.overscan.main/aux or else the baseparameter.
+ * overscan holds PROPERTY_VALUE_MAX bytes.
+ */
+void hwc_get_overscan(int display, char *overscan)
+{
+    const hwc_config_t *config = hwc_config();
+    const char *value = display == HWC_DISPLAY_PRIMARY ? config->overscan_main : config->overscan_aux;
+
+    if (!value[0])
+        value = hwc_have_baseparameter() ? "use_baseparameter" : "overscan 100,100,100,100";
+    snprintf(overscan, PROPERTY_VALUE_MAX, "%s", value);
+
+    if (hwc_have_baseparameter() && !strcmp(overscan, "use_baseparameter"))
+        hwc_get_baseparameter_config(overscan, display, BP_OVERSCAN, 0);
+}
+
 int hwc_get_baseparameter_config(char *parameter, int display, int flag, int type)
 {
     unsigned int w=0,h=0,hsync_start=0,hsync_end=0,htotal=0;
@@ -43,6 +43,7 @@
 #include "drmresources.h"
 #include "vsyncworker.h"
 #include "drmframebuffer.h"
+#include "hwc_vop_bw.h"
 #include <fcntl.h>
 
 /*
@@ -200,6 +201,44 @@ typedef struct _threadPamaters
 }threadPamaters;
 #endif
 
+/*
+ * Plane assignment made for the last layer stack of a display.
+ * mix_policy_cached() replays it while the stack keeps the same fingerprint,
+ * i.e. the same formats, crops, frames, transforms and blendings.
+ */
+typedef struct hwc_plan_plane {
+  DrmCompositionPlane::Type type;
+  DrmPlane *plane;
+  std::vector<size_t> source_layers;
+  int zpos;
+} hwc_plan_plane_t;
+
+typedef struct hwc_plan_layer {
+  size_t index;
+  int zpos;
+  bool is_match;
+  bool bMix;
+} hwc_plan_layer_t;
+
+typedef struct hwc_plan_cache {
+  bool valid;
+  bool bAllMatch;
+  MixMode mixMode;
+  std::vector<uint32_t> fingerprint;
+  std::vector<hwc_plan_layer_t> kept;     //the layers left in the stack
+  std::vector<int32_t> composition_types; //of the sf layers, in stack order
+  std::vector<hwc_plan_plane_t> planes;
+  std::vector<bool> group_use;
+  std::vector<bool> plane_use;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t invalidations;
+  uint64_t searches;                      //of cost_policy()
+  uint64_t search_tried;
+  uint64_t search_expired;
+  bool expired;                           //the last search ran out of time
+} hwc_plan_cache_t;
+
 typedef struct hwc_drm_display {
   struct hwc_context_t *ctx;
   const gralloc_module_t *gralloc;
@@ -234,6 +273,7 @@ typedef struct hwc_drm_display {
   int display_timeline;
   int hotplug_timeline;
   bool bPreferMixDown;
+  hwc_plan_cache_t plan_cache;
 #if  RK_RGA_PREPARE_ASYNC
     int rgaBuffer_index;
     DrmRgaBuffer rgaBuffers[MaxRgaBuffers];
@@ -387,6 +427,7 @@ const char* hwc_get_baseparameter_file(void);
 
 bool hwc_have_baseparameter(void);
 int  hwc_get_baseparameter_config(char *parameter, int display, int flag, int type);
+void hwc_get_overscan(int display, char *overscan);
 void hwc_set_baseparameter_config(DrmResources *drm);
 void hwc_save_BcshConfig(int dpy);
 int  hwc_findSuitableInfoSlot(struct disp_info* info, int type);
@@ -432,6 +473,10 @@ int detect_3d_mode(hwc_drm_display_t *hd, hwc_display_contents_1_t *display_cont
 int hwc_control_3dmode(int fd_3d, int value, int flag);
 #endif
 float getPixelWidthByAndroidFormat(int format);
+void hwc_vop_bw_format(int format, float *bpp, float *chroma);
+void hwc_vop_bw_from_layer(const DrmHwcLayer& layer, hwc_vop_bw_plane_t *plane);
+uint64_t hwc_vop_bw_limit(hwc_drm_display_t *hd);
+bool hwc_vop_bw_admit(hwc_drm_display_t *hd, std::vector<DrmHwcLayer>& layers);
 #ifdef USE_HWC2
 int hwc_get_handle_displayStereo(const gralloc_module_t *gralloc, buffer_handle_t hnd);
 int hwc_set_handle_displayStereo(const gralloc_module_t *gralloc, buffer_handle_t hnd, int32_t displayStereo);
@@ -464,6 +509,14 @@ bool match_process(DrmResources* drm, DrmCrtc *crtc, bool is_interlaced,
 bool mix_policy(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
                 std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
                 std::vector<DrmCompositionPlane>& composition_planes);
+bool cost_policy(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
+                std::vector<DrmCompositionPlane>& composition_planes);
+bool mix_policy_cached(DrmResources* drm, DrmCrtc *crtc, hwc_drm_display_t *hd,
+                std::vector<DrmHwcLayer>& layers, int iPlaneSize, int fbSize,
+                std::vector<DrmCompositionPlane>& composition_planes);
+void hwc_plan_cache_invalidate(hwc_drm_display_t *hd);
+void hwc_plan_cache_dump(int display, hwc_drm_display_t *hd, std::ostringstream *out);
 #if RK_VIDEO_UI_OPT
 void video_ui_optimize(const gralloc_module_t *gralloc, hwc_display_contents_1_t *display_content, hwc_drm_display_t *hd);
 #endif
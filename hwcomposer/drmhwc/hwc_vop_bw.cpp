@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 Fuzhou Rockchip Electronics Co.Ltd.
+ *
+ * Modification based on code covered by the Apache License, Version 2.0 (the "License").
+ * You may not use this software except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS TO YOU ON AN "AS IS" BASIS
+ * AND ANY AND ALL WARRANTIES AND REPRESENTATIONS WITH RESPECT TO SUCH SOFTWARE, WHETHER EXPRESS,
+ * IMPLIED, STATUTORY OR OTHERWISE, INCLUDING WITHOUT LIMITATION, ANY IMPLIED WARRANTIES OF TITLE,
+ * NON-INFRINGEMENT, MERCHANTABILITY, SATISFACTROY QUALITY, ACCURACY OR FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hwc_vop_bw.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace android {
+
+double hwc_vop_bw_frame_bytes(const hwc_vop_bw_plane_t *plane)
+{
+    double pixels = (double)plane->src_w * plane->src_h;
+    double bytes = pixels * plane->bpp * (1.0 + plane->chroma);
+
+    if (plane->afbc)
+        bytes = bytes * HWC_VOP_BW_AFBC_RATIO + pixels * HWC_VOP_BW_AFBC_HEADER;
+
+    return bytes;
+}
+
+double hwc_vop_bw_frame_bytes_max(const hwc_vop_bw_plane_t *plane)
+{
+    double pixels = (double)plane->src_w * plane->src_h;
+    double bytes = pixels * plane->bpp * (1.0 + plane->chroma);
+
+    if (plane->afbc)
+        bytes += pixels * HWC_VOP_BW_AFBC_HEADER;
+
+    return bytes;
+}
+
+/* seconds of a line of the frame, the vop scans v_display lines in v_total line times */
+static double hwc_vop_bw_line_time(const hwc_vop_bw_mode_t *mode)
+{
+    if (mode->vrefresh <= 0 || mode->v_total <= 0 || mode->v_display <= 0 || mode->frame_h <= 0)
+        return 0;
+
+    return (double)mode->v_display / mode->frame_h / ((double)mode->vrefresh * mode->v_total);
+}
+
+uint64_t hwc_vop_bw_average(const hwc_vop_bw_plane_t *planes, int count,
+                            const hwc_vop_bw_mode_t *mode)
+{
+    double line_time = hwc_vop_bw_line_time(mode);
+    double bytes = 0;
+
+    if (line_time <= 0)
+        return 0;
+
+    for (int i = 0; i < count; i++)
+        bytes += hwc_vop_bw_frame_bytes(&planes[i]);
+
+    return (uint64_t)(bytes / (line_time * mode->frame_h));
+}
+
+uint64_t hwc_vop_bw_peak(const hwc_vop_bw_plane_t *planes, int count,
+                         const hwc_vop_bw_mode_t *mode)
+{
+    double line_time = hwc_vop_bw_line_time(mode);
+    std::vector<std::pair<int, double> > edges;
+    double rate = 0, peak = 0;
+
+    if (line_time <= 0)
+        return 0;
+
+    for (int i = 0; i < count; i++) {
+        const hwc_vop_bw_plane_t *plane = &planes[i];
+        int top = std::max(plane->dst_top, 0);
+        int bottom = std::min(plane->dst_top + plane->dst_h, mode->frame_h);
+
+        if (bottom <= top)
+            continue;
+
+        /* a down scaled plane fetches more than a source line per line */
+        double plane_rate = hwc_vop_bw_frame_bytes_max(plane) / (plane->dst_h * line_time);
+
+        edges.push_back(std::make_pair(top, plane_rate));
+        edges.push_back(std::make_pair(bottom, -plane_rate));
+    }
+
+    /* at a line, the plane that ends there goes before the one that starts */
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); i++) {
+        rate += edges[i].second;
+        if (i + 1 == edges.size() || edges[i + 1].first != edges[i].first)
+            peak = std::max(peak, rate);
+    }
+
+    return (uint64_t)peak;
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 Fuzhou Rockchip Electronics Co.Ltd.
+ *
+ * Modification based on code covered by the Apache License, Version 2.0 (the "License").
+ * You may not use this software except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS TO YOU ON AN "AS IS" BASIS
+ * AND ANY AND ALL WARRANTIES AND REPRESENTATIONS WITH RESPECT TO SUCH SOFTWARE, WHETHER EXPRESS,
+ * IMPLIED, STATUTORY OR OTHERWISE, INCLUDING WITHOUT LIMITATION, ANY IMPLIED WARRANTIES OF TITLE,
+ * NON-INFRINGEMENT, MERCHANTABILITY, SATISFACTROY QUALITY, ACCURACY OR FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HWC_VOP_BW_H_
+#define _HWC_VOP_BW_H_
+
+#include <stdint.h>
+
+namespace android {
+
+/*
+ * Bandwidth model of the vop.
+ *
+ * The vop fetches the source of every plane while the lines the plane covers
+ * are scanned out, so a plane needs its bytes of a frame in dst_h lines of
+ * the mode, and the planes that share a line are fetched together. The dmc
+ * has to provide the average over the active lines, the busiest line tells
+ * if the vop would underflow.
+ *
+ * AFBC only saves what the content compresses, incompressible content fetches
+ * the whole payload plus the header. The average takes the typical ratio, the
+ * peak takes the whole payload so a plan it admits cannot underflow.
+ */
+
+/* AFBC payload against the uncompressed source, typical of UI content, average only */
+#define HWC_VOP_BW_AFBC_RATIO       0.6
+/* AFBC header: 16 bytes per 16x16 superblock */
+#define HWC_VOP_BW_AFBC_HEADER      (16.0 / 256.0)
+
+typedef struct hwc_vop_bw_mode {
+    int v_display;      /* active lines of the mode */
+    int v_total;
+    float vrefresh;
+    int frame_h;        /* lines of the frame the planes are placed in */
+} hwc_vop_bw_mode_t;
+
+typedef struct hwc_vop_bw_plane {
+    float bpp;          /* bytes per pixel of the first plane, see getPixelWidthByAndroidFormat() */
+    float chroma;       /* chroma bytes per byte of the first plane: 0.5 for 4:2:0, 1.0 for 4:2:2 */
+    bool afbc;
+    int src_w;
+    int src_h;          /* lines fetched, after the skipline */
+    int dst_top;        /* in the lines of the frame */
+    int dst_h;
+} hwc_vop_bw_plane_t;
+
+/* bytes the vop fetches for a plane in a frame, typical of the content */
+double hwc_vop_bw_frame_bytes(const hwc_vop_bw_plane_t *plane);
+
+/* bytes the vop fetches for a plane in a frame, at most */
+double hwc_vop_bw_frame_bytes_max(const hwc_vop_bw_plane_t *plane);
+
+/* bytes/s over the active lines, what the dmc has to provide */
+uint64_t hwc_vop_bw_average(const hwc_vop_bw_plane_t *planes, int count,
+                            const hwc_vop_bw_mode_t *mode);
+
+/* bytes/s on the busiest line of the frame, at most */
+uint64_t hwc_vop_bw_peak(const hwc_vop_bw_plane_t *planes, int count,
+                         const hwc_vop_bw_mode_t *mode);
+
+}
+
+#endif
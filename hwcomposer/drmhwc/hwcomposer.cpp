@@ -82,6 +82,7 @@
 
 #include "hwc_util.h"
 #include "hwc_rockchip.h"
+#include "hwc_config.h"
 #include <android/configuration.h>
 #define UM_PER_INCH 25400
 
@@ -212,6 +213,8 @@ class DrmHotplugHandler : public DrmEventHandler {
       ALOGI("hwc_hotplug: %s event @%" PRIu64 " for connector %u type=%s, type_id=%d\n",
             cur_state == DRM_MODE_CONNECTED ? "Plug" : "Unplug", timestamp_us,
             conn->id(),drm_->connector_type_str(conn->get_type()),conn->type_id());
+      for (DisplayMap::iterator iter = displays_->begin(); iter != displays_->end(); ++iter)
+        hwc_plan_cache_invalidate(&iter->second);
       if (cur_state == DRM_MODE_CONNECTED) {
         /*
          * if connector is only one , only to use primary. by libin
@@ -520,7 +523,7 @@ static int update_display_bestmode(hwc_drm_display_t *hd, int display, DrmConnec
   static uint32_t last_mainType,last_auxType;
   uint32_t MaxResolution = 0,temp;
 
-  timeline = property_get_int32( PROPERTY_TYPE ".display.timeline", -1);
+  timeline = hwc_config()->display_timeline;
   /*
    * force update propetry when timeline is zero or not exist.
    */
@@ -947,16 +950,9 @@ int DrmHwcLayer::InitFromHwcLayer(struct hwc_context_t *ctx, int display, hwc_la
   hwc_drm_display_t *hd = &ctx->displays[conn->display()];
 
 #if DUAL_VIEW_MODE
-  int dualModeEnable = 0,dualModeTB = 0,dualModeRatioPri = 0,dualModeRatioAux = 0;
-  char value[PROPERTY_VALUE_MAX];
-  property_get("persist." PROPERTY_TYPE ".dualModeEnable", value, "0");
-  dualModeEnable = atoi(value);
-  property_get("persist." PROPERTY_TYPE ".dualModeTB", value, "0");
-  dualModeTB = atoi(value);
-  property_get("persist." PROPERTY_TYPE ".dualModeRatioPri", value, "0");
-  dualModeRatioPri = atoi(value);
-  property_get("persist." PROPERTY_TYPE ".dualModeRatioAux", value, "0");
-  dualModeRatioAux = atoi(value);
+  const hwc_config_t *config = hwc_config();
+  int dualModeEnable = config->dual_mode_enable,dualModeTB = config->dual_mode_tb;
+  int dualModeRatioPri = config->dual_mode_ratio_pri,dualModeRatioAux = config->dual_mode_ratio_aux;
 
   //DUAL_VIEW_MODE only support 2 or 3 Ratio
   if(dualModeRatioPri == 0 || dualModeRatioAux == 0){
@@ -965,18 +961,15 @@ int DrmHwcLayer::InitFromHwcLayer(struct hwc_context_t *ctx, int display, hwc_la
   }
 
   //DUAL_VIEW_MODE Primary framebuffer must equal to Extend
-  char framebuffer_size_pri[PROPERTY_VALUE_MAX] = {0};
-  char framebuffer_size_aux[PROPERTY_VALUE_MAX] = {0};
-  property_get("persist." PROPERTY_TYPE ".framebuffer.main", framebuffer_size_pri, "main");
-  property_get("persist." PROPERTY_TYPE ".framebuffer.aux", framebuffer_size_aux, "aux");
-  if(strcmp(framebuffer_size_pri,framebuffer_size_aux)){
+  if(strcmp(config->dual_framebuffer_main,config->dual_framebuffer_aux)){
     ALOGE_IF(log_level(DBG_ERROR),"DUAL:Primary framebuffer is not  equal to Extend, disable DUAL_VIEW_MODE");
     dualModeEnable = 0;
   }
 
   if(dualModeEnable == 1){
     hd->bDualViewMode = true;
-    property_set( PROPERTY_TYPE ".hwc.compose_policy","0");
+    if (config->compose_policy != 0)
+      property_set( PROPERTY_TYPE ".hwc.compose_policy","0");
     if(display == 0){
       if(dualModeTB == 1)
         source_crop = DrmHwcRect<float>(
@@ -1056,27 +1049,9 @@ int DrmHwcLayer::InitFromHwcLayer(struct hwc_context_t *ctx, int display, hwc_la
         }
         else
         {
-          if (display == HWC_DISPLAY_PRIMARY){
-            if(hwc_have_baseparameter()){
-              property_get("persist." PROPERTY_TYPE ".overscan.main", overscan, "use_baseparameter");
-              if(!strcmp(overscan,"use_baseparameter"))
-                hwc_get_baseparameter_config(overscan,display,BP_OVERSCAN,0);
-            }else{
-              property_get("persist." PROPERTY_TYPE ".overscan.main", overscan, "overscan 100,100,100,100");
-            }
-            sscanf(overscan, "overscan %d,%d,%d,%d", &left_margin, &top_margin,
-                              &right_margin, &bottom_margin);
-          }else{
-            if(hwc_have_baseparameter()){
-              property_get("persist." PROPERTY_TYPE ".overscan.aux", overscan, "use_baseparameter");
-              if(!strcmp(overscan,"use_baseparameter"))
-                hwc_get_baseparameter_config(overscan,display,BP_OVERSCAN,0);
-            }else{
-              property_get("persist." PROPERTY_TYPE ".overscan.aux", overscan, "overscan 100,100,100,100");
-            }
-           sscanf(overscan, "overscan %d,%d,%d,%d", &left_margin, &top_margin,
-                    &right_margin, &bottom_margin);
-          }
+          hwc_get_overscan(display, overscan);
+          sscanf(overscan, "overscan %d,%d,%d,%d", &left_margin, &top_margin,
+                 &right_margin, &bottom_margin);
         }
 
         //limit overscan to (OVERSCAN_MIN_VALUE,OVERSCAN_MAX_VALUE)
@@ -1239,10 +1214,7 @@ int DrmHwcLayer::InitFromHwcLayer(struct hwc_context_t *ctx, int display, hwc_la
 
 #if RK_BOX
     if(is_yuv){
-      char value_yuv[PROPERTY_VALUE_MAX];
-      int scaleMode = 0;
-      property_get("persist." PROPERTY_TYPE ".video.cvrs",value_yuv, "0");
-      scaleMode = atoi(value_yuv);
+      int scaleMode = hwc_config()->video_cvrs;
       if(scaleMode > 0){
           ret = hwc_video_to_area(source_crop,display_frame,scaleMode);
           if(ret == false)
@@ -1278,7 +1250,7 @@ int DrmHwcLayer::InitFromHwcLayer(struct hwc_context_t *ctx, int display, hwc_la
             SkipLine = 3;
         }
       }
-      int video_skipline = property_get_int32("vendor.video.skipline", 0);
+      int video_skipline = hwc_config()->video_skipline;
       if (video_skipline == 2){
         SkipLine = 2;
       }else if(video_skipline == 3){
@@ -1416,11 +1388,7 @@ int DrmHwcLayer::InitFromHwcLayer(struct hwc_context_t *ctx, int display, hwc_la
         // if(iFbdcSupport == -1)
         if(iFbdcSupport <= 0)
         {
-            char fbdc_value[PROPERTY_VALUE_MAX];
-            int ret = property_get( PROPERTY_TYPE ".gmali.fbdc_target", fbdc_value, "0");
-            ALOGV("ret = %d",ret);
-
-            iFbdcSupport = atoi(fbdc_value);
+            iFbdcSupport = hwc_config()->fbdc_target;
             if(iFbdcSupport > 0 && display == 0)
             {
                 ALOGD_IF(log_level(DBG_VERBOSE),"to set 'is_afbc'.");
@@ -1473,7 +1441,13 @@ static void hwc_dump(struct hwc_composer_device_1 *dev, char *buff,
   struct hwc_context_t *ctx = (struct hwc_context_t *)&dev->common;
   std::ostringstream out;
 
+  hwc_config_refresh(true);
   ctx->drm.compositor()->Dump(&out);
+  hwc_config_dump(&out);
+  for (DisplayMap::iterator iter = ctx->displays.begin(); iter != ctx->displays.end(); ++iter)
+    hwc_plan_cache_dump(iter->first, &iter->second, &out);
+  if (ctx->importer)
+    ctx->importer->Dump(&out);
   std::string out_str = out.str();
   strncpy(buff, out_str.c_str(),
           std::min((size_t)buff_len, out_str.length() + 1));
@@ -1507,14 +1481,14 @@ static bool is_use_gles_comp(struct hwc_context_t *ctx, DrmConnector *connector,
         =2: DISPLAY_EXTERNAL go into overlay,DISPLAY_PRIMARY go into GPU.
         others: DISPLAY_PRIMARY & DISPLAY_EXTERNAL both go into overlay.
     */
-    int iMode = hwc_get_int_property( PROPERTY_TYPE ".hwc.compose_policy","0");
+    int iMode = hwc_config()->compose_policy;
     if( iMode <= 0 || (iMode == 1 && display_id == 2) || (iMode == 2 && display_id == 1) )
     {
         ALOGD_IF(log_level(DBG_DEBUG), PROPERTY_TYPE ".hwc.compose_policy=%d,go to GPU GLES at line=%d", iMode, __LINE__);
         return true;
     }
 
-    iMode = hwc_get_int_property( PROPERTY_TYPE ".hwc","1");
+    iMode = hwc_config()->hwc_enable;
     if( iMode <= 0 )
     {
         ALOGD_IF(log_level(DBG_DEBUG), PROPERTY_TYPE ".hwc=%d,go to GPU GLES at line=%d", iMode, __LINE__);
@@ -1954,16 +1928,9 @@ static bool is_use_gles_comp(struct hwc_context_t *ctx, DrmConnector *connector,
     return false;
 }
 
-static HDMI_STAT DetectStatus(const char* property)
+static HDMI_STAT DetectStatus(int status_on)
 {
-    char status[PROPERTY_VALUE_MAX];
-
-    property_get(property, status, "on");
-    ALOGD_IF(log_level(DBG_VERBOSE),"get %s is %s", property, status);
-    if(!strcmp(status, "off"))
-        return HDMI_OFF;
-    else
-        return HDMI_ON;
+    return status_on ? HDMI_ON : HDMI_OFF;
 }
 
 /*
@@ -1977,7 +1944,7 @@ static void DetectAuxStatus(const hwc_context_t *ctx)
   static HDMI_STAT last_dp_status = HDMI_ON;
   char acStatus[10];
   int ret = 0;
-  HDMI_STAT hdmi_status = DetectStatus( PROPERTY_TYPE ".hdmi_status.aux");
+  HDMI_STAT hdmi_status = DetectStatus(hwc_config()->hdmi_status_aux);
   if(ctx->hdmi_status_fd > 0 && hdmi_status != last_hdmi_status)
   {
       if(hdmi_status == HDMI_ON)
@@ -1993,7 +1960,7 @@ static void DetectAuxStatus(const hwc_context_t *ctx)
       ALOGD_IF(log_level(DBG_VERBOSE),"set hdmi status to %s",acStatus);
   }
 
-  HDMI_STAT dp_status = DetectStatus( PROPERTY_TYPE ".dp_status.aux");
+  HDMI_STAT dp_status = DetectStatus(hwc_config()->dp_status_aux);
   if(ctx->dp_status_fd > 0 && dp_status != last_dp_status)
   {
       if(dp_status == HDMI_ON)
@@ -2080,7 +2047,7 @@ static bool update_hdmi_output_format(struct hwc_context_t *ctx, DrmConnector *c
     int need_change_depth = 0;
     char prop_format[PROPERTY_VALUE_MAX];
     static uint32_t last_mainType,last_auxType;
-    timeline = property_get_int32( PROPERTY_TYPE ".display.timeline", -1);
+    timeline = hwc_config()->display_timeline;
     drmModeAtomicReqPtr pset = NULL;
     /*
     * force update propetry when timeline is zero or not exist.
@@ -2511,8 +2478,11 @@ static int hwc_prepare(hwc_composer_device_1_t *dev, size_t num_displays,
   struct hwc_context_t *ctx = (struct hwc_context_t *)&dev->common;
   int ret = -1;
 
+  // the properties of the frame
+  hwc_config_refresh(false);
+
 #ifdef USE_PLANE_RESERVED
-  int win1_reserved = hwc_get_int_property( PROPERTY_TYPE ".hwc.win1.reserved", "0");
+  int win1_reserved = hwc_config()->win1_reserved;
 #endif
 
 #ifdef USE_HWC2
@@ -2601,10 +2571,12 @@ static int hwc_prepare(hwc_composer_device_1_t *dev, size_t num_displays,
     {
         int timeline = 0;
         char acTimelie[10];
-        timeline = property_get_int32( PROPERTY_TYPE ".display.timeline", -1);
+        timeline = hwc_config()->display_timeline;
         timeline++;
         snprintf(acTimelie,10,"%d",timeline);
         property_set( PROPERTY_TYPE ".display.timeline", acTimelie);
+        //the modes below are updated on this frame, not on the next one
+        hwc_config_refresh(false);
     }
 #endif
 
@@ -3049,7 +3021,7 @@ static int hwc_prepare(hwc_composer_device_1_t *dev, size_t num_displays,
         hd->mixMode = HWC_DEFAULT;
         if(crtc && layer_content.layers.size()>0)
         {
-            bAllMatch = mix_policy(&ctx->drm, crtc, &ctx->displays[connector->display()],layer_content.layers,
+            bAllMatch = mix_policy_cached(&ctx->drm, crtc, &ctx->displays[connector->display()],layer_content.layers,
                                     hd->iPlaneSize, fbSize, comp_plane.composition_planes);
         }
         if(!bAllMatch)
@@ -3369,9 +3341,7 @@ static int hwc_set(hwc_composer_device_1_t *dev, size_t num_displays,
         continue;
       }
 
-      char value[PROPERTY_VALUE_MAX];
-      property_get( PROPERTY_TYPE ".hwc.force_wait_acquireFence", value, "0");
-      if(atoi(value) != 0){
+      if(hwc_config()->force_wait_acquire_fence != 0){
           // rk: wait acquireFenceFd at hwc_set.
           if(sf_layer->acquireFenceFd > 0)
           {
@@ -4110,6 +4080,7 @@ static int hwc_set_active_config(struct hwc_composer_device_1 *dev, int display,
   hd->h_scale = (float)mode.v_display() / hd->framebuffer_height;
 
   c->set_current_mode(mode);
+  hwc_plan_cache_invalidate(hd);
   ctx->drm.UpdateDisplayRoute();
 
   return 0;
@@ -4188,6 +4159,8 @@ static int hwc_initialize_display(struct hwc_context_t *ctx, int display) {
     hd->is_3d = false;
     hd->hasEotfPlane = false;
     hd->bPreferMixDown = false;
+    hd->plan_cache.valid = false;
+    hd->plan_cache.expired = false;
 
 #if RK_RGA_PREPARE_ASYNC
     hd->rgaBuffer_index = 0;
@@ -4323,6 +4296,7 @@ static int hwc_device_open(const struct hw_module_t *module, const char *name,
     return -EINVAL;
   }
 
+  hwc_config_init();
   init_rk_debug();
   hwc_get_baseparameter_config(NULL,0,BP_UPDATE,0);
 
@@ -44,6 +44,7 @@
 #include <hardware/hwcomposer.h>
 
 #include <map>
+#include <sstream>
 #include <vector>
 
 namespace android {
@@ -74,6 +75,17 @@ class Importer {
   //       implementation is responsible for ensuring thread safety.
   virtual int ReleaseBuffer(hwc_drm_bo_t *bo) = 0;
   virtual void SetFlag(DrmGenericImporterFlag_t flag) = 0;
+
+  // Drops the buffers the importer keeps that are no longer used. Called by
+  // the compositor thread after each commit and while the screen is static,
+  // when no ImportBuffer/ReleaseBuffer comes to do it.
+  virtual void EvictIdle() {
+  }
+
+  // Appends the state of the importer to the hwc dump
+  virtual void Dump(std::ostringstream *out) const {
+    (void)out;
+  }
 };
 
 class Planner {
@@ -41,6 +41,10 @@
 #include "platformdrmgeneric.h"
 
 #include <drm_fourcc.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
@@ -80,10 +84,30 @@ Importer *Importer::CreateInstance(DrmResources *drm) {
 }
 #endif
 
+// Framebuffers of buffers not imported for that long are removed. gralloc
+// tells nothing when it frees a buffer and the fb keeps the memory alive, so
+// a freed buffer is dropped once it stops showing up.
+#define FB_CACHE_IDLE_NS        (1000LL * 1000 * 1000)
+// Unreferenced framebuffers kept at most
+#define FB_CACHE_MAX_IDLE       64
+
+static int64_t fb_cache_now_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
 DrmGenericImporter::DrmGenericImporter(DrmResources *drm) : drm_(drm) {
+  pthread_mutex_init(&fb_cache_lock_, NULL);
 }
 
 DrmGenericImporter::~DrmGenericImporter() {
+  pthread_mutex_lock(&fb_cache_lock_);
+  while (!fb_cache_.empty())
+    FbCacheRemove(fb_cache_.begin());
+  pthread_mutex_unlock(&fb_cache_lock_);
+  pthread_mutex_destroy(&fb_cache_lock_);
 }
 
 int DrmGenericImporter::Init() {
@@ -99,6 +123,7 @@ int DrmGenericImporter::Init() {
   }
 #endif  // USE_GRALLOC_4
   flag_ = NO_FLAG;
+  fb_cache_enabled_ = hwc_get_int_property(PROPERTY_TYPE ".hwc.fb_cache", "1") > 0;
   return 0;
 }
 void DrmGenericImporter::SetFlag(DrmGenericImporterFlag_t flag){
@@ -139,6 +164,67 @@ uint32_t DrmGenericImporter::ConvertHalFormatToDrm(uint32_t hal_format) {
   }
 }
 
+bool DrmGenericImporter::FbCacheSameLayout(const FbCacheEntry &entry, const hwc_drm_bo_t *bo,
+                                           uint64_t modifier) const {
+  return entry.bo.width == bo->width && entry.bo.height == bo->height &&
+         entry.bo.format == bo->format && entry.modifier == modifier &&
+         !memcmp(entry.bo.pitches, bo->pitches, sizeof(bo->pitches)) &&
+         !memcmp(entry.bo.offsets, bo->offsets, sizeof(bo->offsets));
+}
+
+void DrmGenericImporter::CloseGemHandle(uint32_t gem_handle) {
+  struct drm_gem_close gem_close;
+
+  memset(&gem_close, 0, sizeof(gem_close));
+  gem_close.handle = gem_handle;
+  int ret = drmIoctl(drm_->fd(), DRM_IOCTL_GEM_CLOSE, &gem_close);
+  if (ret)
+    ALOGE("Failed to close gem handle %u %d", gem_handle, ret);
+}
+
+void DrmGenericImporter::FbCacheRemove(std::map<uint32_t, FbCacheEntry>::iterator it) {
+  uint32_t gem_handle = it->second.gem_handle;
+
+  if (drmModeRmFB(drm_->fd(), it->first))
+    ALOGE("Failed to rm fb");
+  fb_cache_.erase(it);
+
+  // the other layouts of the buffer share the handle
+  if (gem_handle) {
+    for (auto &e : fb_cache_)
+      if (e.second.gem_handle == gem_handle)
+        return;
+    CloseGemHandle(gem_handle);
+  }
+}
+
+void DrmGenericImporter::FbCacheEvict(int64_t now_ns) {
+  int idle = 0;
+
+  for (auto it = fb_cache_.begin(); it != fb_cache_.end();) {
+    if (it->second.refs == 0 && now_ns - it->second.last_use_ns > FB_CACHE_IDLE_NS) {
+      fb_cache_evictions_++;
+      FbCacheRemove(it++);
+    } else {
+      idle += it->second.refs == 0;
+      it++;
+    }
+  }
+
+  while (idle > FB_CACHE_MAX_IDLE) {
+    auto lru = fb_cache_.end();
+
+    for (auto it = fb_cache_.begin(); it != fb_cache_.end(); it++)
+      if (it->second.refs == 0 &&
+          (lru == fb_cache_.end() || it->second.last_use_ns < lru->second.last_use_ns))
+        lru = it;
+
+    fb_cache_evictions_++;
+    FbCacheRemove(lru);
+    idle--;
+  }
+}
+
 #ifndef u64
 #define u64 uint64_t
 #endif
@@ -161,12 +247,6 @@ int DrmGenericImporter::ImportBuffer(buffer_handle_t handle, hwc_drm_bo_t *bo
   byte_stride = hwc_get_handle_byte_stride(gralloc_,handle);
   format = hwc_get_handle_format(gralloc_,handle);
 #endif
-  uint32_t gem_handle;
-  int ret = drmPrimeFDToHandle(drm_->fd(), fd, &gem_handle);
-  if (ret) {
-    ALOGE("failed to import prime fd %d ret=%d", fd, ret);
-    return ret;
-  }
 
   memset(bo, 0, sizeof(hwc_drm_bo_t));
   if(format == HAL_PIXEL_FORMAT_YCrCb_NV12_10)
@@ -193,13 +273,11 @@ int DrmGenericImporter::ImportBuffer(buffer_handle_t handle, hwc_drm_bo_t *bo
   }
 
   bo->format = ConvertHalFormatToDrm(format);
-  bo->gem_handles[0] = gem_handle;
   bo->offsets[0] = 0;
 
   if(format == HAL_PIXEL_FORMAT_YCrCb_NV12 || format == HAL_PIXEL_FORMAT_YCrCb_NV12_10)
   {
     bo->pitches[1] = bo->pitches[0];
-    bo->gem_handles[1] = gem_handle;
     bo->offsets[1] = bo->pitches[1] * bo->height;
   }
 #if USE_AFBC_LAYER
@@ -227,7 +305,99 @@ int DrmGenericImporter::ImportBuffer(buffer_handle_t handle, hwc_drm_bo_t *bo
     modifier[0] = DRM_FORMAT_MOD_ARM_AFBC;
 #endif
   }
+  uint64_t layout_modifier = modifier[0];
+#else
+  uint64_t layout_modifier = 0;
+#endif
+
+  /*
+   * The framebuffer of a buffer is kept across frames, so that a layer
+   * showing the same buffers again costs no ioctl. The buffer is known by the
+   * inode of its dma-buf, or by its gem handle on the kernels where all the
+   * dma-bufs share one anon inode.
+   */
+  pthread_mutex_lock(&fb_cache_lock_);
+
+  struct stat st;
+  bool by_inode = false;
+  uint32_t gem_handle = 0;
+  int64_t now_ns = fb_cache_now_ns();
+  int ret;
+
+  // before the lookup, a handle found below must not be closed by it
+  if (fb_cache_enabled_)
+    FbCacheEvict(now_ns);
+
+  if (fb_cache_enabled_ && fb_cache_ino_unique_ < 0) {
+    char path[64], link[64];
+    ssize_t len;
+
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    len = readlink(path, link, sizeof(link) - 1);
+    if (len > 0) {
+      link[len] = '\0';
+      fb_cache_ino_unique_ = strncmp(link, "anon_inode:", strlen("anon_inode:")) != 0;
+      ALOGD_IF(log_level(DBG_DEBUG), "fb cache: dma-buf %s, keyed by %s", link,
+               fb_cache_ino_unique_ ? "inode" : "gem handle");
+    }
+  }
+  if (fb_cache_enabled_ && fb_cache_ino_unique_ > 0 && !fstat(fd, &st))
+    by_inode = true;
+
+  if (!by_inode) {
+    ret = drmPrimeFDToHandle(drm_->fd(), fd, &gem_handle);
+    if (ret) {
+      ALOGE("failed to import prime fd %d ret=%d", fd, ret);
+      pthread_mutex_unlock(&fb_cache_lock_);
+      return ret;
+    }
+  }
+
+  if (fb_cache_enabled_) {
+    bool handle_cached = false;
+
+    for (auto &e : fb_cache_) {
+      FbCacheEntry &entry = e.second;
+
+      if (by_inode ? (entry.dev != st.st_dev || entry.ino != st.st_ino)
+                   : entry.gem_handle != gem_handle)
+        continue;
+
+      handle_cached = true;
+      if (!FbCacheSameLayout(entry, bo, layout_modifier))
+        continue;
+
+      entry.refs++;
+      entry.last_use_ns = now_ns;
+      fb_cache_hits_++;
+      *bo = entry.bo;
+      pthread_mutex_unlock(&fb_cache_lock_);
+      return 0;
+    }
+    fb_cache_misses_++;
+
+    // the handle already belongs to the fb of another layout of the buffer
+    if (handle_cached && !by_inode) {
+      bo->gem_handles[0] = gem_handle;
+      gem_handle = 0;
+    }
+  }
 
+  if (by_inode) {
+    ret = drmPrimeFDToHandle(drm_->fd(), fd, &gem_handle);
+    if (ret) {
+      ALOGE("failed to import prime fd %d ret=%d", fd, ret);
+      pthread_mutex_unlock(&fb_cache_lock_);
+      return ret;
+    }
+  }
+
+  if (gem_handle)
+    bo->gem_handles[0] = gem_handle;
+  if(format == HAL_PIXEL_FORMAT_YCrCb_NV12 || format == HAL_PIXEL_FORMAT_YCrCb_NV12_10)
+    bo->gem_handles[1] = bo->gem_handles[0];
+
+#if USE_AFBC_LAYER
   ret = drmModeAddFB2_ext(drm_->fd(), bo->width, bo->height, bo->format,
                       bo->gem_handles, bo->pitches, bo->offsets, modifier,
 		      &bo->fb_id, DRM_MODE_FB_MODIFIERS);
@@ -238,66 +408,103 @@ int DrmGenericImporter::ImportBuffer(buffer_handle_t handle, hwc_drm_bo_t *bo
 
     ALOGD_IF(log_level(DBG_DEBUG), "ImportBuffer fd=%d,w=%d,h=%d,format=0x%x,bo->format=0x%x,gem_handle=%d,bo->pitches[0]=%d,fb_id=%d",
         drm_->fd(), bo->width, bo->height, format,bo->format,
-        gem_handle, bo->pitches[0], bo->fb_id);
+        bo->gem_handles[0], bo->pitches[0], bo->fb_id);
 
   if (ret) {
     ALOGE("could not create drm fb %d", ret);
     ALOGE("ImportBuffer fd=%d,w=%d,h=%d,format=0x%x,bo->format=0x%x,gem_handle=%d,bo->pitches[0]=%d,fb_id=%d",
         drm_->fd(), bo->width, bo->height, format,bo->format,
-        gem_handle, bo->pitches[0], bo->fb_id);
+        bo->gem_handles[0], bo->pitches[0], bo->fb_id);
 #if RK_VIDEO_SKIP_LINE
     ALOGE("SkipLine=%d",SkipLine);
 #endif
+    if (gem_handle)
+      CloseGemHandle(gem_handle);
+    pthread_mutex_unlock(&fb_cache_lock_);
     return ret;
   }
 
-  //Fix "Failed to close gem handle" bug which lead by no reference counting.
-#if 1
-    struct drm_gem_close gem_close;
-    int num_gem_handles;
-    memset(&gem_close, 0, sizeof(gem_close));
-    num_gem_handles = 1;
-
-    for (int i = 0; i < num_gem_handles; i++) {
-        if (!bo->gem_handles[i])
-            continue;
-
-        gem_close.handle = bo->gem_handles[i];
-        int ret = drmIoctl(drm_->fd(), DRM_IOCTL_GEM_CLOSE, &gem_close);
-        if (ret)
-            ALOGE("Failed to close gem handle %d %d", i, ret);
-        else
-            bo->gem_handles[i] = 0;
+  if (fb_cache_enabled_) {
+    FbCacheEntry entry;
+
+    memset(&entry, 0, sizeof(entry));
+    entry.refs = 1;
+    entry.last_use_ns = now_ns;
+    entry.modifier = layout_modifier;
+    if (by_inode) {
+      entry.dev = st.st_dev;
+      entry.ino = st.st_ino;
+    } else {
+      // the handle stays open to know the buffer again
+      entry.gem_handle = bo->gem_handles[0];
+      gem_handle = 0;
     }
-#endif
 
-  return ret;
+    // the fb holds the gem object, the handles are not handed out
+    memset(bo->gem_handles, 0, sizeof(bo->gem_handles));
+    entry.bo = *bo;
+    fb_cache_[bo->fb_id] = entry;
+  }
+
+  //Fix "Failed to close gem handle" bug which lead by no reference counting.
+  if (gem_handle)
+    CloseGemHandle(gem_handle);
+  memset(bo->gem_handles, 0, sizeof(bo->gem_handles));
+
+  pthread_mutex_unlock(&fb_cache_lock_);
+  return 0;
 }
 
 int DrmGenericImporter::ReleaseBuffer(hwc_drm_bo_t *bo) {
-  if (bo->fb_id)
-    if (drmModeRmFB(drm_->fd(), bo->fb_id))
-      ALOGE("Failed to rm fb");
-
-#if 0
-  struct drm_gem_close gem_close;
-  memset(&gem_close, 0, sizeof(gem_close));
-  int num_gem_handles = sizeof(bo->gem_handles) / sizeof(bo->gem_handles[0]);
-  for (int i = 0; i < num_gem_handles; i++) {
-    if (!bo->gem_handles[i])
-      continue;
-
-    gem_close.handle = bo->gem_handles[i];
-    int ret = drmIoctl(drm_->fd(), DRM_IOCTL_GEM_CLOSE, &gem_close);
-    if (ret)
-      ALOGE("Failed to close gem handle %d %d", i, ret);
-    else
-      bo->gem_handles[i] = 0;
+  if (!bo->fb_id)
+    return 0;
+
+  pthread_mutex_lock(&fb_cache_lock_);
+
+  auto it = fb_cache_.find(bo->fb_id);
+  if (it != fb_cache_.end()) {
+    int64_t now_ns = fb_cache_now_ns();
+
+    // kept for the next frames, and removed by FbCacheEvict() once idle
+    if (it->second.refs > 0)
+      it->second.refs--;
+    it->second.last_use_ns = now_ns;
+    FbCacheEvict(now_ns);
+  } else if (drmModeRmFB(drm_->fd(), bo->fb_id)) {
+    ALOGE("Failed to rm fb");
   }
-#endif
+
+  pthread_mutex_unlock(&fb_cache_lock_);
   return 0;
 }
 
+void DrmGenericImporter::EvictIdle() {
+  pthread_mutex_lock(&fb_cache_lock_);
+  if (fb_cache_enabled_)
+    FbCacheEvict(fb_cache_now_ns());
+  pthread_mutex_unlock(&fb_cache_lock_);
+}
+
+void DrmGenericImporter::Dump(std::ostringstream *out) const {
+  pthread_mutex_lock(&fb_cache_lock_);
+
+  uint64_t lookups = fb_cache_hits_ + fb_cache_misses_;
+  int in_use = 0;
+
+  for (auto &e : fb_cache_)
+    in_use += e.second.refs > 0;
+
+  *out << "--DrmGenericImporter: fb_cache=" << (fb_cache_enabled_ ? "on" : "off")
+       << " key=" << (fb_cache_ino_unique_ > 0 ? "inode" :
+                      fb_cache_ino_unique_ == 0 ? "gem_handle" : "unknown")
+       << " fbs=" << fb_cache_.size() << " in_use=" << in_use
+       << " hits=" << fb_cache_hits_ << " misses=" << fb_cache_misses_
+       << " hit_rate=" << (lookups ? fb_cache_hits_ * 100 / lookups : 0) << "%"
+       << " evictions=" << fb_cache_evictions_ << "\n";
+
+  pthread_mutex_unlock(&fb_cache_lock_);
+}
+
 #ifdef USE_DRM_GENERIC_IMPORTER
 std::unique_ptr<Planner> Planner::CreateInstance(DrmResources *) {
   std::unique_ptr<Planner> planner(new Planner);
@@ -41,6 +41,10 @@
 #include "platform.h"
 
 #include <hardware/gralloc.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <map>
 
 namespace android {
 
@@ -60,13 +64,43 @@ class DrmGenericImporter : public Importer {
 
   void SetFlag(DrmGenericImporterFlag_t flag) override;
 
+  void EvictIdle() override;
+
+  void Dump(std::ostringstream *out) const override;
+
  private:
+  // A framebuffer kept across frames, for a buffer and a layout of it
+  struct FbCacheEntry {
+    dev_t dev;              // dma-buf inode, 0 if the buffer is known by gem_handle
+    ino_t ino;
+    uint32_t gem_handle;    // held open while cached if the inodes are shared
+    hwc_drm_bo_t bo;
+    uint64_t modifier;
+    int refs;               // bos handed out and not released yet
+    int64_t last_use_ns;
+  };
+
   uint32_t ConvertHalFormatToDrm(uint32_t hal_format);
 
+  bool FbCacheSameLayout(const FbCacheEntry &entry, const hwc_drm_bo_t *bo,
+                         uint64_t modifier) const;
+  void FbCacheRemove(std::map<uint32_t, FbCacheEntry>::iterator it);
+  void FbCacheEvict(int64_t now_ns);
+  void CloseGemHandle(uint32_t gem_handle);
+
   DrmResources *drm_;
 
   const gralloc_module_t *gralloc_;
   DrmGenericImporterFlag_t flag_;
+
+  // framebuffers by fb_id
+  mutable pthread_mutex_t fb_cache_lock_;
+  std::map<uint32_t, FbCacheEntry> fb_cache_;
+  bool fb_cache_enabled_ = false;
+  int fb_cache_ino_unique_ = -1;  // -1 until the first dma-buf is looked at
+  uint64_t fb_cache_hits_ = 0;
+  uint64_t fb_cache_misses_ = 0;
+  uint64_t fb_cache_evictions_ = 0;
 };
 }
 
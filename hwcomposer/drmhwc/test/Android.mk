@@ -0,0 +1,22 @@
+LOCAL_PATH:= $(call my-dir)
+
+#
+# build the table of known configurations of the vop bandwidth model
+#
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := hwc_vop_bw_test
+
+LOCAL_SRC_FILES := \
+	vop_bw_test.cpp \
+	../hwc_vop_bw.cpp \
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/.. \
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_PROPRIETARY_MODULE := true
+
+include $(BUILD_EXECUTABLE)
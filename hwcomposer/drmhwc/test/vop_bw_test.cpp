@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2018 Fuzhou Rockchip Electronics Co.Ltd.
+ *
+ * Modification based on code covered by the Apache License, Version 2.0 (the "License").
+ * You may not use this software except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS TO YOU ON AN "AS IS" BASIS
+ * AND ANY AND ALL WARRANTIES AND REPRESENTATIONS WITH RESPECT TO SUCH SOFTWARE, WHETHER EXPRESS,
+ * IMPLIED, STATUTORY OR OTHERWISE, INCLUDING WITHOUT LIMITATION, ANY IMPLIED WARRANTIES OF TITLE,
+ * NON-INFRINGEMENT, MERCHANTABILITY, SATISFACTROY QUALITY, ACCURACY OR FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Table of known configurations for the vop bandwidth model (hwc_vop_bw.h).
+ * Run hwc_vop_bw_test on the device or the host, it returns non zero when a
+ * row does not give the expected bytes/s.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "hwc_vop_bw.h"
+
+using namespace android;
+
+#define VOP_BW_TEST_MAX_PLANES  4
+#define VOP_BW_TEST_TOLERANCE   0.001
+
+typedef struct vop_bw_test_case {
+    const char *name;
+    hwc_vop_bw_mode_t mode;
+    int count;
+    hwc_vop_bw_plane_t planes[VOP_BW_TEST_MAX_PLANES];
+    uint64_t average;   /* bytes/s */
+    uint64_t peak;      /* bytes/s */
+} vop_bw_test_case_t;
+
+#define MODE_1080P60    { 1080, 1125, 60, 1080 }
+#define MODE_2160P60    { 2160, 2250, 60, 2160 }
+#define MODE_720P60     { 720, 750, 60, 720 }
+
+static const vop_bw_test_case_t vop_bw_test_cases[] = {
+    { "1080p60 RGBA full screen", MODE_1080P60, 1,
+      { { 4, 0, false, 1920, 1080, 0, 1080 } },
+      518400000, 518400000 },
+    { "1080p60 RGBA AFBC full screen", MODE_1080P60, 1,
+      { { 4, 0, true, 1920, 1080, 0, 1080 } },
+      319140000, 526500000 },
+    { "1080p60 RGB565 full screen", MODE_1080P60, 1,
+      { { 2, 0, false, 1920, 1080, 0, 1080 } },
+      259200000, 259200000 },
+    { "2160p60 NV12 video", MODE_2160P60, 1,
+      { { 1, 0.5, false, 3840, 2160, 0, 2160 } },
+      777600000, 777600000 },
+    { "2160p60 NV12 10 bit video", MODE_2160P60, 1,
+      { { 1.25, 0.5, false, 3840, 2160, 0, 2160 } },
+      972000000, 972000000 },
+    { "1080p60 NV16 video", MODE_1080P60, 1,
+      { { 1, 1.0, false, 1920, 1080, 0, 1080 } },
+      259200000, 259200000 },
+    { "1080p60 NV12 down scaled to the top half", MODE_1080P60, 1,
+      { { 1, 0.5, false, 1920, 1080, 0, 540 } },
+      194400000, 388800000 },
+    { "1080p60 NV12 skipline, every other line fetched", MODE_1080P60, 1,
+      { { 1, 0.5, false, 1920, 540, 0, 1080 } },
+      97200000, 97200000 },
+    { "1080p60 two RGBA overlapped", MODE_1080P60, 2,
+      { { 4, 0, false, 1920, 1080, 0, 1080 },
+        { 4, 0, false, 1920, 1080, 0, 1080 } },
+      1036800000, 1036800000 },
+    { "1080p60 two RGBA halves stacked", MODE_1080P60, 2,
+      { { 4, 0, false, 1920, 540, 0, 540 },
+        { 4, 0, false, 1920, 540, 540, 540 } },
+      518400000, 518400000 },
+    { "1080p60 UI, video, status and navigation bars", MODE_1080P60, 4,
+      { { 4, 0, true, 1920, 1080, 0, 1080 },
+        { 1, 0.5, false, 1920, 1080, 270, 540 },
+        { 4, 0, false, 1920, 40, 0, 40 },
+        { 4, 0, false, 1920, 80, 1000, 80 } },
+      571140000, 1044900000 },
+    { "720p60 RGBA plane off the bottom of the frame", MODE_720P60, 1,
+      { { 4, 0, false, 1280, 720, 720, 720 } },
+      230400000, 0 },
+    { "no refresh rate", { 1080, 1125, 0, 1080 }, 1,
+      { { 4, 0, false, 1920, 1080, 0, 1080 } },
+      0, 0 },
+};
+
+static bool vop_bw_test_match(uint64_t value, uint64_t expected)
+{
+    if (expected == 0)
+        return value == 0;
+
+    return fabs((double)value - expected) <= expected * VOP_BW_TEST_TOLERANCE;
+}
+
+int main()
+{
+    int failed = 0;
+    int count = sizeof(vop_bw_test_cases) / sizeof(vop_bw_test_cases[0]);
+
+    printf("%-50s %14s %14s\n", "configuration", "average(MB/s)", "peak(MB/s)");
+    for (int i = 0; i < count; i++) {
+        const vop_bw_test_case_t *t = &vop_bw_test_cases[i];
+        uint64_t average = hwc_vop_bw_average(t->planes, t->count, &t->mode);
+        uint64_t peak = hwc_vop_bw_peak(t->planes, t->count, &t->mode);
+        bool ok = vop_bw_test_match(average, t->average) && vop_bw_test_match(peak, t->peak);
+
+        printf("%-50s %14.1f %14.1f %s\n", t->name, average / 1e6, peak / 1e6, ok ? "ok" : "FAILED");
+        if (!ok) {
+            printf("    expected average %.1f, peak %.1f\n", t->average / 1e6, t->peak / 1e6);
+            failed++;
+        }
+    }
+
+    printf("%d of %d configurations failed\n", failed, count);
+
+    return failed ? 1 : 0;
+}
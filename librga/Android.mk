@@ -80,6 +80,8 @@ LOCAL_SRC_FILES:= \
     core/GrallocOps.cpp \
     core/NormalRga.cpp \
     core/NormalRgaApi.cpp \
+    core/SoftRga.cpp \
+    core/RgaPool.cpp \
     core/RgaApi.cpp \
     core/RgaUtils.cpp \
     im2d_api/im2d.cpp
@@ -129,6 +131,8 @@ LOCAL_SRC_FILES += \
     core/GrallocOps.cpp \
     core/NormalRga.cpp \
     core/NormalRgaApi.cpp \
+    core/SoftRga.cpp \
+    core/RgaPool.cpp \
     core/RgaApi.cpp \
     core/RgaUtils.cpp \
     im2d_api/im2d.cpp
@@ -17,6 +17,11 @@
  */
 #include "NormalRga.h"
 #include "NormalRgaContext.h"
+#include "RgaTrace.h"
+
+#include <pthread.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 #ifdef ANDROID
 #include "GrallocOps.h"
@@ -78,6 +83,149 @@ int hwc_get_int_property(const char* pcProperty, const char* default_value) {
 }
 #endif
 
+/*
+ * Request trace, see RgaTrace.h. The file is opened by the first request after
+ * the process started; every record is one write() to a file opened with
+ * O_APPEND, so the requests of concurrent threads and contexts do not tear.
+ */
+static pthread_mutex_t rgaTraceLock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int rgaTraceState = 0;     /* 0 not checked yet, 1 on, -1 off */
+static int rgaTraceFd = -1;
+static int64_t rgaTraceStart = 0;
+
+static int64_t NormalRgaTraceNow(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void NormalRgaTraceOpen(struct rgaContext *ctx) {
+    char path[PATH_MAX];
+    rga_trace_header_t header;
+    size_t len;
+    int fd;
+#ifdef ANDROID
+    char value[PROPERTY_VALUE_MAX];
+
+    property_get("vendor.rga.trace", value, "");
+#else
+    const char *value = getenv("RGA_TRACE");
+
+    if (!value)
+        value = "";
+#endif
+
+    pthread_mutex_lock(&rgaTraceLock);
+    if (rgaTraceState != 0)
+        goto out;
+
+    rgaTraceState = -1;
+
+    len = strlen(value);
+    if (len == 0)
+        goto out;
+
+    if (value[len - 1] == '/')
+        snprintf(path, sizeof(path), "%srga-%d.trace", value, (int)getpid());
+    else
+        snprintf(path, sizeof(path), "%s", value);
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGE("Failed to open the rga trace %s: %s", path, strerror(errno));
+        goto out;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RGA_TRACE_MAGIC, sizeof(header.magic));
+    header.version = RGA_TRACE_VERSION;
+    header.record_size = sizeof(rga_trace_record_t);
+    header.pid = getpid();
+    header.driver_version = ctx->mVersion;
+    header.start_ns = NormalRgaTraceNow(CLOCK_REALTIME);
+
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        ALOGE("Failed to write the rga trace %s: %s", path, strerror(errno));
+        close(fd);
+        goto out;
+    }
+
+    rgaTraceFd = fd;
+    rgaTraceStart = NormalRgaTraceNow(CLOCK_MONOTONIC);
+    rgaTraceState = 1;
+    ALOGE("rga trace to %s", path);
+
+out:
+    pthread_mutex_unlock(&rgaTraceLock);
+}
+
+static inline bool NormalRgaTraceEnabled(struct rgaContext *ctx) {
+    if (rgaTraceState == 0)
+        NormalRgaTraceOpen(ctx);
+
+    return rgaTraceState > 0;
+}
+
+static void NormalRgaTraceImage(rga_trace_image_t *image, const rga_rect_t *rect) {
+    if (!rect)
+        return;
+
+    image->xoffset = rect->xoffset;
+    image->yoffset = rect->yoffset;
+    image->width = rect->width;
+    image->height = rect->height;
+    image->wstride = rect->wstride;
+    image->hstride = rect->hstride;
+    image->format = RkRgaGetRgaFormat(rect->format);
+}
+
+static void NormalRgaTrace(uint32_t op, int sync_mode, int64_t start, int ret, const struct rga_req *req,
+                           const rga_info *src, const rga_info *dst, const rga_rect_t *srcRect,
+                           const rga_rect_t *dstRect, const rga_rect_t *patRect) {
+    rga_trace_record_t record;
+    int64_t end = NormalRgaTraceNow(CLOCK_MONOTONIC);
+
+    memset(&record, 0, sizeof(record));
+    record.op = op;
+    record.flags = sync_mode == RGA_BLIT_ASYNC ? RGA_TRACE_ASYNC : 0;
+    if (op == RGA_TRACE_OP_BLIT && patRect)
+        record.flags |= RGA_TRACE_SRC1;
+    record.time_ns = start - rgaTraceStart;
+    record.duration_ns = end - start;
+    record.ret = ret;
+
+    if (src) {
+        record.rotation = src->rotation;
+        record.blend = src->blend;
+        record.scale_mode = src->scale_mode;
+        record.rop_code = src->rop_code;
+    }
+    if (dst) {
+        record.color = dst->color;
+        record.color_space_mode = dst->color_space_mode;
+    }
+
+    record.render_mode = req->render_mode;
+    record.rotate_mode = req->rotate_mode;
+    record.req_scale_mode = req->scale_mode;
+    record.alpha_rop_flag = req->alpha_rop_flag;
+    record.alpha_rop_mode = req->alpha_rop_mode;
+    record.PD_mode = req->PD_mode;
+    record.yuv2rgb_mode = req->yuv2rgb_mode;
+    record.palette_mode = req->palette_mode;
+
+    NormalRgaTraceImage(&record.src, srcRect);
+    NormalRgaTraceImage(&record.dst, dstRect);
+    NormalRgaTraceImage(&record.pat, patRect);
+
+    if (write(rgaTraceFd, &record, sizeof(record)) != (ssize_t)sizeof(record)) {
+        ALOGE("Failed to write the rga trace: %s", strerror(errno));
+    }
+}
+
+static void NormalRgaPaletteRelease();
+
 int NormalRgaOpen(void **context) {
     struct rgaContext *ctx = NULL;
     char buf[30];
@@ -116,6 +264,8 @@ int NormalRgaOpen(void **context) {
 
     NormalRgaInitTables();
 
+    ctx->mPool = RgaPoolCreate(true);
+
     fprintf(stderr, "ctx=%p,ctx->rgaFd=%d\n",ctx, ctx->rgaFd );
     rgaCtx = ctx;
 
@@ -183,8 +333,10 @@ int NormalRgaClose(void *context) {
 
     rgaCtx = NULL;
 
+    NormalRgaPaletteRelease();
     close(ctx->rgaFd);
 
+    RgaPoolDestroy(ctx->mPool);
     free(ctx);
 
     return 0;
@@ -205,6 +357,78 @@ int RgaDeInit(void *ctx) {
     return ret;
 }
 
+/*
+ * A context of its own, not shared with RgaInit(): it opens another /dev/rga
+ * session, so the jobs of different contexts do not queue behind each other.
+ */
+int NormalRgaCreateContext(void **context) {
+    struct rgaContext *ctx = NULL;
+    char buf[30];
+
+    if (!context)
+        return -EINVAL;
+
+    ctx = (struct rgaContext *)calloc(1, sizeof(struct rgaContext));
+    if (!ctx) {
+        ALOGE("malloc fail:%s.",strerror(errno));
+        return -ENOMEM;
+    }
+
+    ctx->rgaFd = open("/dev/rga", O_RDWR | O_CLOEXEC, 0);
+    if (ctx->rgaFd < 0) {
+        ALOGE("failed to open rga:%s.",strerror(errno));
+        free(ctx);
+        return -ENODEV;
+    }
+
+    memset(buf, 0, sizeof(buf));
+    ioctl(ctx->rgaFd, RGA_GET_VERSION, buf);
+    ctx->mVersion = atof(buf);
+
+    ctx->mPool = RgaPoolCreate(true);
+
+    *context = (void *)ctx;
+    return 0;
+}
+
+int NormalRgaDestroyContext(void *context) {
+    struct rgaContext *ctx = (struct rgaContext *)context;
+
+    if (!ctx)
+        return -EINVAL;
+
+    if (ctx == rgaCtx) {
+        ALOGE("Try to destroy the shared rgaCtx=%p, use RgaDeInit",ctx);
+        return -EINVAL;
+    }
+
+    close(ctx->rgaFd);
+    RgaPoolDestroy(ctx->mPool);
+    free(ctx);
+
+    return 0;
+}
+
+int RgaBlit(rga_info *src, rga_info *dst, rga_info *src1) {
+    return NormalRgaBlit(rgaCtx, src, dst, src1);
+}
+
+int RgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1) {
+    return NormalRgaSrcOver(rgaCtx, src, dst, src1);
+}
+
+int RgaFlush() {
+    return NormalRgaFlush(rgaCtx);
+}
+
+int RgaCollorFill(rga_info *dst) {
+    return NormalRgaCollorFill(rgaCtx, dst);
+}
+
+int RgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut) {
+    return NormalRgaCollorPalette(rgaCtx, src, dst, lut);
+}
+
 #ifdef ANDROID
 int NormalRgaPaletteTable(buffer_handle_t dst,
                           unsigned int v, drm_rga_t *rects) {
@@ -350,10 +574,10 @@ int NormalRgaPaletteTable(buffer_handle_t dst,
 }
 #endif
 
-int RgaBlit(rga_info *src, rga_info *dst, rga_info *src1) {
+int NormalRgaBlit(void *context, rga_info *src, rga_info *dst, rga_info *src1) {
     //check rects
     //check buffer_handle_t with rects
-    struct rgaContext *ctx = rgaCtx;
+    struct rgaContext *ctx = (struct rgaContext *)context;
     int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
     int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
     int src1VirW,src1VirH,src1ActW,src1ActH,src1XPos,src1YPos;
@@ -379,6 +603,8 @@ int RgaBlit(rga_info *src, rga_info *dst, rga_info *src1) {
     void *src1Buf = NULL;
     RECT clip;
     int sync_mode = RGA_BLIT_SYNC;
+    bool trace;
+    int64_t traceStart;
 
     //init context
     if (!ctx) {
@@ -1325,20 +1551,32 @@ int RgaBlit(rga_info *src, rga_info *dst, rga_info *src1) {
     if(dst->sync_mode == RGA_BLIT_ASYNC) {
         sync_mode = dst->sync_mode;
     }
+
+    trace = NormalRgaTraceEnabled(ctx);
+    traceStart = trace ? NormalRgaTraceNow(CLOCK_MONOTONIC) : 0;
+
     /* using sync to pass config to rga driver. */
-    if(ioctl(ctx->rgaFd, sync_mode, &rgaReg)) {
-        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        return -errno;
+    ret = ioctl(ctx->rgaFd, sync_mode, &rgaReg) ? -errno : 0;
+
+    if (trace)
+        NormalRgaTrace(RGA_TRACE_OP_BLIT, sync_mode, traceStart, ret, &rgaReg, src, dst,
+                       &relSrcRect, &relDstRect, src1 ? &relSrc1Rect : NULL);
+
+    if (ret) {
+        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(-ret));
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(-ret));
+        return ret;
     }
     return 0;
 }
 
-int RgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1) {
+int NormalRgaSrcOver(void *context, rga_info *src, rga_info *dst, rga_info *src1) {
 #if RGA_SRCOVER_EN
     int ret = 0;
     rga_info temp;
-    void *temp_buf = NULL;
+    rga_pool_buffer_t temp_buf;
+    struct rgaContext *ctx = (struct rgaContext *)context;
+    size_t size;
 
     (void)src1; /* unused src1 */
 
@@ -1348,19 +1586,27 @@ int RgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1) {
 		printf("Not src over mode\n");
 		return -1;
 	}
+
+    if (!ctx) {
+        ALOGE("Try to use uninit rgaCtx=%p",ctx);
+        return -ENODEV;
+    }
+
 #ifdef ANDROID
-	temp_buf= (char*)malloc(src->rect.wstride*src->rect.hstride*android::bytesPerPixel(RkRgaGetRgaFormat(src->rect.format)));
+    size = src->rect.wstride*src->rect.hstride*android::bytesPerPixel(RkRgaGetRgaFormat(src->rect.format));
 #elif LINUX
-    temp_buf= (char*)malloc(src->rect.wstride*src->rect.hstride*bytesPerPixel(RkRgaGetRgaFormat(src->rect.format)));
+    size = src->rect.wstride*src->rect.hstride*bytesPerPixel(RkRgaGetRgaFormat(src->rect.format));
 #endif
 
-    if (temp_buf == NULL)
-    	goto ERR_FREE_BUF;
+    /* reused across calls, see RgaPool.h */
+    ret = RgaPoolGet(ctx->mPool, size, &temp_buf);
+    if (ret) {
+        ALOGE("RgaSrcOver: failed to get a %zu bytes temp buffer", size);
+        return ret;
+    }
     memset(&temp,0x00,sizeof(temp));
 
-    temp.fd = -1;
-    temp.virAddr = temp_buf;
-    temp.mmuFlag = 1;
+    RgaPoolSetInfo(&temp_buf, &temp);
     temp.rect.width = src->rect.width;
     temp.rect.height = src->rect.height;
     temp.rect.wstride = src->rect.wstride;
@@ -1371,7 +1617,7 @@ int RgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1) {
 
     /*dst_YUV(crop & cvtcolor)->L_RGBA*/
     {
-        ret = RgaBlit(dst, &temp, NULL);
+        ret = NormalRgaBlit(ctx, dst, &temp, NULL);
         if (ret)
             goto ERR_FREE_BUF;
     }
@@ -1380,23 +1626,23 @@ int RgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1) {
     {
         src->blend = 0xff0105;
 
-        ret = RgaBlit(src, &temp, NULL);
+        ret = NormalRgaBlit(ctx, src, &temp, NULL);
         if (ret)
             goto ERR_FREE_BUF;
     }
 
     /*temp_RGBA(cvtcolor & translate)->dst_YUV*/
     {
-        ret = RgaBlit(&temp, dst, NULL);
+        ret = NormalRgaBlit(ctx, &temp, dst, NULL);
         if (ret)
             goto ERR_FREE_BUF;
     }
 
-	free(temp_buf);
+	RgaPoolPut(ctx->mPool, &temp_buf);
 	return 0;
 
 ERR_FREE_BUF:
-	free(temp_buf);
+	RgaPoolPut(ctx->mPool, &temp_buf);
 
 	printf(" %s(%d) RGA_SRCOVER fail: %s",__FUNCTION__, __LINE__,strerror(errno));
 	ALOGE(" %s(%d) RGA_SRCOVER fail: %s",__FUNCTION__, __LINE__,strerror(errno));
@@ -1408,8 +1654,15 @@ ERR_FREE_BUF:
 #endif
 }
 
-int RgaFlush() {
-    struct rgaContext *ctx = rgaCtx;
+struct rgaPool *RgaGetPool(void *ctx) {
+    if (!ctx)
+        return NULL;
+
+    return ((struct rgaContext *)ctx)->mPool;
+}
+
+int NormalRgaFlush(void *context) {
+    struct rgaContext *ctx = (struct rgaContext *)context;
 
     //init context
     if (!ctx) {
@@ -1425,10 +1678,33 @@ int RgaFlush() {
     return 0;
 }
 
-int RgaCollorFill(rga_info *dst) {
+int RgaGetVersion(char *version, int size) {
+    struct rgaContext *ctx = rgaCtx;
+    char buf[30];
+
+    //init context
+    if (!ctx) {
+        ALOGE("Try to use uninit rgaCtx=%p",ctx);
+        return -ENODEV;
+    }
+
+    if (!version || size <= 0)
+        return -EINVAL;
+
+    memset(buf, 0, sizeof(buf));
+    if (ioctl(ctx->rgaFd, RGA_GET_VERSION, buf)) {
+        ALOGE(" %s(%d) RGA_GET_VERSION fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+        return -errno;
+    }
+
+    snprintf(version, size, "%s", buf);
+    return 0;
+}
+
+int NormalRgaCollorFill(void *context, rga_info *dst) {
     //check rects
     //check buffer_handle_t with rects
-    struct rgaContext *ctx = rgaCtx;
+    struct rgaContext *ctx = (struct rgaContext *)context;
     int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
     int scaleMode,ditherEn;
     int dstType,dstMmuFlag;
@@ -1442,6 +1718,8 @@ int RgaCollorFill(rga_info *dst) {
     RECT clip;
 
     int sync_mode = RGA_BLIT_SYNC;
+    bool trace;
+    int64_t traceStart;
 
     if (!ctx) {
         ALOGE("Try to use uninit rgaCtx=%p",ctx);
@@ -1627,18 +1905,164 @@ int RgaCollorFill(rga_info *dst) {
         sync_mode = dst->sync_mode;
     }
 
-    if(ioctl(ctx->rgaFd, sync_mode, &rgaReg)) {
-        printf(" %s(%d) RGA_COLORFILL fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        ALOGE(" %s(%d) RGA_COLORFILL fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        return -errno;
+    trace = NormalRgaTraceEnabled(ctx);
+    traceStart = trace ? NormalRgaTraceNow(CLOCK_MONOTONIC) : 0;
+
+    ret = ioctl(ctx->rgaFd, sync_mode, &rgaReg) ? -errno : 0;
+
+    if (trace)
+        NormalRgaTrace(RGA_TRACE_OP_FILL, sync_mode, traceStart, ret, &rgaReg, NULL, dst,
+                       NULL, &relDstRect, NULL);
+
+    if (ret) {
+        printf(" %s(%d) RGA_COLORFILL fail: %s",__FUNCTION__, __LINE__,strerror(-ret));
+        ALOGE(" %s(%d) RGA_COLORFILL fail: %s",__FUNCTION__, __LINE__,strerror(-ret));
+        return ret;
     }
 
     return 0;
 }
 
-int RgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut) {
+/*
+ * Palette table cache. The table written by update_palette_table_mode stays in the
+ * rga, one for every context of the process, so the upload is skipped when the lut
+ * is the one of the last upload: same buffer, rect and hash of its content. A lut
+ * the cpu cannot read (physical address) is always uploaded. The lock is held from
+ * the check to the palette pass, another thread cannot change the table in between.
+ * The mapping of a lut fd is kept for the next call on the same buffer, so that
+ * hashing it is not a mmap and munmap every time.
+ *
+ * The rga does not tell when another process rewrites its table, so the cache is
+ * off unless vendor.rga.palette_cache (Android) or RGA_PALETTE_CACHE (Linux) is set
+ * to 1, for a device where this process is the only user of palette mode.
+ */
+static pthread_mutex_t rgaPaletteLock = PTHREAD_MUTEX_INITIALIZER;
+static int rgaPaletteState = 0;     /* 0 not checked yet, 1 on, -1 off */
+static bool rgaPaletteValid = false;
+static int rgaPaletteFd = -1;
+static void *rgaPaletteBuf = NULL;
+static rga_rect_t rgaPaletteRect;
+static uint64_t rgaPaletteHash = 0;
+static long rgaPaletteHits = 0;
+static long rgaPaletteMisses = 0;
+static int rgaPaletteMapFd = -1;
+static dev_t rgaPaletteMapDev;
+static ino_t rgaPaletteMapIno;
+static void *rgaPaletteMap = NULL;
+static size_t rgaPaletteMapSize = 0;
+
+static bool NormalRgaPaletteCacheEnabled() {
+    if (rgaPaletteState == 0) {
+#ifdef ANDROID
+        char value[PROPERTY_VALUE_MAX];
 
-    struct rgaContext *ctx = rgaCtx;
+        property_get("vendor.rga.palette_cache", value, "0");
+#else
+        const char *value = getenv("RGA_PALETTE_CACHE");
+
+        if (!value)
+            value = "0";
+#endif
+        rgaPaletteState = atoi(value) ? 1 : -1;
+    }
+
+    return rgaPaletteState > 0;
+}
+
+/*
+ * Map the lut fd, or reuse the mapping of the last call. The fd number alone may
+ * have been closed and reused for another buffer, so the file behind it is compared.
+ */
+static const uint8_t *NormalRgaPaletteMap(int fd, size_t size) {
+    struct stat st;
+    size_t map_size;
+    void *map;
+
+    if (fstat(fd, &st) < 0)
+        return NULL;
+
+    if (rgaPaletteMap && rgaPaletteMapFd == fd && rgaPaletteMapDev == st.st_dev &&
+        rgaPaletteMapIno == st.st_ino && rgaPaletteMapSize >= size)
+        return (const uint8_t *)rgaPaletteMap;
+
+    if (rgaPaletteMap) {
+        munmap(rgaPaletteMap, rgaPaletteMapSize);
+        rgaPaletteMap = NULL;
+        rgaPaletteMapFd = -1;
+    }
+
+    map_size = (size + getpagesize() - 1) & ~((size_t)getpagesize() - 1);
+    map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    rgaPaletteMap = map;
+    rgaPaletteMapSize = map_size;
+    rgaPaletteMapFd = fd;
+    rgaPaletteMapDev = st.st_dev;
+    rgaPaletteMapIno = st.st_ino;
+
+    return (const uint8_t *)map;
+}
+
+/* the last context is closed, the table and the lut mapping go with it */
+static void NormalRgaPaletteRelease() {
+    pthread_mutex_lock(&rgaPaletteLock);
+    if (rgaPaletteMap) {
+        munmap(rgaPaletteMap, rgaPaletteMapSize);
+        rgaPaletteMap = NULL;
+        rgaPaletteMapFd = -1;
+    }
+    rgaPaletteValid = false;
+    pthread_mutex_unlock(&rgaPaletteLock);
+}
+
+/* FNV-1a over the lut, false if the cpu cannot read it */
+static bool NormalRgaPaletteHash(int fd, void *buf, const rga_rect_t *rect, uint64_t *hash) {
+    size_t size;
+    const uint8_t *data;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    int wstride = rect->wstride > 0 ? rect->wstride : rect->width;
+    int hstride = rect->hstride > 0 ? rect->hstride : rect->height;
+
+#ifdef ANDROID
+    size = (size_t)wstride * hstride * android::bytesPerPixel(RkRgaGetRgaFormat(rect->format));
+#elif LINUX
+    size = (size_t)wstride * hstride * bytesPerPixel(RkRgaGetRgaFormat(rect->format));
+#endif
+    if (size == 0)
+        return false;
+
+    if (fd > 0) {
+        data = NormalRgaPaletteMap(fd, size);
+        if (data == NULL)
+            return false;
+    } else if (buf) {
+        data = (const uint8_t *)buf;
+    } else {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    *hash = h;
+    return true;
+}
+
+void NormalRgaPaletteCacheQuery(int *enabled, long *hits, long *misses) {
+    pthread_mutex_lock(&rgaPaletteLock);
+    *enabled = NormalRgaPaletteCacheEnabled();
+    *hits = rgaPaletteHits;
+    *misses = rgaPaletteMisses;
+    pthread_mutex_unlock(&rgaPaletteLock);
+}
+
+int NormalRgaCollorPalette(void *context, rga_info *src, rga_info *dst, rga_info *lut) {
+
+    struct rgaContext *ctx = (struct rgaContext *)context;
     struct rga_req  Rga_Request;
     struct rga_req  Rga_Request2;
     int srcVirW ,srcVirH ,srcActW ,srcActH ,srcXPos ,srcYPos;
@@ -1655,6 +2079,8 @@ int RgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut) {
     void *dstBuf = NULL;
     void *lutBuf = NULL;
     RECT clip;
+    bool trace;
+    int64_t traceStart;
 
     //init context
     if (!ctx) {
@@ -2173,20 +2599,67 @@ int RgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut) {
             break;
     }
 
+    trace = NormalRgaTraceEnabled(ctx);
+    traceStart = trace ? NormalRgaTraceNow(CLOCK_MONOTONIC) : 0;
+
+    pthread_mutex_lock(&rgaPaletteLock);
+
     if (!(lutFd == -1 && lutBuf == NULL)) {
-        rgaReg.fading.g = 0xff;
-        rgaReg.render_mode = update_palette_table_mode;
+        uint64_t hash = 0;
+        bool hashed = false, cached = false;
+
+        if (NormalRgaPaletteCacheEnabled()) {
+            hashed = NormalRgaPaletteHash(lutFd, lutBuf, &relLutRect, &hash);
+            cached = hashed && rgaPaletteValid && rgaPaletteFd == lutFd && rgaPaletteBuf == lutBuf &&
+                     memcmp(&rgaPaletteRect, &relLutRect, sizeof(rga_rect_t)) == 0 &&
+                     rgaPaletteHash == hash;
+            if (cached)
+                rgaPaletteHits++;
+            else
+                rgaPaletteMisses++;
+        }
 
-        if(ioctl(ctx->rgaFd, RGA_BLIT_SYNC, &rgaReg) != 0) {
-            printf("update palette table mode ioctl err\n");
-            return -1;
+        rgaReg.fading.g = 0xff;
+        if (!cached) {
+            rgaPaletteValid = false;
+            rgaReg.render_mode = update_palette_table_mode;
+
+            if(ioctl(ctx->rgaFd, RGA_BLIT_SYNC, &rgaReg) != 0) {
+                if (trace)
+                    NormalRgaTrace(RGA_TRACE_OP_PALETTE, RGA_BLIT_SYNC, traceStart, -errno, &rgaReg, src, dst,
+                                   &relSrcRect, &relDstRect, &relLutRect);
+                pthread_mutex_unlock(&rgaPaletteLock);
+                printf("update palette table mode ioctl err\n");
+                return -1;
+            }
+
+            /* a lut not hashed is uploaded again by the next call */
+            if (hashed) {
+                rgaPaletteValid = true;
+                rgaPaletteFd = lutFd;
+                rgaPaletteBuf = lutBuf;
+                memcpy(&rgaPaletteRect, &relLutRect, sizeof(rga_rect_t));
+                rgaPaletteHash = hash;
+            }
         }
     }
 
     rgaReg.render_mode = color_palette_mode;
     rgaReg.endian_mode = 1;
 
-    if(ioctl(ctx->rgaFd, RGA_BLIT_SYNC, &rgaReg) != 0) {
+    ret = ioctl(ctx->rgaFd, RGA_BLIT_SYNC, &rgaReg) ? -errno : 0;
+    /* the state of the table is unknown after a failed pass */
+    if (ret)
+        rgaPaletteValid = false;
+
+    pthread_mutex_unlock(&rgaPaletteLock);
+
+    /* the table update and the palette pass as one record */
+    if (trace)
+        NormalRgaTrace(RGA_TRACE_OP_PALETTE, RGA_BLIT_SYNC, traceStart, ret, &rgaReg, src, dst,
+                       &relSrcRect, &relDstRect, lut ? &relLutRect : NULL);
+
+    if (ret) {
       printf("color palette ioctl err\n");
         return -1;
     }
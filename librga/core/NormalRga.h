@@ -45,6 +45,7 @@
 #include "rga.h"
 
 #include "NormalRgaContext.h"
+#include "RgaPool.h"
 
 #ifdef ANDROID_7_DRM
 #define RGA_BUF_GEM_TYPE_MASK      0xC0
@@ -56,8 +57,22 @@ int         RgaDeInit(void *ctx);
 int         RgaBlit(rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
 int         RgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1);
 int         RgaFlush();
+int         RgaGetVersion(char *version, int size);
 int         RgaCollorFill(rga_info_t *dst);
 int         RgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut);
+struct rgaPool *RgaGetPool(void *ctx);
+
+/* the same operations on a given context, RgaInit() or NormalRgaCreateContext() */
+int         NormalRgaCreateContext(void **ctx);
+int         NormalRgaDestroyContext(void *ctx);
+int         NormalRgaBlit(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
+int         NormalRgaSrcOver(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
+int         NormalRgaCollorFill(void *ctx, rga_info_t *dst);
+int         NormalRgaCollorPalette(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *lut);
+int         NormalRgaFlush(void *ctx);
+
+/* the palette table uploads skipped (hits) and done (misses), see NormalRgaCollorPalette() */
+void        NormalRgaPaletteCacheQuery(int *enabled, long *hits, long *misses);
 
 
 int         NormalRgaInitTables();
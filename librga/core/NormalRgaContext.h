@@ -25,12 +25,15 @@
 #define ALOGE(...) printf(__VA_ARGS__); printf("\n")
 #endif
 
+struct rgaPool;
+
 struct rgaContext {
     int rgaFd;
     int mLogAlways;
     int mLogOnce;
     float mVersion;
     int Is_debug;
+    struct rgaPool *mPool;     /* intermediate buffers, see RgaPool.h */
 
 };
 #endif
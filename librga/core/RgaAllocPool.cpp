@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RgaAllocPool.h"
+
+#ifndef ANDROID /* LINUX */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <vector>
+
+#if LIBDRM
+#include <drm.h>
+#include "drm_mode.h"
+#include "xf86drm.h"
+#endif
+
+typedef struct {
+    bo_t        bo;
+    int         width;              /* size class */
+    int         height;
+    int         bpp;
+    int         flags;
+    bool        cached;             /* freed, else handed out */
+    uint64_t    lastUse;            /* sequence of the free, for the lru */
+} rgaAllocPoolEntry;
+
+struct rgaAllocPool {
+    pthread_mutex_t                 lock;
+    std::vector<rgaAllocPoolEntry>  entries;
+    size_t                          budget;
+    size_t                          cached;
+    size_t                          inUse;
+    size_t                          highWater;
+    int                             cachedCount;
+    long                            hits;
+    long                            misses;
+    long                            evictions;
+    uint64_t                        sequence;
+};
+
+/* what RkRgaUnmap() and RkRgaFree() do for a buffer of the caller */
+static void RgaAllocPoolRelease(bo_t *bo_info) {
+    if (bo_info->ptr)
+        munmap(bo_info->ptr, bo_info->size);
+#if LIBDRM
+    if (bo_info->handle > 0) {
+        struct drm_mode_destroy_dumb arg;
+
+        memset(&arg, 0, sizeof(arg));
+        arg.handle = bo_info->handle;
+        if (drmIoctl(bo_info->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &arg))
+            fprintf(stderr, "failed to destroy dumb buffer: %s\n", strerror(errno));
+    }
+#endif
+    if (bo_info->fd >= 0)
+        close(bo_info->fd);
+
+    bo_info->ptr = NULL;
+    bo_info->handle = 0;
+    bo_info->fd = -1;
+}
+
+static int RgaAllocPoolFind(struct rgaAllocPool *pool, const bo_t *bo_info) {
+    for (size_t i = 0; i < pool->entries.size(); i++) {
+        const rgaAllocPoolEntry &e = pool->entries[i];
+
+        if (!e.cached && e.bo.fd == bo_info->fd && e.bo.handle == bo_info->handle)
+            return (int)i;
+    }
+
+    return -1;
+}
+
+static size_t RgaAllocPoolTrimLocked(struct rgaAllocPool *pool, size_t keep) {
+    size_t freed = 0;
+
+    while (pool->cached > keep) {
+        int lru = -1;
+
+        for (size_t i = 0; i < pool->entries.size(); i++) {
+            const rgaAllocPoolEntry &e = pool->entries[i];
+
+            if (e.cached && (lru < 0 || e.lastUse < pool->entries[lru].lastUse))
+                lru = (int)i;
+        }
+        if (lru < 0)
+            break;
+
+        rgaAllocPoolEntry &e = pool->entries[lru];
+
+        freed += e.bo.size;
+        pool->cached -= e.bo.size;
+        pool->cachedCount--;
+        pool->evictions++;
+        RgaAllocPoolRelease(&e.bo);
+        pool->entries.erase(pool->entries.begin() + lru);
+    }
+
+    return freed;
+}
+
+struct rgaAllocPool *RgaAllocPoolCreate(size_t budget) {
+    struct rgaAllocPool *pool = new rgaAllocPool();
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->budget = budget;
+
+    return pool;
+}
+
+void RgaAllocPoolDestroy(struct rgaAllocPool *pool) {
+    if (!pool)
+        return;
+
+    /* the buffers handed out stay with their owners, RkRgaFree() releases them */
+    pthread_mutex_lock(&pool->lock);
+    RgaAllocPoolTrimLocked(pool, 0);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_destroy(&pool->lock);
+    delete pool;
+}
+
+int RgaAllocPoolClassHeight(int height) {
+    return (height + RGA_ALLOC_POOL_ROWS - 1) / RGA_ALLOC_POOL_ROWS * RGA_ALLOC_POOL_ROWS;
+}
+
+int RgaAllocPoolGet(struct rgaAllocPool *pool, int width, int height, int bpp, int flags,
+                    bo_t *bo_info) {
+    int class_height = RgaAllocPoolClassHeight(height);
+
+    if (!pool || !bo_info)
+        return -EINVAL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->budget == 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return -ENOENT;
+    }
+
+    for (size_t i = 0; i < pool->entries.size(); i++) {
+        rgaAllocPoolEntry &e = pool->entries[i];
+
+        if (!e.cached || e.width != width || e.height != class_height ||
+            e.bpp != bpp || e.flags != flags)
+            continue;
+
+        e.cached = false;
+        pool->cached -= e.bo.size;
+        pool->cachedCount--;
+        pool->inUse += e.bo.size;
+        pool->hits++;
+
+        /* the mapping is handed out by RkRgaGetMmap() */
+        *bo_info = e.bo;
+        bo_info->ptr = NULL;
+
+        pthread_mutex_unlock(&pool->lock);
+        return 0;
+    }
+
+    pool->misses++;
+    pthread_mutex_unlock(&pool->lock);
+
+    return -ENOENT;
+}
+
+void RgaAllocPoolAdd(struct rgaAllocPool *pool, int width, int height, int bpp, int flags,
+                     const bo_t *bo_info) {
+    rgaAllocPoolEntry e;
+
+    if (!pool || !bo_info)
+        return;
+
+    memset(&e, 0, sizeof(e));
+    e.bo = *bo_info;
+    e.bo.ptr = NULL;
+    e.width = width;
+    e.height = RgaAllocPoolClassHeight(height);
+    e.bpp = bpp;
+    e.flags = flags;
+    e.cached = false;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->budget > 0) {
+        pool->entries.push_back(e);
+        pool->inUse += e.bo.size;
+        if (pool->inUse + pool->cached > pool->highWater)
+            pool->highWater = pool->inUse + pool->cached;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int RgaAllocPoolMap(struct rgaAllocPool *pool, bo_t *bo_info) {
+    int i, ret = -ENOENT;
+
+    if (!pool || !bo_info)
+        return -EINVAL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    i = RgaAllocPoolFind(pool, bo_info);
+    if (i >= 0 && pool->entries[i].bo.ptr) {
+        bo_info->ptr = pool->entries[i].bo.ptr;
+        ret = 0;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return ret;
+}
+
+int RgaAllocPoolSetMap(struct rgaAllocPool *pool, const bo_t *bo_info) {
+    int i, ret = -ENOENT;
+
+    if (!pool || !bo_info)
+        return -EINVAL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    i = RgaAllocPoolFind(pool, bo_info);
+    if (i >= 0) {
+        pool->entries[i].bo.ptr = bo_info->ptr;
+        ret = 0;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return ret;
+}
+
+int RgaAllocPoolPut(struct rgaAllocPool *pool, bo_t *bo_info) {
+    int i;
+
+    if (!pool || !bo_info)
+        return -EINVAL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    i = RgaAllocPoolFind(pool, bo_info);
+    if (i < 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return -ENOENT;
+    }
+
+    rgaAllocPoolEntry &e = pool->entries[i];
+
+    e.cached = true;
+    e.lastUse = ++pool->sequence;
+    pool->inUse -= e.bo.size;
+    pool->cached += e.bo.size;
+    pool->cachedCount++;
+
+    RgaAllocPoolTrimLocked(pool, pool->budget);
+
+    pthread_mutex_unlock(&pool->lock);
+
+    bo_info->ptr = NULL;
+    bo_info->handle = 0;
+    bo_info->fd = -1;
+
+    return 0;
+}
+
+size_t RgaAllocPoolTrim(struct rgaAllocPool *pool, size_t keep) {
+    size_t freed;
+
+    if (!pool)
+        return 0;
+
+    pthread_mutex_lock(&pool->lock);
+    freed = RgaAllocPoolTrimLocked(pool, keep);
+    pthread_mutex_unlock(&pool->lock);
+
+    return freed;
+}
+
+void RgaAllocPoolSetBudget(struct rgaAllocPool *pool, size_t budget) {
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->budget = budget;
+    RgaAllocPoolTrimLocked(pool, budget);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void RgaAllocPoolQuery(struct rgaAllocPool *pool, rga_alloc_pool_info_t *info) {
+    if (!info)
+        return;
+
+    memset(info, 0, sizeof(rga_alloc_pool_info_t));
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    info->budget = pool->budget;
+    info->cached = pool->cached;
+    info->in_use = pool->inUse;
+    info->high_water = pool->highWater;
+    info->cached_count = pool->cachedCount;
+    info->in_use_count = (int)pool->entries.size() - pool->cachedCount;
+    info->hits = pool->hits;
+    info->misses = pool->misses;
+    info->evictions = pool->evictions;
+    pthread_mutex_unlock(&pool->lock);
+}
+#endif
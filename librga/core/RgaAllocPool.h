@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _rockchip_rga_alloc_pool_h_
+#define _rockchip_rga_alloc_pool_h_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "drmrga.h"
+
+#ifndef ANDROID /* LINUX */
+/*
+ * DRM dumb buffers of RkRgaGetAllocBuffer*(). RkRgaFree() gives a buffer back to
+ * the pool, which keeps it, with its mapping, for the next allocation of the same
+ * size class: width, bpp and flags, height rounded up to RGA_ALLOC_POOL_ROWS.
+ * A buffer taken from the pool is not cleared.
+ *
+ * The cached buffers are bounded by a byte budget, RGA_ALLOC_POOL_BUDGET or
+ * "RGA_ALLOC_POOL_MB" in the environment, the least recently freed ones are
+ * released first. A budget of 0 disables the pool.
+ */
+#define RGA_ALLOC_POOL_BUDGET   (32 << 20)
+#define RGA_ALLOC_POOL_ROWS     16
+
+struct rgaAllocPool;
+
+struct rgaAllocPool *RgaAllocPoolCreate(size_t budget);
+void        RgaAllocPoolDestroy(struct rgaAllocPool *pool);
+
+/* the height the buffers of the size class of height are allocated with */
+int         RgaAllocPoolClassHeight(int height);
+
+/* a cached buffer of the size class, or -ENOENT and the caller allocates one */
+int         RgaAllocPoolGet(struct rgaAllocPool *pool, int width, int height, int bpp, int flags,
+                            bo_t *bo_info);
+/* a buffer the caller allocated for the size class, returned to the pool when freed */
+void        RgaAllocPoolAdd(struct rgaAllocPool *pool, int width, int height, int bpp, int flags,
+                            const bo_t *bo_info);
+
+/*
+ * the mapping of a buffer of the pool: RgaAllocPoolMap() sets bo_info->ptr to the one
+ * kept, RgaAllocPoolSetMap() records a new one. -ENOENT for the buffers of the caller.
+ */
+int         RgaAllocPoolMap(struct rgaAllocPool *pool, bo_t *bo_info);
+int         RgaAllocPoolSetMap(struct rgaAllocPool *pool, const bo_t *bo_info);
+/* the buffer is cached, or -ENOENT when it does not come from the pool */
+int         RgaAllocPoolPut(struct rgaAllocPool *pool, bo_t *bo_info);
+
+/* release cached buffers, least recently freed first, until at most keep bytes are cached */
+size_t      RgaAllocPoolTrim(struct rgaAllocPool *pool, size_t keep);
+void        RgaAllocPoolSetBudget(struct rgaAllocPool *pool, size_t budget);
+void        RgaAllocPoolQuery(struct rgaAllocPool *pool, rga_alloc_pool_info_t *info);
+#endif
+
+#endif
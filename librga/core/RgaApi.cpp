@@ -56,6 +56,21 @@ int c_RkRgaFlush()
     return c_rkRga.RkRgaFlush();
 }
 
+int c_RkRgaPoolQuery(rga_pool_info_t *info)
+{
+    return c_rkRga.RkRgaPoolQuery(info);
+}
+
+size_t c_RkRgaPoolTrim(int idle_ms)
+{
+    return c_rkRga.RkRgaPoolTrim(idle_ms);
+}
+
+int c_RkRgaPaletteCacheQuery(rga_palette_cache_info_t *info)
+{
+    return c_rkRga.RkRgaPaletteCacheQuery(info);
+}
+
 #ifndef ANDROID /* linux */
 int c_RkRgaGetAllocBuffer(bo_t *bo_info, int width, int height, int bpp)
 {
@@ -92,5 +107,20 @@ int c_RkRgaGetBufferFd(bo_t *bo_info, int *fd)
     c_rkRga.RkRgaGetBufferFd(bo_info, fd);
     return 0;
 }
+
+int c_RkRgaAllocPoolQuery(rga_alloc_pool_info_t *info)
+{
+    return c_rkRga.RkRgaAllocPoolQuery(info);
+}
+
+size_t c_RkRgaAllocPoolTrim(size_t keep)
+{
+    return c_rkRga.RkRgaAllocPoolTrim(keep);
+}
+
+void c_RkRgaAllocPoolSetBudget(size_t budget)
+{
+    c_rkRga.RkRgaAllocPoolSetBudget(budget);
+}
 #endif /* #ifndef Andorid */
 
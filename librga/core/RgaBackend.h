@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _rockchip_rga_backend_h_
+#define _rockchip_rga_backend_h_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "drmrga.h"
+#include "RgaPool.h"
+
+/*
+ * The operations RockchipRga dispatches to. NormalRga drives /dev/rga,
+ * SoftRga does the same work on the CPU. A backend that cannot do an
+ * operation leaves the pointer NULL.
+ *
+ * init() sets up the context shared by the process, create_context() one of
+ * its own for a thread or pipeline; the operations take either of them.
+ */
+struct rgaBackend {
+    const char *name;
+    int         type;
+
+    int         (*init)(void **ctx);
+    int         (*deinit)(void *ctx);
+    int         (*create_context)(void **ctx);
+    int         (*destroy_context)(void *ctx);
+    int         (*blit)(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
+    int         (*src_over)(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
+    int         (*fill)(void *ctx, rga_info_t *dst);
+    int         (*palette)(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *lut);
+    int         (*flush)(void *ctx);
+    int         (*get_version)(char *version, int size);
+    struct rgaPool *(*get_pool)(void *ctx);
+};
+
+#endif
@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RgaPool.h"
+#include "NormalRgaContext.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#ifdef ANDROID
+#include <utils/Log.h>
+#endif
+
+#if LIBDRM
+#include <drm.h>
+#include "drm_mode.h"
+#include "xf86drm.h"
+#endif
+
+#define RGA_POOL_MIN_SIZE       (64 * 1024)
+#define RGA_POOL_DUMB_PITCH     4096
+
+typedef struct {
+    rga_pool_buffer_t   buf;
+    unsigned int        handle;     /* dumb buffer of buf.fd */
+    bool                used;       /* the slot holds a buffer */
+    bool                busy;       /* handed out */
+    int64_t             lastUse;    /* ms, monotonic */
+} rgaPoolSlot;
+
+struct rgaPool {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    pthread_t           trimmer;
+    bool                trimmerStarted;
+    bool                trimmerRunning;
+    bool                exiting;
+
+    bool                dma;        /* dumb buffers, until the DRM device fails to open */
+    int                 drmFd;      /* opened by the first allocation */
+
+    rgaPoolSlot         slots[RGA_POOL_MAX_BUFFERS];
+    size_t              size;
+    size_t              inUse;
+    size_t              highWater;
+    int                 count;
+};
+
+static int64_t RgaPoolNow() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* four buckets per power of two, at most a quarter is wasted */
+static size_t RgaPoolBucket(size_t size) {
+    size_t base = RGA_POOL_MIN_SIZE;
+    size_t step;
+
+    while (base * 2 <= size)
+        base *= 2;
+    step = base / 4;
+
+    return (size + step - 1) / step * step;
+}
+
+static int RgaPoolAlloc(struct rgaPool *pool, size_t size, rga_pool_buffer_t *buf, unsigned int *handle) {
+    void *addr;
+
+    buf->fd = -1;
+    buf->virAddr = NULL;
+    buf->size = size;
+    *handle = 0;
+
+#if LIBDRM
+    if (pool->dma && pool->drmFd < 0) {
+        pool->drmFd = open("/dev/dri/card0", O_RDWR | O_CLOEXEC);
+        if (pool->drmFd < 0) {
+            ALOGE("rga pool: failed to open /dev/dri/card0, use virtual buffers");
+            pool->dma = false;
+        }
+    }
+
+    if (pool->dma) {
+        struct drm_mode_create_dumb arg;
+        struct drm_mode_destroy_dumb darg;
+
+        memset(&arg, 0, sizeof(arg));
+        arg.bpp = 8;
+        arg.width = RGA_POOL_DUMB_PITCH;
+        arg.height = size / RGA_POOL_DUMB_PITCH;
+
+        if (!drmIoctl(pool->drmFd, DRM_IOCTL_MODE_CREATE_DUMB, &arg)) {
+            if (!drmPrimeHandleToFD(pool->drmFd, arg.handle, DRM_CLOEXEC, &buf->fd)) {
+                *handle = arg.handle;
+                return 0;
+            }
+
+            memset(&darg, 0, sizeof(darg));
+            darg.handle = arg.handle;
+            drmIoctl(pool->drmFd, DRM_IOCTL_MODE_DESTROY_DUMB, &darg);
+        }
+
+        ALOGE("rga pool: failed to alloc a dumb buffer of %zu bytes, use a virtual one", size);
+        buf->fd = -1;
+    }
+#else
+    (void)pool;
+#endif
+
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        return -ENOMEM;
+
+    buf->virAddr = addr;
+    return 0;
+}
+
+static void RgaPoolFree(struct rgaPool *pool, rga_pool_buffer_t *buf, unsigned int handle) {
+    if (buf->fd >= 0) {
+        close(buf->fd);
+#if LIBDRM
+        struct drm_mode_destroy_dumb arg;
+
+        memset(&arg, 0, sizeof(arg));
+        arg.handle = handle;
+        drmIoctl(pool->drmFd, DRM_IOCTL_MODE_DESTROY_DUMB, &arg);
+#else
+        (void)pool;
+        (void)handle;
+#endif
+    } else if (buf->virAddr) {
+        munmap(buf->virAddr, buf->size);
+    }
+
+    buf->fd = -1;
+    buf->virAddr = NULL;
+}
+
+static size_t RgaPoolTrimLocked(struct rgaPool *pool, int idle_ms) {
+    int64_t now = RgaPoolNow();
+    size_t freed = 0;
+
+    for (int i = 0; i < RGA_POOL_MAX_BUFFERS; i++) {
+        rgaPoolSlot *slot = &pool->slots[i];
+
+        if (!slot->used || slot->busy || now - slot->lastUse < idle_ms)
+            continue;
+
+        freed += slot->buf.size;
+        pool->size -= slot->buf.size;
+        pool->count--;
+        RgaPoolFree(pool, &slot->buf, slot->handle);
+        slot->used = false;
+    }
+
+    return freed;
+}
+
+static bool RgaPoolHasCached(struct rgaPool *pool) {
+    for (int i = 0; i < RGA_POOL_MAX_BUFFERS; i++)
+        if (pool->slots[i].used && !pool->slots[i].busy)
+            return true;
+
+    return false;
+}
+
+static void *RgaPoolTrimmer(void *arg) {
+    struct rgaPool *pool = (struct rgaPool *)arg;
+    struct timespec ts;
+
+    pthread_mutex_lock(&pool->lock);
+
+    /* runs while there are cached buffers, RgaPoolPut() starts it again */
+    while (!pool->exiting && RgaPoolHasCached(pool)) {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += RGA_POOL_IDLE_MS / 2 / 1000;
+        ts.tv_nsec += (long)(RGA_POOL_IDLE_MS / 2 % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+
+        pthread_cond_timedwait(&pool->cond, &pool->lock, &ts);
+        if (!pool->exiting)
+            RgaPoolTrimLocked(pool, RGA_POOL_IDLE_MS);
+    }
+
+    pool->trimmerRunning = false;
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+struct rgaPool *RgaPoolCreate(bool dma) {
+    struct rgaPool *pool;
+
+    pool = (struct rgaPool *)calloc(1, sizeof(struct rgaPool));
+    if (!pool)
+        return NULL;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pool->drmFd = -1;
+
+#if LIBDRM
+    pool->dma = dma;
+#else
+    (void)dma;
+#endif
+
+    return pool;
+}
+
+void RgaPoolDestroy(struct rgaPool *pool) {
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->exiting = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pool->trimmerStarted)
+        pthread_join(pool->trimmer, NULL);
+
+    for (int i = 0; i < RGA_POOL_MAX_BUFFERS; i++) {
+        rgaPoolSlot *slot = &pool->slots[i];
+
+        if (!slot->used)
+            continue;
+
+        if (slot->busy) {
+            ALOGE("rga pool: a buffer of %zu bytes is still in use", slot->buf.size);
+        }
+        RgaPoolFree(pool, &slot->buf, slot->handle);
+    }
+
+    if (pool->drmFd >= 0)
+        close(pool->drmFd);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+int RgaPoolGet(struct rgaPool *pool, size_t size, rga_pool_buffer_t *buf) {
+    size_t bucket = RgaPoolBucket(size);
+    rgaPoolSlot *slot = NULL;
+    unsigned int handle = 0;
+    int ret;
+
+    if (!pool || !buf || size == 0)
+        return -EINVAL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    /* a cached buffer of the same bucket */
+    for (int i = 0; i < RGA_POOL_MAX_BUFFERS; i++) {
+        if (pool->slots[i].used && !pool->slots[i].busy && pool->slots[i].buf.size == bucket) {
+            slot = &pool->slots[i];
+            slot->busy = true;
+            pool->inUse += bucket;
+            *buf = slot->buf;
+            pthread_mutex_unlock(&pool->lock);
+            return 0;
+        }
+    }
+
+    /* an empty slot, or else the least recently used cached buffer of another bucket */
+    for (int i = 0; i < RGA_POOL_MAX_BUFFERS; i++) {
+        rgaPoolSlot *s = &pool->slots[i];
+
+        if (!s->used) {
+            slot = s;
+            break;
+        }
+        if (!s->busy && (!slot || s->lastUse < slot->lastUse))
+            slot = s;
+    }
+
+    if (slot && slot->used) {
+        pool->size -= slot->buf.size;
+        pool->count--;
+        RgaPoolFree(pool, &slot->buf, slot->handle);
+        slot->used = false;
+    }
+
+    ret = RgaPoolAlloc(pool, bucket, buf, &handle);
+    if (ret) {
+        pthread_mutex_unlock(&pool->lock);
+        ALOGE("rga pool: failed to alloc %zu bytes", bucket);
+        return ret;
+    }
+
+    pool->size += bucket;
+    pool->inUse += bucket;
+    pool->count++;
+    if (pool->size > pool->highWater)
+        pool->highWater = pool->size;
+
+    /* every slot is in use, the buffer is released when it is put back */
+    buf->slot = slot ? (int)(slot - pool->slots) : -1;
+    if (slot) {
+        slot->buf = *buf;
+        slot->handle = handle;
+        slot->used = true;
+        slot->busy = true;
+    } else {
+        /* keep the handle where RgaPoolPut() finds it */
+        buf->slot = -1 - (int)handle;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+}
+
+void RgaPoolPut(struct rgaPool *pool, rga_pool_buffer_t *buf) {
+    if (!pool || !buf || (buf->fd < 0 && !buf->virAddr))
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->inUse -= buf->size;
+
+    if (buf->slot < 0) {
+        pool->size -= buf->size;
+        pool->count--;
+        RgaPoolFree(pool, buf, (unsigned int)(-1 - buf->slot));
+    } else {
+        rgaPoolSlot *slot = &pool->slots[buf->slot];
+
+        slot->busy = false;
+        slot->lastUse = RgaPoolNow();
+
+        if (!pool->trimmerRunning && !pool->exiting) {
+            /* the last trimmer has left the loop, it only has to return */
+            if (pool->trimmerStarted)
+                pthread_join(pool->trimmer, NULL);
+
+            pool->trimmerStarted = !pthread_create(&pool->trimmer, NULL, RgaPoolTrimmer, pool);
+            pool->trimmerRunning = pool->trimmerStarted;
+        }
+    }
+
+    buf->fd = -1;
+    buf->virAddr = NULL;
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+size_t RgaPoolTrim(struct rgaPool *pool, int idle_ms) {
+    size_t freed;
+
+    if (!pool)
+        return 0;
+
+    pthread_mutex_lock(&pool->lock);
+    freed = RgaPoolTrimLocked(pool, idle_ms);
+    pthread_mutex_unlock(&pool->lock);
+
+    return freed;
+}
+
+void RgaPoolQuery(struct rgaPool *pool, rga_pool_info_t *info) {
+    if (!info)
+        return;
+
+    memset(info, 0, sizeof(rga_pool_info_t));
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    info->size = pool->size;
+    info->in_use = pool->inUse;
+    info->high_water = pool->highWater;
+    info->count = pool->count;
+    info->dma = pool->dma;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void RgaPoolSetInfo(const rga_pool_buffer_t *buf, rga_info_t *info) {
+    info->fd = buf->fd;
+    info->virAddr = buf->virAddr;
+    info->phyAddr = NULL;
+    info->mmuFlag = 1;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _rockchip_rga_pool_h_
+#define _rockchip_rga_pool_h_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "drmrga.h"
+
+/*
+ * Intermediate buffers of multi-pass operations, such as RgaSrcOver and the tiles and
+ * passes of im2d. Buffers are handed out by size bucket and kept after use; one that
+ * stays unused for RGA_POOL_IDLE_MS is released by a trimmer thread.
+ *
+ * With libdrm the buffers are dma-buf exported DRM dumb buffers, so that the kernel
+ * does not pin and map pages on every job; otherwise they are anonymous mappings.
+ */
+#define RGA_POOL_MAX_BUFFERS    16
+#define RGA_POOL_IDLE_MS        3000
+
+struct rgaPool;
+
+typedef struct rga_pool_buffer {
+    int         fd;                 /* dma-buf fd, -1 for a virtual buffer */
+    void *      virAddr;            /* NULL for a dma-buf */
+    size_t      size;               /* size of the bucket, at least what was asked */
+    int         slot;               /* private to the pool */
+} rga_pool_buffer_t;
+
+struct rgaPool *RgaPoolCreate(bool dma);
+void        RgaPoolDestroy(struct rgaPool *pool);
+int         RgaPoolGet(struct rgaPool *pool, size_t size, rga_pool_buffer_t *buf);
+void        RgaPoolPut(struct rgaPool *pool, rga_pool_buffer_t *buf);
+size_t      RgaPoolTrim(struct rgaPool *pool, int idle_ms);
+void        RgaPoolQuery(struct rgaPool *pool, rga_pool_info_t *info);
+
+/* fill rga_info_t to use the buffer as an image of the rect */
+void        RgaPoolSetInfo(const rga_pool_buffer_t *buf, rga_info_t *info);
+
+#endif
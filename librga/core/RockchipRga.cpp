@@ -33,6 +33,8 @@
 #include <utils/misc.h>
 #include <cutils/properties.h>
 #include "core/NormalRga.h"
+#include "core/SoftRga.h"
+#include "core/RgaBackend.h"
 
 #ifndef ANDROID_8
 #include <gui/Surface.h>
@@ -59,6 +61,10 @@
 
 #ifdef LINUX
 #include "NormalRga.h"
+#include "SoftRga.h"
+#include "RgaBackend.h"
+#include "RgaAllocPool.h"
+#include <pthread.h>
 #if LIBDRM
 #include <drm.h>
 #include "drm_mode.h"
@@ -75,41 +81,200 @@ namespace android {
 RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
 #endif
 
+    static const struct rgaBackend normalRgaBackend = {
+        "hw", RGA_BACKEND_HW,
+        RgaInit, RgaDeInit, NormalRgaCreateContext, NormalRgaDestroyContext,
+        NormalRgaBlit, NormalRgaSrcOver, NormalRgaCollorFill, NormalRgaCollorPalette,
+        NormalRgaFlush, RgaGetVersion, RgaGetPool,
+    };
+
+    /* SoftRga keeps no device state, every context runs the same code. */
+    static int SoftRgaBlitCtx(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *src1) {
+        (void)ctx;
+        return SoftRgaBlit(src, dst, src1);
+    }
+
+    static int SoftRgaSrcOverCtx(void *ctx, rga_info_t *src, rga_info_t *dst, rga_info_t *src1) {
+        (void)ctx;
+        return SoftRgaSrcOver(src, dst, src1);
+    }
+
+    static int SoftRgaCollorFillCtx(void *ctx, rga_info_t *dst) {
+        (void)ctx;
+        return SoftRgaCollorFill(dst);
+    }
+
+    static int SoftRgaFlushCtx(void *ctx) {
+        (void)ctx;
+        return SoftRgaFlush();
+    }
+
+    static const struct rgaBackend softRgaBackend = {
+        "sw", RGA_BACKEND_SW,
+        SoftRgaInit, SoftRgaDeInit, SoftRgaInit, SoftRgaDeInit,
+        SoftRgaBlitCtx, SoftRgaSrcOverCtx, SoftRgaCollorFillCtx, NULL,
+        SoftRgaFlushCtx, SoftRgaGetVersion, SoftRgaGetPool,
+    };
+
+    /* the context RkRgaBindContext() set for the calling thread */
+    static thread_local void *rgaThreadContext = NULL;
+
+    /* RGA_BACKEND_* of hw, sw or auto, -EINVAL for any other name */
+    static int RkRgaParseBackend(const char *name) {
+        if (strcmp(name, "hw") == 0)
+            return RGA_BACKEND_HW;
+        if (strcmp(name, "sw") == 0)
+            return RGA_BACKEND_SW;
+        if (strcmp(name, "auto") == 0)
+            return RGA_BACKEND_AUTO;
+
+        return -EINVAL;
+    }
+
+    static int RkRgaGetBackendConfig() {
+        int mode;
+#ifdef ANDROID
+        char value[PROPERTY_VALUE_MAX];
+
+        property_get("vendor.rga.backend", value, "auto");
+#else
+        const char *value = getenv("RGA_BACKEND");
+
+        if (!value)
+            return RGA_BACKEND_AUTO;
+#endif
+        mode = RkRgaParseBackend(value);
+        if (mode < 0) {
+            ALOGE("Unknown rga backend '%s', use auto.", value);
+            mode = RGA_BACKEND_AUTO;
+        }
+
+        return mode;
+    }
+
     RockchipRga::RockchipRga():
         mSupportRga(false),
         mLogOnce(0),
         mLogAlways(0),
-        mContext(NULL) {
+        mContext(NULL),
+        mBackendMode(RGA_BACKEND_AUTO),
+        mBackend(NULL) {
         RkRgaInit();
         ALOGE("Rga built version:%s", RK_GRAPHICS_VER);
     }
 
     RockchipRga::~RockchipRga() {
-        RgaDeInit(mContext);
+        if (mBackend)
+            mBackend->deinit(mContext);
     }
 
     int RockchipRga::RkRgaInit() {
-        int ret = 0;
-
         if (mSupportRga)
             return 0;
 
-        ret = RgaInit(&mContext);
-        if(ret == 0)
+        return RkRgaInitBackend(RkRgaGetBackendConfig());
+    }
+
+    int RockchipRga::RkRgaSetBackend(const char *name) {
+        int mode = RkRgaParseBackend(name);
+
+        if (mode < 0) {
+            ALOGE("Unknown rga backend '%s'.", name);
+            return mode;
+        }
+
+        RkRgaDeInit();
+        return RkRgaInitBackend(mode);
+    }
+
+    int RockchipRga::RkRgaInitBackend(int mode) {
+        int ret = 0;
+
+        mBackendMode = mode;
+
+        if (mBackendMode != RGA_BACKEND_SW) {
+            ret = normalRgaBackend.init(&mContext);
+            if (ret == 0) {
+                mBackend = &normalRgaBackend;
+                mSupportRga = true;
+                return 0;
+            }
+
+            if (mBackendMode == RGA_BACKEND_HW) {
+                mSupportRga = false;
+                return ret;
+            }
+
+            ALOGE("Rga device is not available, fall back to the cpu backend.");
+        }
+
+        ret = softRgaBackend.init(&mContext);
+        if (ret == 0) {
+            mBackend = &softRgaBackend;
             mSupportRga = true;
-        else
+        } else {
             mSupportRga = false;
+        }
 
         return ret;
     }
 
     void RockchipRga::RkRgaDeInit() {
-        if (mSupportRga)
-            RgaDeInit(mContext);
+        if (mSupportRga && mBackend)
+            mBackend->deinit(mContext);
 
+        mBackend = NULL;
         mSupportRga = false;
     }
 
+    int RockchipRga::RkRgaGetBackend() {
+        return mBackend ? mBackend->type : RGA_BACKEND_AUTO;
+    }
+
+    const struct rgaBackend *RockchipRga::RkRgaBackend() {
+        return mBackend ? mBackend : &normalRgaBackend;
+    }
+
+    void *RockchipRga::RkRgaContext() {
+        return rgaThreadContext ? rgaThreadContext : mContext;
+    }
+
+    int RockchipRga::RkRgaCreateContext(void **ctx) {
+        int ret;
+
+        if (!ctx)
+            return -EINVAL;
+
+        if (!mSupportRga || !mBackend) {
+            ALOGE("Try to create a context before rga init");
+            return -ENODEV;
+        }
+
+        ret = mBackend->create_context(ctx);
+        if (ret) {
+            ALOGE("Create %s rga context failed, %d", mBackend->name, ret);
+        }
+
+        return ret;
+    }
+
+    int RockchipRga::RkRgaDestroyContext(void *ctx) {
+        if (!ctx || !mBackend)
+            return -EINVAL;
+
+        if (rgaThreadContext == ctx)
+            rgaThreadContext = NULL;
+
+        return mBackend->destroy_context(ctx);
+    }
+
+    void *RockchipRga::RkRgaBindContext(void *ctx) {
+        void *prev = rgaThreadContext;
+
+        rgaThreadContext = ctx;
+        return prev;
+    }
+
 #ifdef LINUX
     int RockchipRga::RkRgaAllocBuffer(int drm_fd, bo_t *bo_info, int width,
                                       int height, int bpp, int flags) {
@@ -161,6 +326,24 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
 #endif
     }
 
+    static pthread_once_t rgaAllocPoolOnce = PTHREAD_ONCE_INIT;
+    static struct rgaAllocPool *rgaAllocPool = NULL;
+
+    static void RkRgaAllocPoolInit() {
+        const char *value = getenv("RGA_ALLOC_POOL_MB");
+        size_t budget = RGA_ALLOC_POOL_BUDGET;
+
+        if (value)
+            budget = (size_t)atoi(value) << 20;
+
+        rgaAllocPool = RgaAllocPoolCreate(budget);
+    }
+
+    static struct rgaAllocPool *RkRgaAllocPool() {
+        pthread_once(&rgaAllocPoolOnce, RkRgaAllocPoolInit);
+        return rgaAllocPool;
+    }
+
 	int RockchipRga::RkRgaGetAllocBufferExt(bo_t *bo_info, int width, int height, int bpp, int flags) {
         static const char* card = "/dev/dri/card0";
         int ret;
@@ -171,17 +354,24 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
 #endif
         bo_info->fd = -1;
         bo_info->handle = 0;
+        bo_info->ptr = NULL;
+
+        if (RgaAllocPoolGet(RkRgaAllocPool(), width, height, bpp, flags, bo_info) == 0)
+            return 0;
+
         drm_fd = open(card, flag);
         if (drm_fd < 0) {
             fprintf(stderr, "Fail to open %s: %m\n", card);
             return -errno;
         }
-        ret = RkRgaAllocBuffer(drm_fd, bo_info, width, height, bpp, flags);
+        /* the height of the size class, so that the buffer can serve the next allocation */
+        ret = RkRgaAllocBuffer(drm_fd, bo_info, width, RgaAllocPoolClassHeight(height), bpp, flags);
         if (ret) {
             close(drm_fd);
             return ret;
         }
         bo_info->fd = drm_fd;
+        RgaAllocPoolAdd(RkRgaAllocPool(), width, height, bpp, flags, bo_info);
         return 0;
     }
 
@@ -199,6 +389,10 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
         void *map;
         int ret;
 
+        /* a buffer of the pool keeps its mapping */
+        if (RgaAllocPoolMap(RkRgaAllocPool(), bo_info) == 0)
+            return 0;
+
         memset(&arg, 0, sizeof(arg));
         arg.handle = bo_info->handle;
         ret = drmIoctl(bo_info->fd, DRM_IOCTL_MODE_MAP_DUMB, &arg);
@@ -208,6 +402,7 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
         if (map == MAP_FAILED)
             return -EINVAL;
         bo_info->ptr = map;
+        RgaAllocPoolSetMap(RkRgaAllocPool(), bo_info);
         return 0;
 #else
         return -1;
@@ -215,7 +410,9 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
     }
 
     int RockchipRga::RkRgaUnmap(bo_t *bo_info) {
-        munmap(bo_info->ptr, bo_info->size);
+        /* the pool unmaps its buffers when it releases them */
+        if (RgaAllocPoolMap(RkRgaAllocPool(), bo_info) != 0)
+            munmap(bo_info->ptr, bo_info->size);
         bo_info->ptr = NULL;
         return 0;
     }
@@ -224,12 +421,30 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
         int ret;
         if (bo_info->fd < 0)
             return -EINVAL;
+        if (RgaAllocPoolPut(RkRgaAllocPool(), bo_info) == 0)
+            return 0;
         ret = RkRgaFreeBuffer(bo_info->fd, bo_info);
         close(bo_info->fd);
         bo_info->fd = -1;
         return ret;
     }
 
+    int RockchipRga::RkRgaAllocPoolQuery(rga_alloc_pool_info_t *info) {
+        if (!info)
+            return -EINVAL;
+
+        RgaAllocPoolQuery(RkRgaAllocPool(), info);
+        return 0;
+    }
+
+    size_t RockchipRga::RkRgaAllocPoolTrim(size_t keep) {
+        return RgaAllocPoolTrim(RkRgaAllocPool(), keep);
+    }
+
+    void RockchipRga::RkRgaAllocPoolSetBudget(size_t budget) {
+        RgaAllocPoolSetBudget(RkRgaAllocPool(), budget);
+    }
+
     int RockchipRga::RkRgaGetBufferFd(bo_t *bo_info, int *fd) {
 #if LIBDRM
         int ret = 0;
@@ -257,7 +472,7 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
 
     int RockchipRga::RkRgaBlit(rga_info *src, rga_info *dst, rga_info *src1) {
         int ret = 0;
-        ret = RgaBlit(src, dst, src1);
+        ret = RkRgaBackend()->blit(RkRgaContext(), src, dst, src1);
         if (ret) {
             RkRgaLogOutUserPara(src);
             RkRgaLogOutUserPara(dst);
@@ -269,7 +484,7 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
 
     int RockchipRga::RkRgaSrcOver(rga_info *src, rga_info *dst, rga_info *src1) {
         int ret = 0;
-        ret = RgaSrcOver(src, dst, src1);
+        ret = RkRgaBackend()->src_over(RkRgaContext(), src, dst, src1);
         if (ret) {
             RkRgaLogOutUserPara(src);
             RkRgaLogOutUserPara(dst);
@@ -281,22 +496,88 @@ RGA_SINGLETON_STATIC_INSTANCE(RockchipRga)
 
     int RockchipRga::RkRgaFlush() {
         int ret = 0;
-        ret = RgaFlush();
+        ret = RkRgaBackend()->flush(RkRgaContext());
         if (ret) {
             ALOGE("RgaFlush Failed");
         }
         return ret;
     }
 
+    int RockchipRga::RkRgaGetVersion(char *version, int size) {
+        int ret = 0;
+        ret = RkRgaBackend()->get_version(version, size);
+        if (ret) {
+            ALOGE("RgaGetVersion Failed");
+        }
+        return ret;
+    }
+
+    struct rgaPool *RockchipRga::RkRgaGetPool() {
+        if (!mSupportRga || !mBackend || !mBackend->get_pool)
+            return NULL;
+
+        return mBackend->get_pool(RkRgaContext());
+    }
+
+    int RockchipRga::RkRgaPoolQuery(rga_pool_info_t *info) {
+        if (!info)
+            return -EINVAL;
+
+        RgaPoolQuery(RkRgaGetPool(), info);
+        return 0;
+    }
+
+    size_t RockchipRga::RkRgaPoolTrim(int idle_ms) {
+        return RgaPoolTrim(RkRgaGetPool(), idle_ms);
+    }
+
+    int RockchipRga::RkRgaPaletteCacheQuery(rga_palette_cache_info_t *info) {
+        if (!info)
+            return -EINVAL;
+
+        memset(info, 0, sizeof(rga_palette_cache_info_t));
+        NormalRgaPaletteCacheQuery(&info->enabled, &info->hits, &info->misses);
+        return 0;
+    }
+
     int RockchipRga::RkRgaCollorFill(rga_info *dst) {
         int ret = 0;
-        ret = RgaCollorFill(dst);
+        ret = RkRgaBackend()->fill(RkRgaContext(), dst);
         return ret;
     }
 
+    int RockchipRga::RkRgaSoftBlit(rga_info *src, rga_info *dst, rga_info *src1) {
+        int ret = 0;
+
+        /* the buffers may still be in use by queued hardware jobs. */
+        if (mBackend == &normalRgaBackend)
+            NormalRgaFlush(RkRgaContext());
+
+        ret = SoftRgaBlit(src, dst, src1);
+        if (ret) {
+            RkRgaLogOutUserPara(src);
+            RkRgaLogOutUserPara(dst);
+            RkRgaLogOutUserPara(src1);
+            ALOGE("This output the user patamaters when soft rga call blit fail");
+        }
+        return ret;
+    }
+
+    int RockchipRga::RkRgaSoftCollorFill(rga_info *dst) {
+        if (mBackend == &normalRgaBackend)
+            NormalRgaFlush(RkRgaContext());
+
+        return SoftRgaCollorFill(dst);
+    }
+
     int RockchipRga::RkRgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut) {
         int ret = 0;
-        ret = RgaCollorPalette(src, dst, lut);
+        if (!RkRgaBackend()->palette) {
+            ALOGE("CollorPalette is not supported by the %s backend", RkRgaBackend()->name);
+            return -EINVAL;
+        }
+
+        ret = RkRgaBackend()->palette(RkRgaContext(), src, dst, lut);
         if (ret) {
             RkRgaLogOutUserPara(src);
             RkRgaLogOutUserPara(dst);
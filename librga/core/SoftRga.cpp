@@ -0,0 +1,1394 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "SoftRga.h"
+#include "NormalRga.h"
+#include "NormalRgaContext.h"
+
+#ifdef ANDROID
+#include "GrallocOps.h"
+#endif
+
+#include <sys/ioctl.h>
+#include <linux/types.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SOFT_RGA_NEON 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SOFT_RGA_AVX2 1
+#define SOFT_RGA_SSE2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SOFT_RGA_SSE2 1
+#endif
+
+/* linux/dma-buf.h is missing from some toolchains, keep a private copy of the sync ioctl. */
+struct soft_dma_buf_sync {
+    __u64 flags;
+};
+
+#define SOFT_DMA_BUF_SYNC_READ      (1 << 0)
+#define SOFT_DMA_BUF_SYNC_WRITE     (2 << 0)
+#define SOFT_DMA_BUF_SYNC_START     (0 << 2)
+#define SOFT_DMA_BUF_SYNC_END       (1 << 2)
+#define SOFT_DMA_BUF_IOCTL_SYNC     _IOW('b', 0, struct soft_dma_buf_sync)
+
+/* same rounding as the hardware, alpha' = alpha + (alpha >> 7) */
+#define SOFT_ALPHA(a) ((a) + ((a) >> 7))
+
+enum {
+    SOFT_TYPE_RGB = 0,
+    SOFT_TYPE_SP,       /* Y + interleaved UV */
+    SOFT_TYPE_P,        /* Y + U + V */
+    SOFT_TYPE_PACKED,   /* YUYV and friends */
+    SOFT_TYPE_Y400,
+};
+
+struct soft_image {
+    int format;
+    int type;
+    int bpp;            /* rgb only */
+    int ys;             /* vertical chroma subsampling shift */
+    bool uv_swap;       /* CrCb order */
+    int y_off[2];       /* packed only, byte offset of Y0/Y1 in a 4 byte group */
+    int u_off;
+    int v_off;
+
+    int x, y, w, h;
+    int vw, vh;
+
+    uint8_t *plane[3];
+    int stride[3];
+
+    void *map;
+    size_t map_size;
+    int fd;
+    int sync_flags;
+};
+
+struct soft_csc {
+    /* yuv to rgb, Q10 */
+    int y_off, y_mul, v_r, u_g, v_g, u_b;
+    /* rgb to yuv, Q10 */
+    int y_base, yr, yg, yb, ur, ug, ub, vr, vg, vb;
+};
+
+static inline uint8_t soft_clamp(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+bool SoftRgaIsFormatSupported(int format) {
+    switch (format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_BGRA_8888:
+        case RK_FORMAT_BGRX_8888:
+        case RK_FORMAT_RGB_888:
+        case RK_FORMAT_BGR_888:
+        case RK_FORMAT_RGB_565:
+        case RK_FORMAT_RGBA_5551:
+        case RK_FORMAT_RGBA_4444:
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+        case RK_FORMAT_YCbCr_420_P:
+        case RK_FORMAT_YCrCb_420_P:
+        case RK_FORMAT_YCbCr_422_P:
+        case RK_FORMAT_YCrCb_422_P:
+        case RK_FORMAT_YUYV_422:
+        case RK_FORMAT_YVYU_422:
+        case RK_FORMAT_UYVY_422:
+        case RK_FORMAT_VYUY_422:
+        case RK_FORMAT_YCbCr_400:
+            return true;
+    }
+
+    return false;
+}
+
+static int soft_rgb_bpp(int format) {
+    switch (format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_BGRA_8888:
+        case RK_FORMAT_BGRX_8888:
+            return 4;
+        case RK_FORMAT_RGB_888:
+        case RK_FORMAT_BGR_888:
+            return 3;
+        case RK_FORMAT_RGB_565:
+        case RK_FORMAT_RGBA_5551:
+        case RK_FORMAT_RGBA_4444:
+            return 2;
+    }
+
+    return 0;
+}
+
+static void soft_set_layout(struct soft_image *img) {
+    int format = img->format;
+
+    switch (format) {
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+            img->type = SOFT_TYPE_SP;
+            img->ys = (format == RK_FORMAT_YCbCr_420_SP || format == RK_FORMAT_YCrCb_420_SP);
+            img->uv_swap = (format == RK_FORMAT_YCrCb_420_SP || format == RK_FORMAT_YCrCb_422_SP);
+            break;
+        case RK_FORMAT_YCbCr_420_P:
+        case RK_FORMAT_YCrCb_420_P:
+        case RK_FORMAT_YCbCr_422_P:
+        case RK_FORMAT_YCrCb_422_P:
+            img->type = SOFT_TYPE_P;
+            img->ys = (format == RK_FORMAT_YCbCr_420_P || format == RK_FORMAT_YCrCb_420_P);
+            img->uv_swap = (format == RK_FORMAT_YCrCb_420_P || format == RK_FORMAT_YCrCb_422_P);
+            break;
+        case RK_FORMAT_YUYV_422:
+            img->type = SOFT_TYPE_PACKED;
+            img->y_off[0] = 0; img->u_off = 1; img->y_off[1] = 2; img->v_off = 3;
+            break;
+        case RK_FORMAT_YVYU_422:
+            img->type = SOFT_TYPE_PACKED;
+            img->y_off[0] = 0; img->v_off = 1; img->y_off[1] = 2; img->u_off = 3;
+            break;
+        case RK_FORMAT_UYVY_422:
+            img->type = SOFT_TYPE_PACKED;
+            img->u_off = 0; img->y_off[0] = 1; img->v_off = 2; img->y_off[1] = 3;
+            break;
+        case RK_FORMAT_VYUY_422:
+            img->type = SOFT_TYPE_PACKED;
+            img->v_off = 0; img->y_off[0] = 1; img->u_off = 2; img->y_off[1] = 3;
+            break;
+        case RK_FORMAT_YCbCr_400:
+            img->type = SOFT_TYPE_Y400;
+            break;
+        default:
+            img->type = SOFT_TYPE_RGB;
+            img->bpp = soft_rgb_bpp(format);
+            break;
+    }
+}
+
+static size_t soft_image_size(const struct soft_image *img) {
+    size_t luma = (size_t)img->vw * img->vh;
+
+    switch (img->type) {
+        case SOFT_TYPE_SP:
+        case SOFT_TYPE_P:
+            return luma + (luma >> img->ys);
+        case SOFT_TYPE_PACKED:
+            return luma * 2;
+        case SOFT_TYPE_Y400:
+            return luma;
+        default:
+            return luma * img->bpp;
+    }
+}
+
+static void soft_set_planes(struct soft_image *img, uint8_t *base) {
+    size_t luma = (size_t)img->vw * img->vh;
+
+    img->plane[0] = base;
+    switch (img->type) {
+        case SOFT_TYPE_SP:
+            img->stride[0] = img->vw;
+            img->plane[1] = base + luma;
+            img->stride[1] = img->vw;
+            break;
+        case SOFT_TYPE_P:
+            img->stride[0] = img->vw;
+            img->stride[1] = img->stride[2] = img->vw / 2;
+            /* plane[1] is always U */
+            if (img->uv_swap) {
+                img->plane[2] = base + luma;
+                img->plane[1] = img->plane[2] + ((luma / 2) >> img->ys);
+            } else {
+                img->plane[1] = base + luma;
+                img->plane[2] = img->plane[1] + ((luma / 2) >> img->ys);
+            }
+            break;
+        case SOFT_TYPE_PACKED:
+            img->stride[0] = img->vw * 2;
+            break;
+        case SOFT_TYPE_Y400:
+            img->stride[0] = img->vw;
+            break;
+        default:
+            img->stride[0] = img->vw * img->bpp;
+            break;
+    }
+}
+
+static int soft_image_map_fd(struct soft_image *img, int fd, bool write) {
+    struct soft_dma_buf_sync sync;
+    size_t size = soft_image_size(img);
+    off_t end;
+    void *map;
+
+    /* dma-buf and memfd report their size, trust the rect otherwise. */
+    end = lseek(fd, 0, SEEK_END);
+    if (end > 0) {
+        if ((size_t)end < size) {
+            ALOGE("soft rga: fd %d is %ld bytes, need %zu", fd, (long)end, size);
+            return -EINVAL;
+        }
+        size = end;
+    }
+
+    map = mmap(NULL, size, write ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ALOGE("soft rga: mmap fd %d fail: %s", fd, strerror(errno));
+        return -errno;
+    }
+
+    img->map = map;
+    img->map_size = size;
+    img->fd = fd;
+    img->sync_flags = write ? (SOFT_DMA_BUF_SYNC_READ | SOFT_DMA_BUF_SYNC_WRITE) : SOFT_DMA_BUF_SYNC_READ;
+
+    /* not a dma-buf if this fails, nothing to sync then. */
+    sync.flags = SOFT_DMA_BUF_SYNC_START | img->sync_flags;
+    ioctl(fd, SOFT_DMA_BUF_IOCTL_SYNC, &sync);
+
+    soft_set_planes(img, (uint8_t *)map);
+
+    return 0;
+}
+
+static void soft_image_unmap(struct soft_image *img) {
+    struct soft_dma_buf_sync sync;
+
+    if (!img->map)
+        return;
+
+    sync.flags = SOFT_DMA_BUF_SYNC_END | img->sync_flags;
+    ioctl(img->fd, SOFT_DMA_BUF_IOCTL_SYNC, &sync);
+
+    munmap(img->map, img->map_size);
+    img->map = NULL;
+}
+
+static int soft_image_init(rga_info_t *info, struct soft_image *img, bool write) {
+    rga_rect_t rect;
+    void *buf = NULL;
+
+    memset(img, 0, sizeof(struct soft_image));
+    img->fd = -1;
+    memcpy(&rect, &info->rect, sizeof(rga_rect_t));
+
+#ifdef ANDROID
+    if ((rect.width <= 0 || rect.height <= 0) && info->hnd)
+        NormalRgaGetRect(info->hnd, &rect);
+#endif
+
+    if (rect.wstride == 0)
+        rect.wstride = rect.width;
+    if (rect.hstride == 0)
+        rect.hstride = rect.height;
+
+    img->format = RkRgaGetRgaFormat(rect.format);
+    if (!SoftRgaIsFormatSupported(img->format)) {
+        ALOGE("soft rga: unsupported format 0x%x", rect.format);
+        return -EINVAL;
+    }
+    soft_set_layout(img);
+
+    if (rect.width <= 0 || rect.height <= 0 || rect.xoffset < 0 || rect.yoffset < 0 ||
+        rect.xoffset + rect.width > rect.wstride || rect.yoffset + rect.height > rect.hstride) {
+        ALOGE("soft rga: err rect[%d,%d,%d,%d][%d,%d]", rect.xoffset, rect.yoffset,
+              rect.width, rect.height, rect.wstride, rect.hstride);
+        return -EINVAL;
+    }
+
+    img->x = rect.xoffset;
+    img->y = rect.yoffset;
+    img->w = rect.width;
+    img->h = rect.height;
+    img->vw = rect.wstride;
+    img->vh = rect.hstride;
+
+    if (info->phyAddr) {
+        ALOGE("soft rga: physical address is not accessible by the cpu.");
+        return -EINVAL;
+    } else if (info->fd > 0) {
+        return soft_image_map_fd(img, info->fd, write);
+    } else if (info->virAddr) {
+        buf = info->virAddr;
+    }
+#ifdef ANDROID
+    else if (info->hnd) {
+        RkRgaGetHandleMapAddress(info->hnd, &buf);
+    }
+#endif
+
+    if (!buf) {
+        ALOGE("soft rga: no address available in buffer.");
+        return -EINVAL;
+    }
+
+    soft_set_planes(img, (uint8_t *)buf);
+
+    return 0;
+}
+
+/*
+ * The field layout follows dst->color_space_mode, 0 means what RgaBlit()
+ * programs by default: yuv to rgb 0x1, rgb to yuv 0x2 << 2.
+ */
+static void soft_csc_init(struct soft_csc *csc, int mode) {
+    switch (mode & 0x3) {
+        case 2: /* BT.601 limit */
+            csc->y_off = 16; csc->y_mul = 1192;
+            csc->v_r = 1634; csc->u_g = 401; csc->v_g = 833; csc->u_b = 2066;
+            break;
+        case 3: /* BT.709 limit */
+            csc->y_off = 16; csc->y_mul = 1192;
+            csc->v_r = 1836; csc->u_g = 218; csc->v_g = 546; csc->u_b = 2163;
+            break;
+        default: /* BT.601 full */
+            csc->y_off = 0; csc->y_mul = 1024;
+            csc->v_r = 1436; csc->u_g = 352; csc->v_g = 731; csc->u_b = 1815;
+            break;
+    }
+
+    switch ((mode >> 2) & 0x3) {
+        case 1: /* BT.601 limit */
+            csc->y_base = 16;
+            csc->yr = 263;  csc->yg = 516;  csc->yb = 100;
+            csc->ur = -152; csc->ug = -298; csc->ub = 450;
+            csc->vr = 450;  csc->vg = -377; csc->vb = -73;
+            break;
+        case 3: /* BT.709 limit */
+            csc->y_base = 16;
+            csc->yr = 187;  csc->yg = 629;  csc->yb = 63;
+            csc->ur = -103; csc->ug = -347; csc->ub = 450;
+            csc->vr = 450;  csc->vg = -409; csc->vb = -41;
+            break;
+        default: /* BT.601 full */
+            csc->y_base = 0;
+            csc->yr = 306;  csc->yg = 601;  csc->yb = 117;
+            csc->ur = -173; csc->ug = -339; csc->ub = 512;
+            csc->vr = 512;  csc->vg = -429; csc->vb = -83;
+            break;
+    }
+}
+
+static inline void soft_yuv_to_rgba(const struct soft_csc *csc, int y, int u, int v, uint8_t *out) {
+    int c = (y - csc->y_off) * csc->y_mul + 512;
+
+    u -= 128;
+    v -= 128;
+    out[0] = soft_clamp((c + csc->v_r * v) >> 10);
+    out[1] = soft_clamp((c - csc->u_g * u - csc->v_g * v) >> 10);
+    out[2] = soft_clamp((c + csc->u_b * u) >> 10);
+    out[3] = 0xff;
+}
+
+static inline uint8_t soft_rgb_to_y(const struct soft_csc *csc, const uint8_t *p) {
+    return soft_clamp(((csc->yr * p[0] + csc->yg * p[1] + csc->yb * p[2] + 512) >> 10) + csc->y_base);
+}
+
+static inline void soft_rgb_to_uv(const struct soft_csc *csc, int r, int g, int b, uint8_t *u, uint8_t *v) {
+    *u = soft_clamp(((csc->ur * r + csc->ug * g + csc->ub * b + 512) >> 10) + 128);
+    *v = soft_clamp(((csc->vr * r + csc->vg * g + csc->vb * b + 512) >> 10) + 128);
+}
+
+/************************** vector kernels **************************/
+
+/* RGBA <-> BGRA, the alpha byte is kept */
+static void soft_swap_rb(uint8_t *dst, const uint8_t *src, int w) {
+    int i = 0;
+
+#if SOFT_RGA_NEON
+    for (; i + 16 <= w; i += 16) {
+        uint8x16x4_t v = vld4q_u8(src + i * 4);
+        uint8x16_t t = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = t;
+        vst4q_u8(dst + i * 4, v);
+    }
+#elif SOFT_RGA_SSE2
+    const __m128i mask_ga = _mm_set1_epi32(0xff00ff00);
+    for (; i + 4 <= w; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        __m128i ga = _mm_and_si128(v, mask_ga);
+        __m128i rb = _mm_andnot_si128(mask_ga, v);
+        rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(ga, rb));
+    }
+#endif
+    for (; i < w; i++) {
+        uint8_t r = src[i * 4 + 0];
+        dst[i * 4 + 0] = src[i * 4 + 2];
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = r;
+        dst[i * 4 + 3] = src[i * 4 + 3];
+    }
+}
+
+static void soft_fill32(uint8_t *dst, uint32_t pixel, int w) {
+    int i = 0;
+
+#if SOFT_RGA_NEON
+    uint32x4_t v = vdupq_n_u32(pixel);
+    for (; i + 4 <= w; i += 4)
+        vst1q_u32((uint32_t *)(dst + i * 4), v);
+#elif SOFT_RGA_SSE2
+    __m128i v = _mm_set1_epi32(pixel);
+    for (; i + 4 <= w; i += 4)
+        _mm_storeu_si128((__m128i *)(dst + i * 4), v);
+#endif
+    for (; i < w; i++)
+        memcpy(dst + i * 4, &pixel, 4);
+}
+
+#if SOFT_RGA_SSE2
+/* two pixels of 16bit lanes: s + d * (256 - alpha') >> 8 */
+static inline __m128i soft_src_over_epi16(__m128i s, __m128i d) {
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+    a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+    a = _mm_sub_epi16(_mm_set1_epi16(256), a);
+    return _mm_add_epi16(s, _mm_srli_epi16(_mm_mullo_epi16(d, a), 8));
+}
+#endif
+
+#if SOFT_RGA_AVX2
+static inline __m256i soft_src_over_epi16_avx2(__m256i s, __m256i d) {
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+    a = _mm256_add_epi16(a, _mm256_srli_epi16(a, 7));
+    a = _mm256_sub_epi16(_mm256_set1_epi16(256), a);
+    return _mm256_add_epi16(s, _mm256_srli_epi16(_mm256_mullo_epi16(d, a), 8));
+}
+#endif
+
+/* premultiplied src over with per pixel alpha, the result is written to s */
+static void soft_src_over_row(uint8_t *s, const uint8_t *d, int w) {
+    int i = 0;
+
+#if SOFT_RGA_NEON
+    for (; i + 16 <= w; i += 16) {
+        uint8x16x4_t vs = vld4q_u8(s + i * 4);
+        uint8x16x4_t vd = vld4q_u8(d + i * 4);
+        uint16x8_t a_lo = vmovl_u8(vget_low_u8(vs.val[3]));
+        uint16x8_t a_hi = vmovl_u8(vget_high_u8(vs.val[3]));
+        uint16x8_t inv_lo = vsubq_u16(vdupq_n_u16(256), vaddq_u16(a_lo, vshrq_n_u16(a_lo, 7)));
+        uint16x8_t inv_hi = vsubq_u16(vdupq_n_u16(256), vaddq_u16(a_hi, vshrq_n_u16(a_hi, 7)));
+
+        for (int c = 0; c < 4; c++) {
+            uint16x8_t lo = vshrq_n_u16(vmulq_u16(vmovl_u8(vget_low_u8(vd.val[c])), inv_lo), 8);
+            uint16x8_t hi = vshrq_n_u16(vmulq_u16(vmovl_u8(vget_high_u8(vd.val[c])), inv_hi), 8);
+            lo = vaddq_u16(lo, vmovl_u8(vget_low_u8(vs.val[c])));
+            hi = vaddq_u16(hi, vmovl_u8(vget_high_u8(vs.val[c])));
+            vs.val[c] = vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi));
+        }
+        vst4q_u8(s + i * 4, vs);
+    }
+#else
+#if SOFT_RGA_AVX2
+    const __m256i zero256 = _mm256_setzero_si256();
+    for (; i + 8 <= w; i += 8) {
+        __m256i vs = _mm256_loadu_si256((const __m256i *)(s + i * 4));
+        __m256i vd = _mm256_loadu_si256((const __m256i *)(d + i * 4));
+        __m256i lo = soft_src_over_epi16_avx2(_mm256_unpacklo_epi8(vs, zero256),
+                                              _mm256_unpacklo_epi8(vd, zero256));
+        __m256i hi = soft_src_over_epi16_avx2(_mm256_unpackhi_epi8(vs, zero256),
+                                              _mm256_unpackhi_epi8(vd, zero256));
+        _mm256_storeu_si256((__m256i *)(s + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+#endif
+#if SOFT_RGA_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= w; i += 4) {
+        __m128i vs = _mm_loadu_si128((const __m128i *)(s + i * 4));
+        __m128i vd = _mm_loadu_si128((const __m128i *)(d + i * 4));
+        __m128i lo = soft_src_over_epi16(_mm_unpacklo_epi8(vs, zero), _mm_unpacklo_epi8(vd, zero));
+        __m128i hi = soft_src_over_epi16(_mm_unpackhi_epi8(vs, zero), _mm_unpackhi_epi8(vd, zero));
+        _mm_storeu_si128((__m128i *)(s + i * 4), _mm_packus_epi16(lo, hi));
+    }
+#endif
+#endif
+    for (; i < w; i++) {
+        int inv = 256 - SOFT_ALPHA(s[i * 4 + 3]);
+
+        for (int c = 0; c < 4; c++)
+            s[i * 4 + c] = soft_clamp(s[i * 4 + c] + ((d[i * 4 + c] * inv) >> 8));
+    }
+}
+
+/************************** row unpack / pack **************************/
+
+static void soft_unpack_row(const struct soft_image *img, int row, int x, int w,
+                            uint8_t *out, const struct soft_csc *csc) {
+    const uint8_t *p = img->plane[0] + (size_t)row * img->stride[0];
+    const uint8_t *pu, *pv;
+    int i;
+
+    switch (img->type) {
+        case SOFT_TYPE_RGB:
+            p += x * img->bpp;
+            switch (img->format) {
+                case RK_FORMAT_RGBA_8888:
+                    memcpy(out, p, w * 4);
+                    break;
+                case RK_FORMAT_RGBX_8888:
+                    for (i = 0; i < w; i++) {
+                        memcpy(out + i * 4, p + i * 4, 3);
+                        out[i * 4 + 3] = 0xff;
+                    }
+                    break;
+                case RK_FORMAT_BGRA_8888:
+                    soft_swap_rb(out, p, w);
+                    break;
+                case RK_FORMAT_BGRX_8888:
+                    soft_swap_rb(out, p, w);
+                    for (i = 0; i < w; i++)
+                        out[i * 4 + 3] = 0xff;
+                    break;
+                case RK_FORMAT_RGB_888:
+                    for (i = 0; i < w; i++) {
+                        memcpy(out + i * 4, p + i * 3, 3);
+                        out[i * 4 + 3] = 0xff;
+                    }
+                    break;
+                case RK_FORMAT_BGR_888:
+                    for (i = 0; i < w; i++) {
+                        out[i * 4 + 0] = p[i * 3 + 2];
+                        out[i * 4 + 1] = p[i * 3 + 1];
+                        out[i * 4 + 2] = p[i * 3 + 0];
+                        out[i * 4 + 3] = 0xff;
+                    }
+                    break;
+                case RK_FORMAT_RGB_565:
+                    for (i = 0; i < w; i++) {
+                        int v = p[i * 2] | (p[i * 2 + 1] << 8);
+                        int r = (v >> 11) & 0x1f, g = (v >> 5) & 0x3f, b = v & 0x1f;
+                        out[i * 4 + 0] = (r << 3) | (r >> 2);
+                        out[i * 4 + 1] = (g << 2) | (g >> 4);
+                        out[i * 4 + 2] = (b << 3) | (b >> 2);
+                        out[i * 4 + 3] = 0xff;
+                    }
+                    break;
+                case RK_FORMAT_RGBA_5551:
+                    for (i = 0; i < w; i++) {
+                        int v = p[i * 2] | (p[i * 2 + 1] << 8);
+                        int r = (v >> 11) & 0x1f, g = (v >> 6) & 0x1f, b = (v >> 1) & 0x1f;
+                        out[i * 4 + 0] = (r << 3) | (r >> 2);
+                        out[i * 4 + 1] = (g << 3) | (g >> 2);
+                        out[i * 4 + 2] = (b << 3) | (b >> 2);
+                        out[i * 4 + 3] = (v & 0x1) ? 0xff : 0;
+                    }
+                    break;
+                case RK_FORMAT_RGBA_4444:
+                    for (i = 0; i < w; i++) {
+                        int v = p[i * 2] | (p[i * 2 + 1] << 8);
+                        out[i * 4 + 0] = ((v >> 12) & 0xf) * 17;
+                        out[i * 4 + 1] = ((v >> 8) & 0xf) * 17;
+                        out[i * 4 + 2] = ((v >> 4) & 0xf) * 17;
+                        out[i * 4 + 3] = (v & 0xf) * 17;
+                    }
+                    break;
+            }
+            break;
+
+        case SOFT_TYPE_SP:
+            pu = img->plane[1] + (size_t)(row >> img->ys) * img->stride[1];
+            for (i = 0; i < w; i++) {
+                const uint8_t *c = pu + ((x + i) & ~1);
+                if (img->uv_swap)
+                    soft_yuv_to_rgba(csc, p[x + i], c[1], c[0], out + i * 4);
+                else
+                    soft_yuv_to_rgba(csc, p[x + i], c[0], c[1], out + i * 4);
+            }
+            break;
+
+        case SOFT_TYPE_P:
+            pu = img->plane[1] + (size_t)(row >> img->ys) * img->stride[1];
+            pv = img->plane[2] + (size_t)(row >> img->ys) * img->stride[2];
+            for (i = 0; i < w; i++)
+                soft_yuv_to_rgba(csc, p[x + i], pu[(x + i) >> 1], pv[(x + i) >> 1], out + i * 4);
+            break;
+
+        case SOFT_TYPE_PACKED:
+            for (i = 0; i < w; i++) {
+                const uint8_t *g = p + ((x + i) >> 1) * 4;
+                soft_yuv_to_rgba(csc, g[img->y_off[(x + i) & 1]], g[img->u_off], g[img->v_off], out + i * 4);
+            }
+            break;
+
+        case SOFT_TYPE_Y400:
+            for (i = 0; i < w; i++)
+                soft_yuv_to_rgba(csc, p[x + i], 128, 128, out + i * 4);
+            break;
+    }
+}
+
+/* 4:2:0 formats take their chroma from the even rows, 2 pixels are averaged horizontally. */
+static void soft_pack_row(struct soft_image *img, int row, int x, int w,
+                          const uint8_t *in, const struct soft_csc *csc) {
+    uint8_t *p = img->plane[0] + (size_t)row * img->stride[0];
+    uint8_t *pu = NULL, *pv = NULL;
+    bool chroma = !(img->ys && (row & 1));
+    int i;
+
+    switch (img->type) {
+        case SOFT_TYPE_RGB:
+            p += x * img->bpp;
+            switch (img->format) {
+                case RK_FORMAT_RGBA_8888:
+                    memcpy(p, in, w * 4);
+                    break;
+                case RK_FORMAT_RGBX_8888:
+                    for (i = 0; i < w; i++) {
+                        memcpy(p + i * 4, in + i * 4, 3);
+                        p[i * 4 + 3] = 0xff;
+                    }
+                    break;
+                case RK_FORMAT_BGRA_8888:
+                    soft_swap_rb(p, in, w);
+                    break;
+                case RK_FORMAT_BGRX_8888:
+                    soft_swap_rb(p, in, w);
+                    for (i = 0; i < w; i++)
+                        p[i * 4 + 3] = 0xff;
+                    break;
+                case RK_FORMAT_RGB_888:
+                    for (i = 0; i < w; i++)
+                        memcpy(p + i * 3, in + i * 4, 3);
+                    break;
+                case RK_FORMAT_BGR_888:
+                    for (i = 0; i < w; i++) {
+                        p[i * 3 + 0] = in[i * 4 + 2];
+                        p[i * 3 + 1] = in[i * 4 + 1];
+                        p[i * 3 + 2] = in[i * 4 + 0];
+                    }
+                    break;
+                case RK_FORMAT_RGB_565:
+                    for (i = 0; i < w; i++) {
+                        int v = ((in[i * 4] >> 3) << 11) | ((in[i * 4 + 1] >> 2) << 5) | (in[i * 4 + 2] >> 3);
+                        p[i * 2] = v & 0xff;
+                        p[i * 2 + 1] = v >> 8;
+                    }
+                    break;
+                case RK_FORMAT_RGBA_5551:
+                    for (i = 0; i < w; i++) {
+                        int v = ((in[i * 4] >> 3) << 11) | ((in[i * 4 + 1] >> 3) << 6) |
+                                ((in[i * 4 + 2] >> 3) << 1) | (in[i * 4 + 3] >> 7);
+                        p[i * 2] = v & 0xff;
+                        p[i * 2 + 1] = v >> 8;
+                    }
+                    break;
+                case RK_FORMAT_RGBA_4444:
+                    for (i = 0; i < w; i++) {
+                        int v = ((in[i * 4] >> 4) << 12) | ((in[i * 4 + 1] >> 4) << 8) |
+                                ((in[i * 4 + 2] >> 4) << 4) | (in[i * 4 + 3] >> 4);
+                        p[i * 2] = v & 0xff;
+                        p[i * 2 + 1] = v >> 8;
+                    }
+                    break;
+            }
+            return;
+
+        case SOFT_TYPE_PACKED:
+            p += (x >> 1) * 4;
+            for (i = 0; i < w; i += 2) {
+                const uint8_t *a = in + i * 4;
+                const uint8_t *b = i + 1 < w ? a + 4 : a;
+                p[img->y_off[0]] = soft_rgb_to_y(csc, a);
+                p[img->y_off[1]] = soft_rgb_to_y(csc, b);
+                soft_rgb_to_uv(csc, (a[0] + b[0] + 1) >> 1, (a[1] + b[1] + 1) >> 1,
+                               (a[2] + b[2] + 1) >> 1, &p[img->u_off], &p[img->v_off]);
+                p += 4;
+            }
+            return;
+
+        case SOFT_TYPE_SP:
+        case SOFT_TYPE_P:
+        case SOFT_TYPE_Y400:
+            for (i = 0; i < w; i++)
+                p[x + i] = soft_rgb_to_y(csc, in + i * 4);
+            break;
+    }
+
+    if (img->type == SOFT_TYPE_Y400 || !chroma)
+        return;
+
+    if (img->type == SOFT_TYPE_SP) {
+        pu = img->plane[1] + (size_t)(row >> img->ys) * img->stride[1] + (x & ~1);
+        for (i = 0; i < w; i += 2) {
+            const uint8_t *a = in + i * 4;
+            const uint8_t *b = i + 1 < w ? a + 4 : a;
+            uint8_t u, v;
+            soft_rgb_to_uv(csc, (a[0] + b[0] + 1) >> 1, (a[1] + b[1] + 1) >> 1,
+                           (a[2] + b[2] + 1) >> 1, &u, &v);
+            pu[i] = img->uv_swap ? v : u;
+            pu[i + 1] = img->uv_swap ? u : v;
+        }
+    } else {
+        pu = img->plane[1] + (size_t)(row >> img->ys) * img->stride[1] + (x >> 1);
+        pv = img->plane[2] + (size_t)(row >> img->ys) * img->stride[2] + (x >> 1);
+        for (i = 0; i < w; i += 2) {
+            const uint8_t *a = in + i * 4;
+            const uint8_t *b = i + 1 < w ? a + 4 : a;
+            soft_rgb_to_uv(csc, (a[0] + b[0] + 1) >> 1, (a[1] + b[1] + 1) >> 1,
+                           (a[2] + b[2] + 1) >> 1, &pu[i >> 1], &pv[i >> 1]);
+        }
+    }
+}
+
+/* same format, same size, no transform: plain row copies per plane, src and dst may overlap */
+static void soft_copy_image(const struct soft_image *s, struct soft_image *d) {
+    int i, rows;
+
+    switch (s->type) {
+        case SOFT_TYPE_RGB:
+            for (i = 0; i < s->h; i++)
+                memmove(d->plane[0] + (size_t)(d->y + i) * d->stride[0] + d->x * d->bpp,
+                       s->plane[0] + (size_t)(s->y + i) * s->stride[0] + s->x * s->bpp, s->w * s->bpp);
+            return;
+        case SOFT_TYPE_PACKED:
+            for (i = 0; i < s->h; i++)
+                memmove(d->plane[0] + (size_t)(d->y + i) * d->stride[0] + d->x * 2,
+                       s->plane[0] + (size_t)(s->y + i) * s->stride[0] + s->x * 2, s->w * 2);
+            return;
+        default:
+            for (i = 0; i < s->h; i++)
+                memmove(d->plane[0] + (size_t)(d->y + i) * d->stride[0] + d->x,
+                       s->plane[0] + (size_t)(s->y + i) * s->stride[0] + s->x, s->w);
+            break;
+    }
+
+    rows = (s->h + (1 << s->ys) - 1) >> s->ys;
+
+    if (s->type == SOFT_TYPE_SP) {
+        for (i = 0; i < rows; i++)
+            memmove(d->plane[1] + (size_t)((d->y >> d->ys) + i) * d->stride[1] + (d->x & ~1),
+                   s->plane[1] + (size_t)((s->y >> s->ys) + i) * s->stride[1] + (s->x & ~1), s->w);
+    } else if (s->type == SOFT_TYPE_P) {
+        for (int n = 1; n < 3; n++)
+            for (i = 0; i < rows; i++)
+                memmove(d->plane[n] + (size_t)((d->y >> d->ys) + i) * d->stride[n] + (d->x >> 1),
+                       s->plane[n] + (size_t)((s->y >> s->ys) + i) * s->stride[n] + (s->x >> 1),
+                       (s->w + 1) >> 1);
+    }
+}
+
+/************************** blend **************************/
+
+static bool soft_blend_supported(int mode) {
+    switch (mode) {
+        case 0x0000:
+        case 0x0001:
+        case 0x0002:
+        case 0x0105:
+        case 0x0405:
+        case 0x0501:
+        case 0x0004:
+        case 0x0005:
+        case 0x0600:
+        case 0x0605:
+        case 0x0700:
+        case 0x0704:
+        case 0x0705:
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * The other Porter-Duff modes im2d builds, src factor << 8 | dst factor on
+ * premultiplied colors: 4 sa, 5 1 - sa, 6 da, 7 1 - da, 0 zero.
+ */
+static inline int soft_pd_factor(int f, int sa, int da) {
+    switch (f) {
+        case 4:
+            return sa;
+        case 5:
+            return 0xff - sa;
+        case 6:
+            return da;
+        case 7:
+            return 0xff - da;
+    }
+
+    return 0;
+}
+
+static void soft_pd_row(uint8_t *s, const uint8_t *d, int w, int mode, int ga) {
+    int i, c;
+
+    for (i = 0; i < w; i++, s += 4, d += 4) {
+        if (ga != 0xff) {
+            for (c = 0; c < 4; c++)
+                s[c] = (s[c] * ga + 127) / 255;
+        }
+
+        int fs = soft_pd_factor(mode >> 8, s[3], d[3]);
+        int fd = soft_pd_factor(mode & 0xff, s[3], d[3]);
+        for (c = 0; c < 4; c++)
+            s[c] = soft_clamp((s[c] * fs + d[c] * fd + 127) / 255);
+    }
+}
+
+/*
+ * Mirrors the alpha setup RgaBlit() derives from the blend word:
+ * 0x0105 premultiplied src over, 0x0405 non-premultiplied src over,
+ * 0x0501 premultiplied dst over, the others see soft_pd_row(). Only
+ * RGBA/BGRA_8888 src carry per pixel alpha, other formats use the global
+ * alpha. The result is written to s.
+ */
+static void soft_blend_row(uint8_t *s, const uint8_t *d, int w, unsigned int blend, bool perpixel) {
+    int mode = blend & 0xffff;
+    int ga = (blend >> 16) & 0xff;
+    int ga8 = SOFT_ALPHA(ga);
+    int i, c;
+
+    switch (mode) {
+        case 0x0002:
+            memcpy(s, d, w * 4);
+            return;
+
+        case 0x0105:
+            if (perpixel && ga == 0xff) {
+                soft_src_over_row(s, d, w);
+                return;
+            }
+            for (i = 0; i < w; i++, s += 4, d += 4) {
+                if (perpixel) {
+                    for (c = 0; c < 4; c++)
+                        s[c] = (s[c] * ga8) >> 8;
+                    int inv = 256 - SOFT_ALPHA(s[3]);
+                    for (c = 0; c < 4; c++)
+                        s[c] = soft_clamp(s[c] + ((d[c] * inv) >> 8));
+                } else {
+                    s[3] = 0xff;
+                    for (c = 0; c < 4; c++)
+                        s[c] = (s[c] * ga8 + d[c] * (256 - ga8)) >> 8;
+                }
+            }
+            return;
+
+        case 0x0405:
+            for (i = 0; i < w; i++, s += 4, d += 4) {
+                int sa = perpixel ? (s[3] * ga8) >> 8 : ga;
+                int sa8 = SOFT_ALPHA(sa);
+                for (c = 0; c < 3; c++)
+                    s[c] = (s[c] * sa8 + d[c] * (256 - sa8)) >> 8;
+                s[3] = soft_clamp(sa + ((d[3] * (256 - sa8)) >> 8));
+            }
+            return;
+
+        case 0x0501:
+            for (i = 0; i < w; i++, s += 4, d += 4) {
+                int inv = 256 - SOFT_ALPHA(d[3]);
+                for (c = 0; c < 4; c++)
+                    s[c] = soft_clamp(d[c] + ((s[c] * inv) >> 8));
+            }
+            return;
+
+        case 0x0000:
+        case 0x0001:
+            /* src, or no blend at all */
+            return;
+
+        default:
+            soft_pd_row(s, d, w, mode, ga);
+            return;
+    }
+}
+
+/************************** transform / scale **************************/
+
+/*
+ * Output pixel (x, y) reads source (a, b) with a = fx ? ow - 1 - x : x,
+ * b = fy ? oh - 1 - y : y, swapped when transpose is set.
+ */
+struct soft_transform {
+    bool transpose;
+    bool fx;
+    bool fy;
+};
+
+static int soft_transform_init(struct soft_transform *t, int rotation) {
+    memset(t, 0, sizeof(struct soft_transform));
+
+    switch (rotation & 0x0f) {
+        case 0:
+            break;
+        case HAL_TRANSFORM_FLIP_H:
+            t->fx = true;
+            break;
+        case HAL_TRANSFORM_FLIP_V:
+            t->fy = true;
+            break;
+        case HAL_TRANSFORM_ROT_180:
+        case HAL_TRANSFORM_FLIP_H_V:
+            t->fx = t->fy = true;
+            break;
+        case HAL_TRANSFORM_ROT_90:
+            t->transpose = t->fx = true;
+            break;
+        case HAL_TRANSFORM_ROT_270:
+            t->transpose = t->fy = true;
+            break;
+        default:
+            ALOGE("soft rga: unsupported rotation 0x%x", rotation);
+            return -EINVAL;
+    }
+
+    /* the upper nibble is a flip applied after the rotation */
+    switch ((rotation & 0xf0) >> 4) {
+        case 0:
+            break;
+        case HAL_TRANSFORM_FLIP_H:
+            t->fx = !t->fx;
+            break;
+        case HAL_TRANSFORM_FLIP_V:
+            t->fy = !t->fy;
+            break;
+        case HAL_TRANSFORM_FLIP_H_V:
+            t->fx = !t->fx;
+            t->fy = !t->fy;
+            break;
+        default:
+            ALOGE("soft rga: unsupported rotation 0x%x", rotation);
+            return -EINVAL;
+    }
+
+    return 0;
+}
+
+static void soft_transform_apply(const struct soft_transform *t, const uint32_t *src, int sw, int sh,
+                                 uint32_t *dst) {
+    int ow = t->transpose ? sh : sw;
+    int oh = t->transpose ? sw : sh;
+
+    for (int y = 0; y < oh; y++) {
+        int b = t->fy ? oh - 1 - y : y;
+        uint32_t *out = dst + (size_t)y * ow;
+
+        if (!t->transpose) {
+            const uint32_t *in = src + (size_t)b * sw;
+            if (t->fx) {
+                for (int x = 0; x < ow; x++)
+                    out[x] = in[ow - 1 - x];
+            } else {
+                memcpy(out, in, ow * 4);
+            }
+        } else {
+            for (int x = 0; x < ow; x++) {
+                int a = t->fx ? ow - 1 - x : x;
+                out[x] = src[(size_t)a * sw + b];
+            }
+        }
+    }
+}
+
+/* pixel centers are aligned, weights are Q8 */
+static void soft_scale_table(int src_len, int dst_len, int *idx, int *frac) {
+    for (int i = 0; i < dst_len; i++) {
+        int64_t pos = (((int64_t)(2 * i + 1) * src_len << 16) / (2 * dst_len)) - (1 << 15);
+        if (pos < 0)
+            pos = 0;
+        idx[i] = (int)(pos >> 16);
+        frac[i] = (int)((pos >> 8) & 0xff);
+        if (idx[i] >= src_len - 1) {
+            idx[i] = src_len - 1;
+            frac[i] = 0;
+        }
+    }
+}
+
+static void soft_scale_row(const uint8_t *r0, const uint8_t *r1, int wy, int w,
+                           const int *xi, const int *xf, uint8_t *out) {
+    for (int x = 0; x < w; x++) {
+        const uint8_t *a0 = r0 + xi[x] * 4;
+        const uint8_t *a1 = r1 + xi[x] * 4;
+        int wx = xf[x];
+        int n = wx ? 4 : 0;
+
+        for (int c = 0; c < 4; c++) {
+            int top = a0[c] * (256 - wx) + a0[c + n] * wx;
+            int bot = a1[c] * (256 - wx) + a1[c + n] * wx;
+            out[x * 4 + c] = (top * (256 - wy) + bot * wy + (1 << 15)) >> 16;
+        }
+    }
+}
+
+/************************** entry **************************/
+
+int SoftRgaInit(void **ctx) {
+    struct softRgaContext *soft;
+
+    if (!ctx)
+        return -EINVAL;
+
+    soft = (struct softRgaContext *)malloc(sizeof(struct softRgaContext));
+    if (!soft)
+        return -ENOMEM;
+
+    /* the cpu reads the buffers itself, no need for dma-bufs */
+    soft->pool = RgaPoolCreate(false);
+
+    *ctx = soft;
+    return 0;
+}
+
+int SoftRgaDeInit(void *ctx) {
+    struct softRgaContext *soft = (struct softRgaContext *)ctx;
+
+    if (!soft)
+        return 0;
+
+    RgaPoolDestroy(soft->pool);
+    free(soft);
+    return 0;
+}
+
+struct rgaPool *SoftRgaGetPool(void *ctx) {
+    if (!ctx)
+        return NULL;
+
+    return ((struct softRgaContext *)ctx)->pool;
+}
+
+int SoftRgaFlush() {
+    /* every call is synchronous */
+    return 0;
+}
+
+int SoftRgaGetVersion(char *version, int size) {
+    if (!version || size <= 0)
+        return -EINVAL;
+
+    strncpy(version, SOFT_RGA_VERSION, size - 1);
+    version[size - 1] = '\0';
+    return 0;
+}
+
+int SoftRgaBlit(rga_info_t *src, rga_info_t *dst, rga_info_t *src1) {
+    struct soft_image s, d, s1;
+    struct soft_transform t;
+    struct soft_csc csc;
+    uint8_t *sbuf = NULL, *tbuf = NULL, *row = NULL, *bg = NULL;
+    int *xi = NULL, *xf = NULL, *yi = NULL, *yf = NULL;
+    const uint8_t *img;
+    int mode, rw, rh, ret;
+    bool scale, blend, perpixel;
+
+    if (!src || !dst) {
+        ALOGE("soft rga: src = %p, dst = %p", src, dst);
+        return -EINVAL;
+    }
+
+    if (src->rop_code || dst->nn.nn_flag || src->colorkey_en) {
+        ALOGE("soft rga: rop/quantize/colorkey are not supported.");
+        return -EINVAL;
+    }
+
+    mode = src->blend & 0xffff;
+    if (!soft_blend_supported(mode)) {
+        ALOGE("soft rga: unsupported blend 0x%x", src->blend);
+        return -EINVAL;
+    }
+
+    ret = soft_transform_init(&t, src->rotation);
+    if (ret)
+        return ret;
+
+    memset(&s1, 0, sizeof(s1));
+    ret = soft_image_init(src, &s, false);
+    if (ret)
+        return ret;
+    ret = soft_image_init(dst, &d, true);
+    if (ret)
+        goto out_src;
+    if (src1) {
+        ret = soft_image_init(src1, &s1, false);
+        if (ret)
+            goto out_dst;
+        if (s1.w < d.w || s1.h < d.h) {
+            ALOGE("soft rga: src1 [%d,%d] is smaller than dst [%d,%d]", s1.w, s1.h, d.w, d.h);
+            ret = -EINVAL;
+            goto out;
+        }
+    }
+
+    soft_csc_init(&csc, dst->color_space_mode);
+
+    blend = mode != 0x0000 && mode != 0x0001;
+    perpixel = s.format == RK_FORMAT_RGBA_8888 || s.format == RK_FORMAT_BGRA_8888;
+    rw = t.transpose ? s.h : s.w;
+    rh = t.transpose ? s.w : s.h;
+    scale = rw != d.w || rh != d.h;
+
+    if (!blend && !src1 && !scale && !t.transpose && !t.fx && !t.fy && s.format == d.format) {
+        soft_copy_image(&s, &d);
+        ret = 0;
+        goto out;
+    }
+
+    sbuf = (uint8_t *)malloc((size_t)s.w * s.h * 4);
+    row = (uint8_t *)malloc((size_t)d.w * 4 * 2);
+    if (!sbuf || !row) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    bg = row + d.w * 4;
+
+    for (int y = 0; y < s.h; y++)
+        soft_unpack_row(&s, s.y + y, s.x, s.w, sbuf + (size_t)y * s.w * 4, &csc);
+
+    img = sbuf;
+    if (t.transpose || t.fx || t.fy) {
+        tbuf = (uint8_t *)malloc((size_t)rw * rh * 4);
+        if (!tbuf) {
+            ret = -ENOMEM;
+            goto out;
+        }
+        soft_transform_apply(&t, (const uint32_t *)sbuf, s.w, s.h, (uint32_t *)tbuf);
+        img = tbuf;
+    }
+
+    if (scale) {
+        xi = (int *)malloc(sizeof(int) * (d.w * 2 + d.h * 2));
+        if (!xi) {
+            ret = -ENOMEM;
+            goto out;
+        }
+        xf = xi + d.w;
+        yi = xf + d.w;
+        yf = yi + d.h;
+        soft_scale_table(rw, d.w, xi, xf);
+        soft_scale_table(rh, d.h, yi, yf);
+    }
+
+    for (int y = 0; y < d.h; y++) {
+        if (scale) {
+            const uint8_t *r0 = img + (size_t)yi[y] * rw * 4;
+            const uint8_t *r1 = yf[y] ? r0 + rw * 4 : r0;
+            soft_scale_row(r0, r1, yf[y], d.w, xi, xf, row);
+        } else {
+            memcpy(row, img + (size_t)y * rw * 4, d.w * 4);
+        }
+
+        if (blend) {
+            if (src1)
+                soft_unpack_row(&s1, s1.y + y, s1.x, d.w, bg, &csc);
+            else
+                soft_unpack_row(&d, d.y + y, d.x, d.w, bg, &csc);
+            soft_blend_row(row, bg, d.w, src->blend, perpixel);
+        }
+
+        soft_pack_row(&d, d.y + y, d.x, d.w, row, &csc);
+    }
+    ret = 0;
+
+out:
+    free(xi);
+    free(tbuf);
+    free(row);
+    free(sbuf);
+    soft_image_unmap(&s1);
+out_dst:
+    soft_image_unmap(&d);
+out_src:
+    soft_image_unmap(&s);
+
+    return ret;
+}
+
+int SoftRgaSrcOver(rga_info_t *src, rga_info_t *dst, rga_info_t *src1) {
+    (void)src1; /* unused src1 */
+
+    if (!src || !dst)
+        return -EINVAL;
+
+    if (!(0x0205 == (src->blend & 0xFFFF) &&
+          NormalRgaIsRgbFormat(RkRgaGetRgaFormat(src->rect.format)) &&
+          NormalRgaIsYuvFormat(RkRgaGetRgaFormat(dst->rect.format)))) {
+        ALOGE("soft rga: not src over mode");
+        return -EINVAL;
+    }
+
+    /* the blit reads yuv back as the background itself, no rgba bounce buffer needed. */
+    src->blend = 0xff0105;
+    return SoftRgaBlit(src, dst, NULL);
+}
+
+int SoftRgaCollorFill(rga_info_t *dst) {
+    struct soft_image d;
+    struct soft_csc csc;
+    uint8_t *row;
+    uint8_t rgba[4];
+    uint32_t pixel;
+    int ret;
+
+    if (!dst) {
+        ALOGE("soft rga: dst = %p", dst);
+        return -EINVAL;
+    }
+
+    ret = soft_image_init(dst, &d, true);
+    if (ret)
+        return ret;
+
+    row = (uint8_t *)malloc((size_t)d.w * 4);
+    if (!row) {
+        soft_image_unmap(&d);
+        return -ENOMEM;
+    }
+
+    /* color is 0xAABBGGRR, the byte order of RGBA_8888 in memory */
+    rgba[0] = dst->color & 0xff;
+    rgba[1] = (dst->color >> 8) & 0xff;
+    rgba[2] = (dst->color >> 16) & 0xff;
+    rgba[3] = (dst->color >> 24) & 0xff;
+    memcpy(&pixel, rgba, 4);
+    soft_fill32(row, pixel, d.w);
+
+    soft_csc_init(&csc, dst->color_space_mode);
+
+    if (d.type == SOFT_TYPE_RGB) {
+        uint8_t *first = d.plane[0] + (size_t)d.y * d.stride[0] + d.x * d.bpp;
+
+        soft_pack_row(&d, d.y, d.x, d.w, row, &csc);
+        for (int y = 1; y < d.h; y++)
+            memcpy(first + (size_t)y * d.stride[0], first, d.w * d.bpp);
+    } else {
+        for (int y = 0; y < d.h; y++)
+            soft_pack_row(&d, d.y + y, d.x, d.w, row, &csc);
+    }
+
+    free(row);
+    soft_image_unmap(&d);
+
+    return 0;
+}
+
+/************************** nn tensor **************************/
+
+/* the NN quantize of the rga: (v + offset) * scale, scale is 2.8 fixed point, offset sign + 8bit */
+static void soft_nn_lut(uint8_t *lut, int scale, int offset) {
+    int off = (offset & 0x100) ? -(offset & 0xff) : (offset & 0xff);
+
+    for (int v = 0; v < 256; v++)
+        lut[v] = soft_clamp(((v + off) * (scale & 0x3ff)) >> 8);
+}
+
+/* RGB/BGR_888 to three planes */
+static void soft_planar_row(uint8_t *p0, uint8_t *p1, uint8_t *p2, const uint8_t *src, int w) {
+    int i = 0;
+
+#if SOFT_RGA_NEON
+    for (; i + 16 <= w; i += 16) {
+        uint8x16x3_t v = vld3q_u8(src + i * 3);
+        vst1q_u8(p0 + i, v.val[0]);
+        vst1q_u8(p1 + i, v.val[1]);
+        vst1q_u8(p2 + i, v.val[2]);
+    }
+#endif
+    for (; i < w; i++) {
+        p0[i] = src[i * 3 + 0];
+        p1[i] = src[i * 3 + 1];
+        p2[i] = src[i * 3 + 2];
+    }
+}
+
+int SoftRgaNNTensor(rga_info_t *src, rga_info_t *dst, const rga_nn_t *nn, bool planar) {
+    struct soft_image s, d;
+    uint8_t lut[3][256];
+    size_t plane;
+    int ret;
+
+    if (!src || !dst) {
+        ALOGE("soft rga: src = %p, dst = %p", src, dst);
+        return -EINVAL;
+    }
+
+    ret = soft_image_init(src, &s, false);
+    if (ret)
+        return ret;
+    ret = soft_image_init(dst, &d, true);
+    if (ret) {
+        soft_image_unmap(&s);
+        return ret;
+    }
+
+    if ((s.format != RK_FORMAT_RGB_888 && s.format != RK_FORMAT_BGR_888) ||
+        s.format != d.format || s.w != d.w || s.h != d.h) {
+        ALOGE("soft rga: nn tensor of format 0x%x %dx%d to 0x%x %dx%d", s.format, s.w, s.h,
+              d.format, d.w, d.h);
+        soft_image_unmap(&d);
+        soft_image_unmap(&s);
+        return -EINVAL;
+    }
+
+    if (nn) {
+        /* the lut of each byte of a pixel, the scale/offset follow the channel */
+        bool bgr = s.format == RK_FORMAT_BGR_888;
+
+        soft_nn_lut(lut[0], bgr ? nn->scale_b : nn->scale_r, bgr ? nn->offset_b : nn->offset_r);
+        soft_nn_lut(lut[1], nn->scale_g, nn->offset_g);
+        soft_nn_lut(lut[2], bgr ? nn->scale_r : nn->scale_b, bgr ? nn->offset_r : nn->offset_b);
+    }
+
+    /* planar: one plane of wstride x hstride per channel, in the byte order of the format */
+    plane = (size_t)d.vw * d.vh;
+
+    for (int y = 0; y < s.h; y++) {
+        const uint8_t *in = s.plane[0] + (size_t)(s.y + y) * s.stride[0] + s.x * 3;
+
+        if (planar) {
+            uint8_t *p0 = d.plane[0] + (size_t)(d.y + y) * d.vw + d.x;
+            uint8_t *p1 = p0 + plane;
+            uint8_t *p2 = p1 + plane;
+
+            if (nn) {
+                for (int i = 0; i < s.w; i++) {
+                    p0[i] = lut[0][in[i * 3 + 0]];
+                    p1[i] = lut[1][in[i * 3 + 1]];
+                    p2[i] = lut[2][in[i * 3 + 2]];
+                }
+            } else {
+                soft_planar_row(p0, p1, p2, in, s.w);
+            }
+        } else {
+            uint8_t *out = d.plane[0] + (size_t)(d.y + y) * d.stride[0] + d.x * 3;
+
+            if (nn) {
+                for (int i = 0; i < s.w; i++) {
+                    out[i * 3 + 0] = lut[0][in[i * 3 + 0]];
+                    out[i * 3 + 1] = lut[1][in[i * 3 + 1]];
+                    out[i * 3 + 2] = lut[2][in[i * 3 + 2]];
+                }
+            } else if (out != in) {
+                memmove(out, in, (size_t)s.w * 3);
+            }
+        }
+    }
+
+    soft_image_unmap(&d);
+    soft_image_unmap(&s);
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _rockchip_soft_rga_h_
+#define _rockchip_soft_rga_h_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "drmrga.h"
+#include "rga.h"
+#include "RgaPool.h"
+
+#define SOFT_RGA_VERSION "soft-1.00"
+
+struct softRgaContext {
+    struct rgaPool *pool;
+};
+
+/*
+ * CPU implementation of the RGA blit/fill path. It takes the same rga_info_t
+ * as RgaBlit()/RgaCollorFill(), every call is completed before it returns.
+ *
+ * supported: RGBA/RGBX/BGRA/BGRX_8888, RGB/BGR_888, RGB_565, RGBA_5551,
+ *            RGBA_4444, YCbCr/YCrCb 420/422 SP and P, YUYV/YVYU/UYVY/VYUY_422,
+ *            YCbCr_400.
+ * not supported: BPP/palette, 10bit yuv, Y4, rop, NN quantize, colorkey.
+ */
+int         SoftRgaInit(void **ctx);
+int         SoftRgaDeInit(void *ctx);
+int         SoftRgaBlit(rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
+int         SoftRgaSrcOver(rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
+int         SoftRgaCollorFill(rga_info_t *dst);
+int         SoftRgaFlush();
+int         SoftRgaGetVersion(char *version, int size);
+struct rgaPool *SoftRgaGetPool(void *ctx);
+
+bool        SoftRgaIsFormatSupported(int format);
+
+/*
+ * The cpu tail of imnnpreprocess(): src and dst are RGB_888 or BGR_888 of the
+ * same size, nn (may be NULL) is applied like the NN quantize of the rga and
+ * with planar, dst is written as three planes of wstride x hstride bytes.
+ * src and dst may be the same buffer when planar is not set.
+ */
+int         SoftRgaNNTensor(rga_info_t *src, rga_info_t *dst, const rga_nn_t *nn, bool planar);
+
+#endif
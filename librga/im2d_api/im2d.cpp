@@ -22,14 +22,23 @@
 #ifdef ANDROID
 #include <RockchipRga.h>
 #include "core/NormalRga.h"
+#include "core/SoftRga.h"
 #endif
 
 #ifdef LINUX
 #include "../include/RockchipRga.h"
 #include "../core/NormalRga.h"
+#include "../core/SoftRga.h"
 #endif
 
 #include <sstream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <new>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #ifdef ANDROID
 #include <cutils/properties.h>
@@ -56,9 +65,37 @@ RockchipRga& rkRga(RockchipRga::get());
 #define ALIGN(val, align) (((val) + ((align) - 1)) & ~((align) - 1))
 #define UNUSED(...) (void)(__VA_ARGS__)
 
+/* ms, a fenced job is dropped if its acquire fence is not signaled in time */
+#define RGA_ACQUIRE_FENCE_TIMEOUT 3000
+/* most queued jobs the async worker submits back to back before one flush */
+#define RGA_ASYNC_BATCH 16
+
 using namespace std;
 
-ostringstream err_msg;
+/* per thread, threads running at the same time must not overwrite each other's */
+thread_local ostringstream err_msg;
+
+struct im_context {
+    void *rga;              /* RockchipRga context */
+};
+
+/* the context imbindContext() set for the calling thread, NULL for the shared one */
+static thread_local im_ctx_t rga_thread_ctx = NULL;
+
+/* An operation that passed the check, ready to be submitted to the driver. */
+typedef struct im_task {
+    rga_info_t srcinfo;
+    rga_info_t dstinfo;
+    rga_info_t patinfo;
+    int usage;
+    bool pat_enable;
+    bool soft;          /* the hardware cannot do it, run on the cpu backend */
+    IM_STATUS status;
+} im_task_t;
+
+struct im_job {
+    vector<im_task_t> tasks;
+};
 
 IM_API void imErrorMsg(const char* msg) {
     err_msg.str("");
@@ -77,7 +114,7 @@ IM_API const char* imStrError_t(IM_STATUS status) {
         "unkown status"
     };
     ostringstream error;
-    static string msg;
+    static thread_local string msg;
 
     msg = err_msg.str();
 
@@ -163,6 +200,155 @@ IM_API rga_buffer_t wrapbuffer_fd_t(int fd, int width, int height, int wstride,
 }
 
 #ifdef ANDROID
+/*
+ * Gralloc handle cache
+ *
+ * Resolving a handle takes several gralloc mapper calls, while a decoder or camera
+ * cycles through the same few buffers. A handle is keyed by its address and a copy
+ * of its fds and ints: the handle of a buffer allocated where a freed one was differs
+ * in its fds or gralloc ints, so it cannot match, and the stale entry is dropped.
+ * A lookup is a compare in memory, without a system call. imreleasebuffercache()
+ * drops the entry of a buffer when it is freed.
+ */
+#define RGA_HANDLE_CACHE_SIZE 32
+/* fds and ints of a handle kept, a larger handle is not cached */
+#define RGA_HANDLE_CACHE_DATA 64
+
+typedef struct {
+    buffer_handle_t handle;         /* may be freed already, never dereferenced */
+    int num_fds;
+    int num_ints;
+    int data[RGA_HANDLE_CACHE_DATA];
+    uint64_t last_use;
+    rga_buffer_t buffer;
+} rga_handle_cache_entry_t;
+
+static pthread_mutex_t rga_handle_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static rga_handle_cache_entry_t rga_handle_cache[RGA_HANDLE_CACHE_SIZE];
+static int rga_handle_cache_count = 0;
+static uint64_t rga_handle_cache_tick = 0;
+static unsigned long long rga_handle_cache_hits = 0;
+static unsigned long long rga_handle_cache_misses = 0;
+
+static bool rga_handle_cache_cacheable(buffer_handle_t hnd) {
+    return hnd != NULL && hnd->numFds >= 0 && hnd->numInts >= 0 &&
+           hnd->numFds + hnd->numInts <= RGA_HANDLE_CACHE_DATA;
+}
+
+static bool rga_handle_cache_match(const rga_handle_cache_entry_t *entry, buffer_handle_t hnd) {
+    return entry->num_fds == hnd->numFds && entry->num_ints == hnd->numInts &&
+           memcmp(entry->data, hnd->data, (hnd->numFds + hnd->numInts) * sizeof(int)) == 0;
+}
+
+static bool rga_handle_cache_lookup(buffer_handle_t hnd, rga_buffer_t *buffer) {
+    bool hit = false;
+
+    if (!rga_handle_cache_cacheable(hnd))
+        return false;
+
+    pthread_mutex_lock(&rga_handle_cache_lock);
+
+    for (int i = 0; i < rga_handle_cache_count; i++) {
+        rga_handle_cache_entry_t *entry = &rga_handle_cache[i];
+
+        if (entry->handle != hnd)
+            continue;
+
+        if (rga_handle_cache_match(entry, hnd)) {
+            entry->last_use = ++rga_handle_cache_tick;
+            *buffer = entry->buffer;
+            hit = true;
+        } else {
+            /* the buffer was freed and the handle address reused */
+            rga_handle_cache[i] = rga_handle_cache[--rga_handle_cache_count];
+        }
+        break;
+    }
+
+    if (hit)
+        rga_handle_cache_hits++;
+    else
+        rga_handle_cache_misses++;
+
+    pthread_mutex_unlock(&rga_handle_cache_lock);
+
+    return hit;
+}
+
+static void rga_handle_cache_insert(buffer_handle_t hnd, const rga_buffer_t *buffer) {
+    rga_handle_cache_entry_t *entry = NULL;
+
+    if (!rga_handle_cache_cacheable(hnd))
+        return;
+
+    pthread_mutex_lock(&rga_handle_cache_lock);
+
+    /* the same handle, or a free slot, or else the least recently used one */
+    for (int i = 0; i < rga_handle_cache_count; i++) {
+        if (rga_handle_cache[i].handle == hnd) {
+            entry = &rga_handle_cache[i];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        if (rga_handle_cache_count < RGA_HANDLE_CACHE_SIZE) {
+            entry = &rga_handle_cache[rga_handle_cache_count++];
+        } else {
+            entry = &rga_handle_cache[0];
+            for (int i = 1; i < rga_handle_cache_count; i++)
+                if (rga_handle_cache[i].last_use < entry->last_use)
+                    entry = &rga_handle_cache[i];
+        }
+    }
+
+    entry->handle = hnd;
+    entry->num_fds = hnd->numFds;
+    entry->num_ints = hnd->numInts;
+    memcpy(entry->data, hnd->data, (hnd->numFds + hnd->numInts) * sizeof(int));
+    entry->last_use = ++rga_handle_cache_tick;
+    entry->buffer = *buffer;
+
+    pthread_mutex_unlock(&rga_handle_cache_lock);
+}
+
+IM_API IM_STATUS imreleasebuffercache(buffer_handle_t hnd) {
+    if (hnd == NULL) {
+        imErrorMsg("Buffer handle is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&rga_handle_cache_lock);
+
+    for (int i = 0; i < rga_handle_cache_count; i++) {
+        if (rga_handle_cache[i].handle == hnd) {
+            rga_handle_cache[i] = rga_handle_cache[--rga_handle_cache_count];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&rga_handle_cache_lock);
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS imquerybuffercache(im_buffer_cache_info_t *info) {
+    if (info == NULL) {
+        imErrorMsg("Buffer cache info is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&rga_handle_cache_lock);
+
+    info->hits = rga_handle_cache_hits;
+    info->misses = rga_handle_cache_misses;
+    info->entries = rga_handle_cache_count;
+    info->capacity = RGA_HANDLE_CACHE_SIZE;
+
+    pthread_mutex_unlock(&rga_handle_cache_lock);
+
+    return IM_STATUS_SUCCESS;
+}
+
 /*When wrapbuffer_GraphicBuffer and wrapbuffer_AHardwareBuffer are used, */
 /*it is necessary to check whether fd and virtual address of the return rga_buffer_t are valid parameters*/
 IM_API rga_buffer_t wrapbuffer_handle(buffer_handle_t hnd) {
@@ -172,6 +358,9 @@ IM_API rga_buffer_t wrapbuffer_handle(buffer_handle_t hnd) {
 
     memset(&buffer, 0, sizeof(rga_buffer_t));
 
+    if (rga_handle_cache_lookup(hnd, &buffer))
+        return buffer;
+
     ret = rkRga.RkRgaGetBufferFd(hnd, &buffer.fd);
     if (ret)
         ALOGE("rga_im2d: get buffer fd fail: %s, hnd=%p", strerror(errno), (void*)(hnd));
@@ -204,6 +393,8 @@ IM_API rga_buffer_t wrapbuffer_handle(buffer_handle_t hnd) {
         goto INVAILD;
     }
 
+    rga_handle_cache_insert(hnd, &buffer);
+
 INVAILD:
     return buffer;
 }
@@ -214,6 +405,9 @@ IM_API rga_buffer_t wrapbuffer_GraphicBuffer(sp<GraphicBuffer> buf) {
 
     memset(&buffer, 0, sizeof(rga_buffer_t));
 
+    if (rga_handle_cache_lookup(buf->handle, &buffer))
+        return buffer;
+
     ret = rkRga.RkRgaGetBufferFd(buf->handle, &buffer.fd);
     if (ret)
         ALOGE("rga_im2d: get buffer fd fail: %s, hnd=%p", strerror(errno), (void*)(buf->handle));
@@ -237,6 +431,8 @@ IM_API rga_buffer_t wrapbuffer_GraphicBuffer(sp<GraphicBuffer> buf) {
     buffer.hstride = buf->getHeight();
     buffer.format  = buf->getPixelFormat();
 
+    rga_handle_cache_insert(buf->handle, &buffer);
+
 INVAILD:
     return buffer;
 }
@@ -251,6 +447,9 @@ IM_API rga_buffer_t wrapbuffer_AHardwareBuffer(AHardwareBuffer *buf) {
 
     GraphicBuffer *gbuffer = reinterpret_cast<GraphicBuffer*>(buf);
 
+    if (rga_handle_cache_lookup(gbuffer->handle, &buffer))
+        return buffer;
+
     ret = rkRga.RkRgaGetBufferFd(gbuffer->handle, &buffer.fd);
     if (ret)
         ALOGE("rga_im2d: get buffer fd fail: %s, hnd=%p", strerror(errno), (void*)(gbuffer->handle));
@@ -276,10 +475,22 @@ IM_API rga_buffer_t wrapbuffer_AHardwareBuffer(AHardwareBuffer *buf) {
     buffer.hstride = gbuffer->getHeight();
     buffer.format  = gbuffer->getPixelFormat();
 
+    rga_handle_cache_insert(gbuffer->handle, &buffer);
+
 INVAILD:
     return buffer;
 }
 #endif
+#else
+IM_API IM_STATUS imquerybuffercache(im_buffer_cache_info_t *info) {
+    if (info == NULL) {
+        imErrorMsg("Buffer cache info is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    memset(info, 0, sizeof(*info));
+    return IM_STATUS_SUCCESS;
+}
 #endif
 
 IM_API static void empty_structure(rga_buffer_t *src, rga_buffer_t *dst, rga_buffer_t *pat, im_rect *srect, im_rect *drect, im_rect *prect) {
@@ -372,43 +583,33 @@ IM_API IM_STATUS rga_set_buffer_info(const rga_buffer_t src, rga_buffer_t dst, r
     return IM_STATUS_SUCCESS;
 }
 
-IM_API long rga_get_info() {
-    char buf[16];
-    int  rgafd, rga_version = 0;
-    long usage = 0;
+static pthread_mutex_t rga_capability_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool rga_capability_probed = false;
+static IM_STATUS rga_capability_status = IM_STATUS_FAILED;
+static im_capability_t rga_capability;
 
-    /*open /dev/rga node in order to get rga vesion*/
-    rgafd = open("/dev/rga", O_RDWR, 0);
-    if (rgafd < 0) {
-        ALOGE("rga_im2d: failed to open /dev/rga: %s.",strerror(errno));
-        return -1;
-    }
-    if (ioctl(rgafd, RGA_GET_VERSION, buf)) {
-        ALOGE("rga_im2d: rga get version fail: %s",strerror(errno));
-        return -1;
-    }
+static int rga_get_version_num(const char *buf) {
     if (strncmp(buf,"1.3",3) == 0)
-        rga_version = RGA_1;
+        return RGA_1;
     else if (strncmp(buf,"1.6",3) == 0)
-        rga_version = RGA_1_PLUS;
+        return RGA_1_PLUS;
     /*3288 vesion is 2.00*/
     else if (strncmp(buf,"2.00",4) == 0)
-        rga_version = RGA_2;
+        return RGA_2;
     /*3288w version is 3.00*/
     else if (strncmp(buf,"3.00",4) == 0)
-        rga_version = RGA_2;
+        return RGA_2;
     else if (strncmp(buf,"3.02",4) == 0)
-        rga_version = RGA_2_ENHANCE;
+        return RGA_2_ENHANCE;
+    /*The version number of lite1 cannot be obtained temporarily, 4.00 is reported as lite0.*/
     else if (strncmp(buf,"4.00",4) == 0)
-        rga_version = RGA_2_LITE0;
-    /*The version number of lite1 cannot be obtained temporarily.*/
-    else if (strncmp(buf,"4.00",4) == 0)
-        rga_version = RGA_2_LITE1;
-    else
-        rga_version = RGA_V_ERR;
+        return RGA_2_LITE0;
+
+    return RGA_V_ERR;
+}
 
-    close(rgafd);
-    rgafd = -1;
+static long rga_get_version_usage(int rga_version) {
+    long usage = 0;
 
     switch(rga_version) {
         case RGA_1 :
@@ -484,15 +685,161 @@ IM_API long rga_get_info() {
             usage |= IM_RGA_INFO_PERFORMANCE_600;
             break;
         case RGA_V_ERR :
-            usage = IM_STATUS_FAILED;
-            break;
         default:
             return IM_STATUS_FAILED;
     }
 
+
+    return usage;
+}
+
+/* what the cpu backend can do, reported in place of a rga version. */
+static long rga_get_soft_usage(void) {
+    long usage = 0;
+
+    usage |= IM_RGA_INFO_RESOLUTION_INPUT_8192;
+    usage |= IM_RGA_INFO_RESOLUTION_OUTPUT_8192;
+    usage |= IM_RGA_INFO_SCALE_LIMIT_16;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_INPUT_RGB;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_INPUT_YUV_8;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_INPUT_YUYV;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_INPUT_YUV400;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_OUTPUT_RGB;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_OUTPUT_YUV_8;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_OUTPUT_YUYV;
+    usage |= IM_RGA_INFO_SUPPORT_FORMAT_OUTPUT_YUV400;
+    usage |= IM_RGA_INFO_FEATURE_PORTER_DUFF;
+
     return usage;
 }
 
+static int rga_get_resolution_by_usage(long usage) {
+    if (usage & (IM_RGA_INFO_RESOLUTION_INPUT_8192 | IM_RGA_INFO_RESOLUTION_OUTPUT_8192))
+        return 8192;
+    else if (usage & (IM_RGA_INFO_RESOLUTION_INPUT_4096 | IM_RGA_INFO_RESOLUTION_OUTPUT_4096))
+        return 4096;
+    else if (usage & (IM_RGA_INFO_RESOLUTION_INPUT_2048 | IM_RGA_INFO_RESOLUTION_OUTPUT_2048))
+        return 2048;
+
+    return 0;
+}
+
+static IM_STATUS rga_probe_capability(im_capability_t *cap) {
+    char buf[16];
+    long usage = 0;
+
+    memset(cap, 0, sizeof(im_capability_t));
+    memset(buf, 0, sizeof(buf));
+
+    /* reuse the fd of the RockchipRga singleton, open it again only if the first try failed. */
+    if (rkRga.RkRgaInit() || !rkRga.RkRgaIsReady()) {
+        ALOGE("rga_im2d: failed to init rga device.");
+        imErrorMsg("RGA device is not available.");
+        return IM_STATUS_FAILED;
+    }
+
+    if (rkRga.RkRgaGetVersion(buf, sizeof(buf))) {
+        ALOGE("rga_im2d: rga get version fail.");
+        imErrorMsg("Get RGA version failed.");
+        return IM_STATUS_FAILED;
+    }
+
+    snprintf(cap->version_str, sizeof(cap->version_str), "%s", buf);
+
+    if (rkRga.RkRgaGetBackend() == RGA_BACKEND_SW) {
+        cap->version = RGA_SOFT;
+        usage = rga_get_soft_usage();
+    } else {
+        cap->version = rga_get_version_num(buf);
+        usage = rga_get_version_usage(cap->version);
+    }
+    if (usage == IM_STATUS_FAILED) {
+        ALOGE("rga_im2d: unknown rga version: %s", buf);
+        imErrorMsg("Unknown RGA version.");
+        return IM_STATUS_FAILED;
+    }
+
+    cap->usage = usage;
+    cap->max_input_width = cap->max_input_height =
+        rga_get_resolution_by_usage(usage & IM_RGA_INFO_RESOLUTION_INPUT_MASK);
+    cap->max_output_width = cap->max_output_height =
+        rga_get_resolution_by_usage(usage & IM_RGA_INFO_RESOLUTION_OUTPUT_MASK);
+
+    switch (usage & IM_RGA_INFO_SCALE_LIMIT_MASK) {
+        case IM_RGA_INFO_SCALE_LIMIT_8 :
+            cap->scale_limit = 8;
+            break;
+        case IM_RGA_INFO_SCALE_LIMIT_16 :
+            cap->scale_limit = 16;
+            break;
+    }
+
+    cap->input_format = usage & IM_RGA_INFO_SUPPORT_FORMAT_INPUT_MASK;
+    cap->output_format = usage & IM_RGA_INFO_SUPPORT_FORMAT_OUTPUT_MASK;
+
+    switch (usage & IM_RGA_INFO_PERFORMANCE_MASK) {
+        case IM_RGA_INFO_PERFORMANCE_300 :
+            cap->performance = 300;
+            break;
+        case IM_RGA_INFO_PERFORMANCE_520 :
+            cap->performance = 520;
+            break;
+        case IM_RGA_INFO_PERFORMANCE_600 :
+            cap->performance = 600;
+            break;
+    }
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS imquerycapability(im_capability_t *cap) {
+    IM_STATUS ret;
+
+    if (cap == NULL) {
+        imErrorMsg("Capability is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&rga_capability_lock);
+
+    /* A failed probe is cached as well, only imrefreshcapability() probes again. */
+    if (!rga_capability_probed) {
+        rga_capability_status = rga_probe_capability(&rga_capability);
+        rga_capability_probed = true;
+    }
+
+    ret = rga_capability_status;
+    if (ret == IM_STATUS_SUCCESS)
+        *cap = rga_capability;
+
+    pthread_mutex_unlock(&rga_capability_lock);
+
+    return ret;
+}
+
+IM_API IM_STATUS imrefreshcapability(void) {
+    IM_STATUS ret;
+
+    pthread_mutex_lock(&rga_capability_lock);
+
+    rga_capability_status = rga_probe_capability(&rga_capability);
+    rga_capability_probed = true;
+    ret = rga_capability_status;
+
+    pthread_mutex_unlock(&rga_capability_lock);
+
+    return ret;
+}
+
+IM_API long rga_get_info() {
+    im_capability_t cap;
+
+    if (imquerycapability(&cap) != IM_STATUS_SUCCESS)
+        return IM_STATUS_FAILED;
+
+    return cap.usage;
+}
+
 
 IM_API const char* querystring(int name) {
     bool all_output = 0, all_output_prepared = 0;
@@ -524,7 +871,8 @@ IM_API const char* querystring(int name) {
         "RGA_2",
         "RGA_2_lite0",
         "RGA_2_lite1",
-        "RGA_2_Enhance"
+        "RGA_2_Enhance",
+        "RGA_soft"
     };
     const char *output_resolution[] = {
         "unknown",
@@ -553,7 +901,7 @@ IM_API const char* querystring(int name) {
         "600M pix/s ",
     };
     ostringstream out;
-    static string info;
+    static thread_local string info;
 
 #ifdef ANDROID
     property_set("vendor.rga_im2d.version", RGA_IM2D_VERSION);
@@ -589,6 +937,10 @@ IM_API const char* querystring(int name) {
             break;
     }
 
+    /* the cpu backend has no version bit in usage */
+    if (rkRga.RkRgaGetBackend() == RGA_BACKEND_SW)
+        rga_version = RGA_SOFT;
+
     do {
         switch(name) {
             case RGA_VENDOR :
@@ -734,20 +1086,14 @@ IM_API const char* querystring(int name) {
     return temp;
 }
 
-IM_API IM_STATUS imcheck_t(const rga_buffer_t src, const rga_buffer_t dst, const rga_buffer_t pat,
-                           im_rect src_rect, const im_rect dst_rect, const im_rect pat_rect, int mode_usage) {
+/* imcheck_t() against the capability described by usage. */
+static IM_STATUS rga_check_usage(long usage, const rga_buffer_t src, const rga_buffer_t dst, const rga_buffer_t pat,
+                                 im_rect src_rect, const im_rect dst_rect, const im_rect pat_rect, int mode_usage) {
     bool src_isRGB = 0, src_isBP = 0, src_isYUV_8 = 0, src_isYUV_10 = 0, src_isYUYV = 0, src_isYUV400 = 0;
     bool dst_isRGB = 0, dst_isBP = 0, dst_isYUV_8 = 0, dst_isYUV_10 = 0, dst_isYUYV = 0, dst_isYUV400 = 0;
     bool pat_isRGB = 0, pat_isBP = 0, pat_isYUV_8 = 0, pat_isYUV_10 = 0, pat_isYUYV = 0, pat_isYUV400 = 0;
     bool pat_buffer_isValid = 0, pat_rect_isValid = 0;
     int src_fmt, dst_fmt, pat_fmt;
-    long usage = 0;
-
-    usage = rga_get_info();
-    if (IM_STATUS_FAILED == usage) {
-        imErrorMsg("Get rga info failed, can not continue check.");
-        return IM_STATUS_FAILED;
-    }
 
     if (mode_usage & IM_ALPHA_BLEND_MASK) {
         if (rga_is_buffer_valid(pat))
@@ -954,22 +1300,22 @@ IM_API IM_STATUS imcheck_t(const rga_buffer_t src, const rga_buffer_t dst, const
     if ((~mode_usage & IM_COLOR_FILL) && (~mode_usage & IM_CROP)) {
         switch (usage & IM_RGA_INFO_SCALE_LIMIT_MASK) {
             case IM_RGA_INFO_SCALE_LIMIT_8 :
-                if (((src.width >> 3) >= dst.width) || ((src.height >> 3) >= dst.height)) {
+                if ((src.width > (dst.width << 3)) || (src.height > (dst.height << 3))) {
                     imErrorMsg("Unsupported to scaling less than 1/8 times.");
                     return IM_STATUS_NOT_SUPPORTED;
                 }
-                if (((dst.width >> 3) >= src.width) || ((dst.height >> 3) >= src.height)) {
+                if ((dst.width > (src.width << 3)) || (dst.height > (src.height << 3))) {
                     imErrorMsg("Unsupported to scaling more than 8 times.");
                     return IM_STATUS_NOT_SUPPORTED;
                 }
                 break;
 
             case IM_RGA_INFO_SCALE_LIMIT_16 :
-                if (((src.width >> 4) >= dst.width) || ((src.height >> 4) >= dst.height)) {
+                if ((src.width > (dst.width << 4)) || (src.height > (dst.height << 4))) {
                     imErrorMsg("Unsupported to scaling less than 1/16 times.");
                     return IM_STATUS_NOT_SUPPORTED;
                 }
-                if (((dst.width >> 4) >= src.width) || ((dst.height >> 4) >= src.height)) {
+                if ((dst.width > (src.width << 4)) || (dst.height > (src.height << 4))) {
                     imErrorMsg("Unsupported to scaling more than 16 times.");
                     return IM_STATUS_NOT_SUPPORTED;
                 }
@@ -1234,6 +1580,11 @@ IM_API IM_STATUS imcheck_t(const rga_buffer_t src, const rga_buffer_t dst, const
 
                 break;
             default :
+                /* the rga has no encoding of the other Porter-Duff modes */
+                if (~usage & IM_RGA_INFO_FEATURE_PORTER_DUFF) {
+                    imErrorMsg("Blend mode unsupported by this RGA version.");
+                    return IM_STATUS_NOT_SUPPORTED;
+                }
                 if (!(src_isRGB && dst_isRGB) ||
                    (src_fmt == RK_FORMAT_RGB_565 || src_fmt == RK_FORMAT_RGB_888 ||
                     src_fmt == RK_FORMAT_BGR_888 || dst_fmt == RK_FORMAT_RGB_565 ||
@@ -1246,8 +1597,13 @@ IM_API IM_STATUS imcheck_t(const rga_buffer_t src, const rga_buffer_t dst, const
     }
     /**************** rotate mode check ****************/
     if ((mode_usage & IM_HAL_TRANSFORM_ROT_90) || (mode_usage & IM_HAL_TRANSFORM_ROT_270)) {
-        if ((src.width != dst.height) || (src.height != dst.width) ||
-            (src_rect.width != dst_rect.height) || (src_rect.height != dst_rect.width)) {
+        /* the regions being rotated must match, the buffers around them need not */
+        int rot_src_w = src_rect.width > 0 ? src_rect.width : src.width;
+        int rot_src_h = src_rect.height > 0 ? src_rect.height : src.height;
+        int rot_dst_w = dst_rect.width > 0 ? dst_rect.width : dst.width;
+        int rot_dst_h = dst_rect.height > 0 ? dst_rect.height : dst.height;
+
+        if ((rot_src_w != rot_dst_h) || (rot_src_h != rot_dst_w)) {
             imErrorMsg("Rotate 90 or 270 need to exchange width and height.");
             return IM_STATUS_INVALID_PARAM;
         }
@@ -1256,6 +1612,19 @@ IM_API IM_STATUS imcheck_t(const rga_buffer_t src, const rga_buffer_t dst, const
     return IM_STATUS_NOERROR;
 }
 
+IM_API IM_STATUS imcheck_t(const rga_buffer_t src, const rga_buffer_t dst, const rga_buffer_t pat,
+                           im_rect src_rect, const im_rect dst_rect, const im_rect pat_rect, int mode_usage) {
+    long usage = 0;
+
+    usage = rga_get_info();
+    if (IM_STATUS_FAILED == usage) {
+        imErrorMsg("Get rga info failed, can not continue check.");
+        return IM_STATUS_FAILED;
+    }
+
+    return rga_check_usage(usage, src, dst, pat, src_rect, dst_rect, pat_rect, mode_usage);
+}
+
 IM_API IM_STATUS imresize_t(const rga_buffer_t src, rga_buffer_t dst, double fx, double fy, int interpolation, int sync) {
     int usage = 0;
     IM_STATUS ret = IM_STATUS_NOERROR;
@@ -1547,15 +1916,16 @@ IM_API IM_STATUS imrop_t(const rga_buffer_t src, rga_buffer_t dst, int rop_code,
     return ret;
 }
 
-IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat, im_rect srect, im_rect drect, im_rect prect, int usage) {
-    rga_info_t srcinfo;
-    rga_info_t dstinfo;
-    rga_info_t patinfo;
+static IM_STATUS rga_task_prepare(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                  im_rect srect, im_rect drect, im_rect prect, int usage, im_task_t *task) {
+    rga_info_t &srcinfo = task->srcinfo;
+    rga_info_t &dstinfo = task->dstinfo;
+    rga_info_t &patinfo = task->patinfo;
     int ret;
 
-    memset(&srcinfo, 0, sizeof(rga_info_t));
-    memset(&dstinfo, 0, sizeof(rga_info_t));
-    memset(&patinfo, 0, sizeof(rga_info_t));
+    memset(task, 0, sizeof(im_task_t));
+    task->usage = usage;
+    task->status = IM_STATUS_FAILED;
 
     if (usage & IM_COLOR_FILL)
         ret = rga_set_buffer_info(dst, &dstinfo);
@@ -1566,9 +1936,28 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
         return (IM_STATUS)ret;
 
     if ((usage & IM_ALPHA_BLEND_MASK) && rga_is_buffer_valid(pat)) /* A+B->C */
-        imcheck_composite(src, dst, pat, srect, drect, prect, usage);
+        ret = imcheck_composite(src, dst, pat, srect, drect, prect, usage);
     else
         ret = imcheck(src, dst, srect, drect, usage);
+
+    /* In auto mode, what the rga cannot do is done by the cpu backend. */
+    if (ret == IM_STATUS_NOT_SUPPORTED && (~usage & IM_COLOR_PALETTE) &&
+        rkRga.RkRgaGetBackendMode() == RGA_BACKEND_AUTO &&
+        rkRga.RkRgaGetBackend() == RGA_BACKEND_HW) {
+        rga_buffer_t no_pat;
+        im_rect no_prect;
+
+        memset(&no_pat, 0, sizeof(rga_buffer_t));
+        memset(&no_prect, 0, sizeof(im_rect));
+
+        if ((usage & IM_ALPHA_BLEND_MASK) && rga_is_buffer_valid(pat))
+            ret = rga_check_usage(rga_get_soft_usage(), src, dst, pat, srect, drect, prect, usage);
+        else
+            ret = rga_check_usage(rga_get_soft_usage(), src, dst, no_pat, srect, drect, no_prect, usage);
+
+        task->soft = ret > 0;
+    }
+
     if(ret <= 0)
         return (IM_STATUS)ret;
 
@@ -1597,6 +1986,8 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
         if (ret <= 0)
             return (IM_STATUS)ret;
 
+        task->pat_enable = true;
+
         if (prect.width > 0 && prect.height > 0) {
             pat.width = prect.width;
             pat.height = prect.height;
@@ -1623,6 +2014,47 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
             case IM_HAL_TRANSFORM_FLIP_H:
                 srcinfo.rotation = HAL_TRANSFORM_FLIP_H;
                 break;
+            case IM_HAL_TRANSFORM_FLIP_H | IM_HAL_TRANSFORM_FLIP_V:
+                srcinfo.rotation = HAL_TRANSFORM_FLIP_H_V;
+                break;
+            default: {
+                /*
+                 * A flip together with a rotation. im2d flips first, the hardware
+                 * flips after rotating, which mirrors the other axis at 90/270.
+                 * Both flips are a rotation by 180, added to the rotation.
+                 */
+                int rotation = usage & (IM_HAL_TRANSFORM_ROT_90 | IM_HAL_TRANSFORM_ROT_180 | IM_HAL_TRANSFORM_ROT_270);
+                bool flip_h = !!(usage & IM_HAL_TRANSFORM_FLIP_H);
+                bool flip_v = !!(usage & IM_HAL_TRANSFORM_FLIP_V);
+                bool swap;
+
+                if (flip_h && flip_v) {
+                    if (rotation == IM_HAL_TRANSFORM_ROT_90)
+                        rotation = IM_HAL_TRANSFORM_ROT_270;
+                    else if (rotation == IM_HAL_TRANSFORM_ROT_180)
+                        rotation = 0;
+                    else if (rotation == IM_HAL_TRANSFORM_ROT_270)
+                        rotation = IM_HAL_TRANSFORM_ROT_90;
+                    flip_h = flip_v = false;
+                }
+
+                switch (rotation) {
+                    case IM_HAL_TRANSFORM_ROT_90:
+                        srcinfo.rotation = HAL_TRANSFORM_ROT_90;
+                        break;
+                    case IM_HAL_TRANSFORM_ROT_180:
+                        srcinfo.rotation = HAL_TRANSFORM_ROT_180;
+                        break;
+                    case IM_HAL_TRANSFORM_ROT_270:
+                        srcinfo.rotation = HAL_TRANSFORM_ROT_270;
+                        break;
+                }
+
+                swap = rotation == IM_HAL_TRANSFORM_ROT_90 || rotation == IM_HAL_TRANSFORM_ROT_270;
+                if (srcinfo.rotation && flip_h != flip_v)
+                    srcinfo.rotation |= ((flip_h != swap) ? HAL_TRANSFORM_FLIP_H : HAL_TRANSFORM_FLIP_V) << 4;
+                break;
+            }
         }
 
         /* Blend */
@@ -1637,23 +2069,33 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
                 srcinfo.blend = 0xff0105;
                 break;
             case IM_ALPHA_BLEND_SRC_IN:
+                srcinfo.blend = 0xff0600;
                 break;
             case IM_ALPHA_BLEND_DST_IN:
+                srcinfo.blend = 0xff0004;
                 break;
             case IM_ALPHA_BLEND_SRC_OUT:
+                srcinfo.blend = 0xff0700;
                 break;
             case IM_ALPHA_BLEND_DST_OVER:
                 srcinfo.blend = 0xff0501;
                 break;
             case IM_ALPHA_BLEND_SRC_ATOP:
+                srcinfo.blend = 0xff0605;
+                break;
+            case IM_ALPHA_BLEND_DST_ATOP:
+                srcinfo.blend = 0xff0704;
                 break;
             case IM_ALPHA_BLEND_DST_OUT:
-                srcinfo.blend = 0xff0405;
+                srcinfo.blend = 0xff0005;
                 break;
             case IM_ALPHA_BLEND_XOR:
+                srcinfo.blend = 0xff0705;
                 break;
         }
-        if(srcinfo.blend == 0 && srcinfo.rotation ==0)
+        /* ROT_180 with both flips is the identity, nothing is missing */
+        if(srcinfo.blend == 0 && srcinfo.rotation ==0 &&
+           (usage & IM_HAL_TRANSFORM_MASK) != (IM_HAL_TRANSFORM_ROT_180 | IM_HAL_TRANSFORM_FLIP_H | IM_HAL_TRANSFORM_FLIP_V))
             ALOGE("rga_im2d: Could not find blend/rotate/flip usage : 0x%x \n", usage);
     }
 
@@ -1673,9 +2115,9 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
         srcinfo.rop_code = dst.rop_code;
     }
 
-    /* set global alpha */
+    /* set global alpha, bits 16-23 of the blend word */
     if ((src.global_alpha > 0) && (usage & IM_ALPHA_BLEND_MASK))
-        srcinfo.blend &= src.global_alpha << 16;
+        srcinfo.blend = (srcinfo.blend & ~0xff0000) | ((src.global_alpha & 0xff) << 16);
 
     /* special config for yuv to rgb */
     if (dst.color_space_mode & (IM_YUV_TO_RGB_MASK)) {
@@ -1728,16 +2170,34 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
     if (usage & IM_SYNC)
         dstinfo.sync_mode = RGA_BLIT_ASYNC;
 
-    if (usage & IM_COLOR_FILL) {
+    if (usage & IM_COLOR_FILL)
         dstinfo.color = dst.color;
-        ret = rkRga.RkRgaCollorFill(&dstinfo);
-    } else if (usage & IM_COLOR_PALETTE) {
-        ret = rkRga.RkRgaCollorPalette(&srcinfo, &dstinfo, &patinfo);
-    } else if ((usage & IM_ALPHA_BLEND_MASK) && rga_is_buffer_valid(pat)) {
+    else if ((usage & IM_ALPHA_BLEND_MASK) && task->pat_enable)
         dstinfo.color_space_mode = IM_COLOR_SPACE_DEFAULT;
-        ret = rkRga.RkRgaBlit(&srcinfo, &dstinfo, &patinfo);
-    }else {
-        ret = rkRga.RkRgaBlit(&srcinfo, &dstinfo, NULL);
+
+    task->status = IM_STATUS_SUCCESS;
+
+    return IM_STATUS_SUCCESS;
+}
+
+static IM_STATUS rga_task_submit(im_task_t *task) {
+    int ret;
+
+    if (task->soft) {
+        if (task->usage & IM_COLOR_FILL)
+            ret = rkRga.RkRgaSoftCollorFill(&task->dstinfo);
+        else if ((task->usage & IM_ALPHA_BLEND_MASK) && task->pat_enable)
+            ret = rkRga.RkRgaSoftBlit(&task->srcinfo, &task->dstinfo, &task->patinfo);
+        else
+            ret = rkRga.RkRgaSoftBlit(&task->srcinfo, &task->dstinfo, NULL);
+    } else if (task->usage & IM_COLOR_FILL) {
+        ret = rkRga.RkRgaCollorFill(&task->dstinfo);
+    } else if (task->usage & IM_COLOR_PALETTE) {
+        ret = rkRga.RkRgaCollorPalette(&task->srcinfo, &task->dstinfo, &task->patinfo);
+    } else if ((task->usage & IM_ALPHA_BLEND_MASK) && task->pat_enable) {
+        ret = rkRga.RkRgaBlit(&task->srcinfo, &task->dstinfo, &task->patinfo);
+    } else {
+        ret = rkRga.RkRgaBlit(&task->srcinfo, &task->dstinfo, NULL);
     }
 
     if (ret) {
@@ -1748,12 +2208,2433 @@ IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
     return IM_STATUS_SUCCESS;
 }
 
-IM_API IM_STATUS imsync(void) {
-    int ret = 0;
-    ret = rkRga.RkRgaFlush();
-    if (ret)
-        return IM_STATUS_FAILED;
+static bool rga_tile_required(const rga_buffer_t src, const rga_buffer_t dst, im_rect srect, im_rect drect,
+                              int usage, im_capability_t *cap);
+static IM_STATUS rga_tile_process(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                  int usage, const im_capability_t *cap);
+static IM_STATUS rga_plan_build(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                int usage, im_plan_t *plan);
+static IM_STATUS rga_plan_process(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                  const im_plan_t *plan);
 
-    return IM_STATUS_SUCCESS;
+IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat, im_rect srect, im_rect drect, im_rect prect, int usage) {
+    im_task_t task;
+    im_capability_t cap;
+    im_plan_t plan;
+    IM_STATUS ret;
+
+    /* Larger than the rga can take in one pass, split it into tiles. */
+    if (rga_tile_required(src, dst, srect, drect, usage, &cap))
+        return rga_tile_process(src, dst, srect, drect, usage, &cap);
+
+    ret = rga_task_prepare(src, dst, pat, srect, drect, prect, usage, &task);
+
+    /* Not possible in one pass of the rga, try a chain of passes before the cpu. */
+    if (ret == IM_STATUS_NOT_SUPPORTED || ret == IM_STATUS_INVALID_PARAM || (ret > 0 && task.soft)) {
+        string msg = err_msg.str();
+
+        if (rga_plan_build(src, dst, srect, drect, usage, &plan) == IM_STATUS_SUCCESS && plan.num_passes > 1)
+            return rga_plan_process(src, dst, srect, drect, &plan);
+
+        /* report why the single pass failed */
+        err_msg.str(msg);
+    }
+
+    if (ret <= 0)
+        return ret;
+
+    return rga_task_submit(&task);
+}
+
+IM_API im_job_handle_t imbeginJob(void) {
+    im_job_handle_t job;
+
+    job = new(std::nothrow) im_job;
+    if (job == NULL) {
+        imErrorMsg("Failed to alloc job.");
+        return NULL;
+    }
+
+    return job;
+}
+
+IM_API IM_STATUS imaddTask(im_job_handle_t job, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                           im_rect srect, im_rect drect, im_rect prect, int usage) {
+    im_task_t task;
+    IM_STATUS ret;
+
+    if (job == NULL) {
+        imErrorMsg("Job is NULL, please call imbeginJob() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    /* The completion of the job is decided by imendJob(). */
+    usage &= ~IM_SYNC;
+
+    ret = rga_task_prepare(src, dst, pat, srect, drect, prect, usage, &task);
+    /* A task that failed the check is kept, so that the task index matches the add order. */
+    task.status = ret > 0 ? IM_STATUS_SUCCESS : ret;
+    job->tasks.push_back(task);
+
+    return ret > 0 ? IM_STATUS_SUCCESS : ret;
+}
+
+static IM_STATUS rga_job_submit(im_job_handle_t job, int sync) {
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    int last = -1;
+    bool wait_all = false;
+
+    for (int i = 0; i < (int)job->tasks.size(); i++)
+        if (job->tasks[i].status == IM_STATUS_SUCCESS)
+            last = i;
+
+    /*
+     * Submit back-to-back, only the last task is synchronous. The driver completes the
+     * jobs of a session in order, so its return is the completion point of the whole job.
+     */
+    for (int i = 0; i < (int)job->tasks.size(); i++) {
+        im_task_t &task = job->tasks[i];
+
+        if (task.status != IM_STATUS_SUCCESS) {
+            ret = ret == IM_STATUS_SUCCESS ? task.status : ret;
+            continue;
+        }
+
+        if (sync && i == last)
+            task.dstinfo.sync_mode = RGA_BLIT_SYNC;
+        else
+            task.dstinfo.sync_mode = RGA_BLIT_ASYNC;
+
+        task.status = rga_task_submit(&task);
+        if (task.status != IM_STATUS_SUCCESS) {
+            ret = ret == IM_STATUS_SUCCESS ? task.status : ret;
+            if (i == last)
+                wait_all = true;
+        }
+    }
+
+    /* The synchronous task failed, wait for the ones already queued. */
+    if (sync && wait_all)
+        rkRga.RkRgaFlush();
+
+    return ret;
+}
+
+/*
+ * Intermediate buffers
+ *
+ * The temporary buffers of tiled and multi-pass operations come from the pool of the
+ * RGA context (see core/RgaPool.h), they are kept when the operation completes and
+ * handed out again to the next one of a similar size.
+ */
+static void rga_pool_put(rga_pool_buffer_t *buf) {
+    RgaPoolPut(rkRga.RkRgaGetPool(), buf);
+}
+
+/* An intermediate buffer of width x height in format, taken from the pool. */
+static IM_STATUS rga_pool_get_buffer(int width, int height, int format,
+                                     rga_pool_buffer_t *buf, rga_buffer_t *buffer) {
+    int wstride = ALIGN(width, 16);
+    size_t size = (size_t)(wstride * height * get_bpp_from_format(format));
+
+    if (RgaPoolGet(rkRga.RkRgaGetPool(), size, buf)) {
+        imErrorMsg("Failed to alloc an intermediate buffer.");
+        return IM_STATUS_OUT_OF_MEMORY;
+    }
+
+    if (buf->fd >= 0)
+        *buffer = wrapbuffer_fd_t(buf->fd, width, height, wstride, height, format);
+    else
+        *buffer = wrapbuffer_virtualaddr_t(buf->virAddr, width, height, wstride, height, format);
+
+    return IM_STATUS_SUCCESS;
+}
+
+static IM_STATUS rga_job_add(im_job_handle_t job, rga_buffer_t src, im_rect srect,
+                              rga_buffer_t dst, im_rect drect, int usage) {
+    im_task_t task;
+    rga_buffer_t pat;
+    im_rect prect;
+    IM_STATUS ret;
+
+    empty_structure(NULL, NULL, &pat, NULL, NULL, &prect);
+
+    /* The buffers are narrowed to the rects, the limits are checked against what the rga really touches. */
+    src.width = srect.width;
+    src.height = srect.height;
+    dst.width = drect.width;
+    dst.height = drect.height;
+
+    ret = rga_task_prepare(src, dst, pat, srect, drect, prect, usage, &task);
+    if (ret <= 0)
+        return ret;
+
+    job->tasks.push_back(task);
+
+    return IM_STATUS_SUCCESS;
+}
+
+/*
+ * Tiling
+ *
+ * An operation larger than the resolution limits of the rga is split in the frame of
+ * the dst before the transform, so that every tile maps to one rectangle of the src and
+ * one rectangle of the dst. Tiles of a scaled operation overlap by RGA_TILE_PAD pixels
+ * so that the filter sees the same neighbours on both sides of a seam; such a tile is
+ * scaled into a temporary buffer and only its interior is copied to the dst.
+ */
+#define RGA_TILE_PAD        4
+#define RGA_TILE_MAX_UNIT   64
+
+typedef struct {
+    int src;            /* length of the src along the axis */
+    int dst;            /* length of the dst along the axis, before the transform */
+    int salign;         /* a src boundary is a multiple of it */
+    int unit;           /* a dst boundary is a multiple of it */
+    int pad;            /* overlap of scaled tiles, in dst pixels */
+    int tile;           /* length of a tile */
+} rga_tile_axis_t;
+
+static int rga_tile_gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+static IM_STATUS rga_tile_plan_axis(rga_tile_axis_t *axis, int max_input, int max_output, int align, bool scaled) {
+    int max, num;
+
+    axis->salign = align;
+    axis->unit = align;
+    axis->pad = 0;
+
+    if (scaled) {
+        int gcd = rga_tile_gcd(axis->src, axis->dst);
+        int dstep = axis->dst / gcd, sstep = axis->src / gcd;
+        int unit = dstep;
+
+        /* Boundaries on whole pixels of both the src and the dst keep the scaling phase of every tile exact. */
+        while ((unit % align) || ((int64_t)unit / dstep * sstep) % align)
+            unit += dstep;
+        if (unit <= RGA_TILE_MAX_UNIT)
+            axis->unit = unit;
+
+        axis->pad = ((int64_t)RGA_TILE_PAD * axis->dst + axis->src - 1) / axis->src;
+        if (axis->pad < RGA_TILE_PAD)
+            axis->pad = RGA_TILE_PAD;
+        axis->pad = (axis->pad + axis->unit - 1) / axis->unit * axis->unit;
+
+        max = max_output - 2 * axis->pad;
+        num = (int64_t)(max_input - 2 * align) * axis->dst / axis->src - 2 * axis->pad;
+        max = max < num ? max : num;
+    } else {
+        max = max_input < max_output ? max_input : max_output;
+    }
+
+    max = max / axis->unit * axis->unit;
+    if (max < 2) {
+        imErrorMsg("The operation cannot be split into tiles within the resolution limits of RGA.");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    /* Tiles of the same size, rather than a thin one left at the end. */
+    num = (axis->dst + max - 1) / max;
+    axis->tile = ((axis->dst + num - 1) / num + axis->unit - 1) / axis->unit * axis->unit;
+
+    return IM_STATUS_SUCCESS;
+}
+
+static int rga_tile_round(int pos, const rga_tile_axis_t *axis) {
+    int64_t step = (int64_t)axis->dst * axis->salign;
+
+    return (int)(((int64_t)pos * axis->src + step / 2) / step) * axis->salign;
+}
+
+/* The dst span [e0, e1) of a scaled tile [p0, p1) with its overlap, and the src span [s0, s1) scaled to it. */
+static void rga_tile_span(const rga_tile_axis_t *axis, int p0, int p1, int *e0, int *e1, int *s0, int *s1) {
+    *e0 = p0 - axis->pad > 0 ? p0 - axis->pad : 0;
+    *e1 = p1 + axis->pad < axis->dst ? p1 + axis->pad : axis->dst;
+
+    /*
+     * Exact when the boundaries are on the unit. Otherwise the nearest aligned src pixel is
+     * taken, the rga has no sub-pixel phase, so the scaling of such a tile is off by a fraction
+     * of a pixel at most.
+     */
+    *s0 = rga_tile_round(*e0, axis);
+    *s1 = rga_tile_round(*e1, axis);
+}
+
+/* Where the rectangle rect of a width x height frame ends up after the transform. */
+static im_rect rga_tile_transform_rect(im_rect rect, int width, int height, int transform) {
+    im_rect out = rect;
+
+    switch (transform) {
+        case IM_HAL_TRANSFORM_ROT_90:
+            out.x = height - rect.y - rect.height;
+            out.y = rect.x;
+            out.width = rect.height;
+            out.height = rect.width;
+            break;
+        case IM_HAL_TRANSFORM_ROT_180:
+            out.x = width - rect.x - rect.width;
+            out.y = height - rect.y - rect.height;
+            break;
+        case IM_HAL_TRANSFORM_ROT_270:
+            out.x = rect.y;
+            out.y = width - rect.x - rect.width;
+            out.width = rect.height;
+            out.height = rect.width;
+            break;
+        case IM_HAL_TRANSFORM_FLIP_H:
+            out.x = width - rect.x - rect.width;
+            break;
+        case IM_HAL_TRANSFORM_FLIP_V:
+            out.y = height - rect.y - rect.height;
+            break;
+    }
+
+    return out;
+}
+
+static bool rga_tile_required(const rga_buffer_t src, const rga_buffer_t dst, im_rect srect, im_rect drect,
+                              int usage, im_capability_t *cap) {
+    /* copy, resize, cvtcolor, rotate and flip */
+    if (usage & ~(IM_HAL_TRANSFORM_MASK | IM_SYNC | IM_CROP))
+        return false;
+
+    if (!rga_is_buffer_valid(src) || !rga_is_buffer_valid(dst))
+        return false;
+
+    if (imquerycapability(cap) != IM_STATUS_SUCCESS ||
+        cap->max_input_width <= 0 || cap->max_input_height <= 0 ||
+        cap->max_output_width <= 0 || cap->max_output_height <= 0)
+        return false;
+
+    return src.width > cap->max_input_width || src.height > cap->max_input_height ||
+           srect.width > cap->max_input_width || srect.height > cap->max_input_height ||
+           dst.width > cap->max_output_width || dst.height > cap->max_output_height ||
+           drect.width > cap->max_output_width || drect.height > cap->max_output_height;
+}
+
+static IM_STATUS rga_tile_process(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                  int usage, const im_capability_t *cap) {
+    rga_tile_axis_t ax, ay;
+    im_job job;
+    vector<rga_pool_buffer_t> temps;
+    int transform = usage & IM_HAL_TRANSFORM_MASK;
+    bool transpose = transform == IM_HAL_TRANSFORM_ROT_90 || transform == IM_HAL_TRANSFORM_ROT_270;
+    bool scaled;
+    int align, sync = !(usage & IM_SYNC);
+    IM_STATUS ret;
+
+    /* the same defaults as rga_task_prepare() */
+    if (srect.width <= 0 || srect.height <= 0) {
+        srect.width = src.width;
+        srect.height = src.height;
+    }
+
+    if (drect.width <= 0 || drect.height <= 0) {
+        drect.width = dst.width;
+        drect.height = dst.height;
+        if (usage & IM_CROP) {
+            drect.width = srect.width < dst.width ? srect.width : dst.width;
+            drect.height = srect.height < dst.height ? srect.height : dst.height;
+        }
+    }
+
+    /* Chroma of yuv is subsampled by 2, so is every boundary. */
+    align = (NormalRgaIsYuvFormat(RkRgaGetRgaFormat(src.format)) ||
+             NormalRgaIsYuvFormat(RkRgaGetRgaFormat(dst.format))) ? 2 : 1;
+
+    ax.src = srect.width;
+    ay.src = srect.height;
+    ax.dst = transpose ? drect.height : drect.width;
+    ay.dst = transpose ? drect.width : drect.height;
+    scaled = ax.src != ax.dst || ay.src != ay.dst;
+
+    ret = rga_tile_plan_axis(&ax, cap->max_input_width,
+                             transpose ? cap->max_output_height : cap->max_output_width, align, scaled);
+    if (ret != IM_STATUS_SUCCESS)
+        return ret;
+
+    ret = rga_tile_plan_axis(&ay, cap->max_input_height,
+                             transpose ? cap->max_output_width : cap->max_output_height, align, scaled);
+    if (ret != IM_STATUS_SUCCESS)
+        return ret;
+
+    usage &= ~IM_SYNC;
+
+    for (int py = 0; py < ay.dst && ret == IM_STATUS_SUCCESS; py += ay.tile) {
+        for (int px = 0; px < ax.dst && ret == IM_STATUS_SUCCESS; px += ax.tile) {
+            im_rect p, d, s;
+
+            p.x = px;
+            p.y = py;
+            p.width = ax.tile < ax.dst - px ? ax.tile : ax.dst - px;
+            p.height = ay.tile < ay.dst - py ? ay.tile : ay.dst - py;
+
+            d = rga_tile_transform_rect(p, ax.dst, ay.dst, transform);
+            d.x += drect.x;
+            d.y += drect.y;
+
+            if (!scaled) {
+                s = p;
+                s.x += srect.x;
+                s.y += srect.y;
+
+                ret = rga_job_add(&job, src, s, dst, d, usage);
+            } else {
+                int ex0, ex1, ey0, ey1, sx0, sx1, sy0, sy1;
+                int width, height;
+                im_rect e, i, t;
+                rga_buffer_t tmp, copy_dst;
+                rga_pool_buffer_t buf;
+
+                rga_tile_span(&ax, p.x, p.x + p.width, &ex0, &ex1, &sx0, &sx1);
+                rga_tile_span(&ay, p.y, p.y + p.height, &ey0, &ey1, &sy0, &sy1);
+
+                e.x = 0;
+                e.y = 0;
+                e.width = ex1 - ex0;
+                e.height = ey1 - ey0;
+
+                /* the tile itself, inside the transformed overlap */
+                i.x = p.x - ex0;
+                i.y = p.y - ey0;
+                i.width = p.width;
+                i.height = p.height;
+                i = rga_tile_transform_rect(i, e.width, e.height, transform);
+
+                width = transpose ? e.height : e.width;
+                height = transpose ? e.width : e.height;
+
+                ret = rga_pool_get_buffer(width, height, dst.format, &buf, &tmp);
+                if (ret != IM_STATUS_SUCCESS)
+                    break;
+                temps.push_back(buf);
+
+                tmp.color_space_mode = dst.color_space_mode;
+
+                s.x = srect.x + sx0;
+                s.y = srect.y + sy0;
+                s.width = sx1 - sx0;
+                s.height = sy1 - sy0;
+
+                t.x = 0;
+                t.y = 0;
+                t.width = width;
+                t.height = height;
+
+                ret = rga_job_add(&job, src, s, tmp, t, usage);
+                if (ret != IM_STATUS_SUCCESS)
+                    break;
+
+                /* The conversion is done by the first pass, the second one is a plain copy. */
+                tmp.color_space_mode = IM_COLOR_SPACE_DEFAULT;
+                copy_dst = dst;
+                copy_dst.color_space_mode = IM_COLOR_SPACE_DEFAULT;
+
+                ret = rga_job_add(&job, tmp, i, copy_dst, d, 0);
+            }
+        }
+    }
+
+    /* The temporary buffers are given back here, a scaled operation is always synchronous. */
+    if (ret == IM_STATUS_SUCCESS)
+        ret = rga_job_submit(&job, temps.empty() ? sync : 1);
+
+    for (int i = 0; i < (int)temps.size(); i++)
+        rga_pool_put(&temps[i]);
+
+    return ret;
+}
+
+/*
+ * Multi-pass planner
+ *
+ * What the rga cannot do in one pass, a scaling beyond the scale limit or a rotation by
+ * 90/270 together with a scaling, is done as a chain of passes through intermediate
+ * buffers. The chain keeps the intermediate images small: a downscale takes its largest
+ * steps first and an upscale last, the rotation is done on the smallest image of the
+ * chain, and the intermediate format is the cheapest one the rga can read and write.
+ */
+static bool rga_plan_format_usable(int format, const im_capability_t *cap) {
+    int fmt = RkRgaGetRgaFormat(format);
+    long flag;
+
+    if (fmt == RK_FORMAT_RGBA_8888 || fmt == RK_FORMAT_RGBX_8888 ||
+        fmt == RK_FORMAT_BGRA_8888 || fmt == RK_FORMAT_RGB_888   ||
+        fmt == RK_FORMAT_BGR_888   || fmt == RK_FORMAT_RGB_565)
+        flag = IM_RGA_INFO_SUPPORT_FORMAT_INPUT_RGB;
+    else if (fmt == RK_FORMAT_YCrCb_420_SP || fmt == RK_FORMAT_YCbCr_420_SP ||
+             fmt == RK_FORMAT_YCrCb_420_P  || fmt == RK_FORMAT_YCbCr_420_P  ||
+             fmt == RK_FORMAT_YCrCb_422_SP || fmt == RK_FORMAT_YCbCr_422_SP ||
+             fmt == RK_FORMAT_YCrCb_422_P  || fmt == RK_FORMAT_YCbCr_422_P)
+        flag = IM_RGA_INFO_SUPPORT_FORMAT_INPUT_YUV_8;
+    else
+        return false;
+
+    /* the output flag of a kind of format is 6 bits above the input one */
+    return (cap->input_format & flag) && (cap->output_format & (flag << 6));
+}
+
+/*
+ * Sizes along one axis of a chain from 'from' to 'to' in steps within the scale limit,
+ * 'to' included. Returns the number of steps, or -1 if there are more than max.
+ */
+static int rga_plan_scale_axis(int from, int to, int shift, int align, int *sizes, int max) {
+    int num = 0;
+    int cur;
+
+    if (from == to)
+        return 0;
+
+    if (from > to) {
+        /* downscale, the largest step first, until the rest fits in one step */
+        for (cur = from; cur > (to << shift); ) {
+            cur = ALIGN((cur + (1 << shift) - 1) >> shift, align);
+            if (num == max - 1)
+                return -1;
+            sizes[num++] = cur;
+        }
+    } else {
+        /* upscale, the largest step last, so the chain is built from the end */
+        for (cur = to; cur > (from << shift); ) {
+            cur = ALIGN((cur + (1 << shift) - 1) >> shift, align);
+            if (num == max - 1)
+                return -1;
+            sizes[num++] = cur;
+        }
+
+        for (int i = 0; i < num / 2; i++) {
+            int t = sizes[i];
+
+            sizes[i] = sizes[num - 1 - i];
+            sizes[num - 1 - i] = t;
+        }
+    }
+
+    sizes[num++] = to;
+
+    return num;
+}
+
+/* Size along one axis after step i (1 based) of a chain of num steps. */
+static int rga_plan_axis_size(int from, const int *sizes, int steps, int num, int i) {
+    if (steps == 0)
+        return from;
+
+    /* A downscale is done early and an upscale late, both keep the images small. */
+    if (sizes[steps - 1] < from)
+        return i <= steps ? sizes[i - 1] : sizes[steps - 1];
+    else
+        return i <= num - steps ? from : sizes[i - (num - steps) - 1];
+}
+
+static void rga_plan_add_pass(im_plan_t *plan, int sw, int sh, int dw, int dh, int usage) {
+    im_pass_t *pass = &plan->passes[plan->num_passes++];
+
+    pass->src_width = sw;
+    pass->src_height = sh;
+    pass->dst_width = dw;
+    pass->dst_height = dh;
+    pass->usage = usage;
+
+    plan->cost += (long)sw * sh + (long)dw * dh;
+}
+
+static void rga_plan_set_format(im_pass_t *pass, int src_format, int dst_format, int color_space_mode) {
+    bool src_yuv = NormalRgaIsYuvFormat(RkRgaGetRgaFormat(src_format));
+    bool dst_yuv = NormalRgaIsYuvFormat(RkRgaGetRgaFormat(dst_format));
+
+    pass->src_format = src_format;
+    pass->dst_format = dst_format;
+
+    /* only the pass that converts between yuv and rgb carries the color space */
+    if (src_yuv && !dst_yuv)
+        pass->color_space_mode = color_space_mode & IM_YUV_TO_RGB_MASK;
+    else if (!src_yuv && dst_yuv)
+        pass->color_space_mode = color_space_mode & IM_RGB_TO_YUV_MASK;
+    else
+        pass->color_space_mode = IM_COLOR_SPACE_DEFAULT;
+}
+
+/* The src and dst of pass i of the plan, intermediate buffers are given by inter. */
+static void rga_plan_pass_buffers(const im_plan_t *plan, int i, const rga_buffer_t *inter,
+                                  rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                  rga_buffer_t *psrc, rga_buffer_t *pdst, im_rect *psrect, im_rect *pdrect) {
+    const im_pass_t *pass = &plan->passes[i];
+
+    if (i == 0) {
+        *psrc = src;
+        *psrect = srect;
+    } else {
+        *psrc = inter[i - 1];
+        psrect->x = 0;
+        psrect->y = 0;
+        psrect->width = pass->src_width;
+        psrect->height = pass->src_height;
+    }
+
+    if (i == plan->num_passes - 1) {
+        *pdst = dst;
+        *pdrect = drect;
+    } else {
+        *pdst = inter[i];
+        pdrect->x = 0;
+        pdrect->y = 0;
+        pdrect->width = pass->dst_width;
+        pdrect->height = pass->dst_height;
+    }
+
+    psrc->color_space_mode = IM_COLOR_SPACE_DEFAULT;
+    pdst->color_space_mode = pass->color_space_mode;
+}
+
+static IM_STATUS rga_plan_build(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                int usage, im_plan_t *plan) {
+    im_capability_t cap;
+    int xs[IM_MAX_PASSES], ys[IM_MAX_PASSES];
+    int nx, ny, num, rotate_at, shift, align, inter_format;
+    int width[IM_MAX_PASSES + 1], height[IM_MAX_PASSES + 1];
+    int transform = usage & IM_HAL_TRANSFORM_MASK;
+    bool transpose = transform == IM_HAL_TRANSFORM_ROT_90 || transform == IM_HAL_TRANSFORM_ROT_270;
+    int candidates[3];
+    float bpp = 0;
+    long info;
+    IM_STATUS ret;
+
+    memset(plan, 0, sizeof(im_plan_t));
+
+    /* copy, resize, cvtcolor, rotate and flip */
+    if (usage & ~(IM_HAL_TRANSFORM_MASK | IM_SYNC | IM_CROP)) {
+        imErrorMsg("Only copy, resize, cvtcolor, rotate and flip can be split into passes.");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    ret = imquerycapability(&cap);
+    if (ret != IM_STATUS_SUCCESS)
+        return ret;
+
+    info = rga_get_info();
+    if (info == IM_STATUS_FAILED) {
+        imErrorMsg("Get rga info failed, can not plan the passes.");
+        return IM_STATUS_FAILED;
+    }
+
+    /* the same defaults as rga_task_prepare() */
+    if (srect.width <= 0 || srect.height <= 0) {
+        srect.width = src.width;
+        srect.height = src.height;
+    }
+
+    if (drect.width <= 0 || drect.height <= 0) {
+        drect.width = dst.width;
+        drect.height = dst.height;
+        if (usage & IM_CROP) {
+            drect.width = srect.width < dst.width ? srect.width : dst.width;
+            drect.height = srect.height < dst.height ? srect.height : dst.height;
+        }
+    }
+
+    /* The cheapest format both ends can be converted through. */
+    candidates[0] = src.format;
+    candidates[1] = dst.format;
+    candidates[2] = RK_FORMAT_RGBA_8888;
+    inter_format = -1;
+    for (int i = 0; i < 3; i++) {
+        if (!rga_plan_format_usable(candidates[i], &cap))
+            continue;
+        if (inter_format < 0 || get_bpp_from_format(candidates[i]) < bpp) {
+            inter_format = candidates[i];
+            bpp = get_bpp_from_format(candidates[i]);
+        }
+    }
+
+    if (inter_format < 0) {
+        imErrorMsg("No intermediate format the rga can both read and write.");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    align = NormalRgaIsYuvFormat(RkRgaGetRgaFormat(inter_format)) ? 2 : 1;
+
+    for (shift = 1; (1 << shift) < cap.scale_limit; shift++)
+        ;
+
+    /* Scaling is planned in the frame of the src, the rotation comes on top. */
+    nx = rga_plan_scale_axis(srect.width, transpose ? drect.height : drect.width, shift, align, xs, IM_MAX_PASSES);
+    ny = rga_plan_scale_axis(srect.height, transpose ? drect.width : drect.height, shift, align, ys, IM_MAX_PASSES);
+    if (nx < 0 || ny < 0) {
+        imErrorMsg("The scaling needs more passes than supported.");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    num = nx > ny ? nx : ny;
+    for (int i = 0; i <= num; i++) {
+        width[i] = i == 0 ? srect.width : rga_plan_axis_size(srect.width, xs, nx, num, i);
+        height[i] = i == 0 ? srect.height : rga_plan_axis_size(srect.height, ys, ny, num, i);
+    }
+
+    /* A rotation cannot scale, it is a pass of its own on the smallest image of the chain. */
+    rotate_at = -1;
+    if (transpose) {
+        rotate_at = 0;
+        for (int i = 1; i <= num; i++)
+            if ((int64_t)width[i] * height[i] < (int64_t)width[rotate_at] * height[rotate_at])
+                rotate_at = i;
+    }
+
+    if (num + (transpose ? 1 : 0) > IM_MAX_PASSES) {
+        imErrorMsg("The operation needs more passes than supported.");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    if (num == 0 && !transpose)
+        rga_plan_add_pass(plan, width[0], height[0], width[0], height[0], transform);
+
+    for (int i = 0, rotated = 0; i <= num; i++) {
+        int sw = rotated ? height[i] : width[i];
+        int sh = rotated ? width[i] : height[i];
+
+        if (i == rotate_at) {
+            rga_plan_add_pass(plan, sw, sh, sh, sw, transform);
+            rotated = 1;
+            sw = height[i];
+            sh = width[i];
+        }
+
+        if (i < num) {
+            int dw = rotated ? height[i + 1] : width[i + 1];
+            int dh = rotated ? width[i + 1] : height[i + 1];
+
+            /* a flip goes along with the first scaling */
+            rga_plan_add_pass(plan, sw, sh, dw, dh, (!transpose && i == 0) ? transform : 0);
+        }
+    }
+
+    /* The format changes on the first and the last pass only. */
+    for (int i = 0; i < plan->num_passes; i++)
+        rga_plan_set_format(&plan->passes[i], i == 0 ? src.format : inter_format,
+                            i == plan->num_passes - 1 ? dst.format : inter_format, dst.color_space_mode);
+
+    /* every pass must be possible for the rga on its own */
+    for (int i = 0; i < plan->num_passes; i++) {
+        rga_buffer_t inter[IM_MAX_PASSES];
+        rga_buffer_t psrc, pdst, pat;
+        im_rect psrect, pdrect, prect;
+
+        for (int j = 0; j < plan->num_passes - 1; j++) {
+            memset(&inter[j], 0, sizeof(rga_buffer_t));
+            inter[j].width = plan->passes[j].dst_width;
+            inter[j].height = plan->passes[j].dst_height;
+            inter[j].wstride = ALIGN(inter[j].width, 16);
+            inter[j].hstride = inter[j].height;
+            inter[j].format = inter_format;
+        }
+
+        empty_structure(NULL, NULL, &pat, NULL, NULL, &prect);
+        rga_plan_pass_buffers(plan, i, inter, src, dst, srect, drect, &psrc, &pdst, &psrect, &pdrect);
+        psrc.width = psrect.width;
+        psrc.height = psrect.height;
+        pdst.width = pdrect.width;
+        pdst.height = pdrect.height;
+
+        ret = rga_check_usage(info, psrc, pdst, pat, psrect, pdrect, prect, plan->passes[i].usage);
+        if (ret <= 0) {
+            plan->num_passes = 0;
+            return ret;
+        }
+    }
+
+    return IM_STATUS_SUCCESS;
+}
+
+static IM_STATUS rga_plan_process(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                  const im_plan_t *plan) {
+    rga_buffer_t inter[IM_MAX_PASSES];
+    rga_pool_buffer_t bufs[IM_MAX_PASSES];
+    im_job job;
+    int num = 0;
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+
+    /* the same defaults as rga_task_prepare() */
+    if (srect.width <= 0 || srect.height <= 0) {
+        srect.width = src.width;
+        srect.height = src.height;
+    }
+
+    if (drect.width <= 0 || drect.height <= 0) {
+        drect.width = plan->passes[plan->num_passes - 1].dst_width;
+        drect.height = plan->passes[plan->num_passes - 1].dst_height;
+    }
+
+    for (num = 0; num < plan->num_passes - 1; num++) {
+        const im_pass_t *pass = &plan->passes[num];
+
+        ret = rga_pool_get_buffer(pass->dst_width, pass->dst_height, pass->dst_format, &bufs[num], &inter[num]);
+        if (ret != IM_STATUS_SUCCESS)
+            break;
+    }
+
+    for (int i = 0; i < plan->num_passes && ret == IM_STATUS_SUCCESS; i++) {
+        rga_buffer_t psrc, pdst;
+        im_rect psrect, pdrect;
+
+        rga_plan_pass_buffers(plan, i, inter, src, dst, srect, drect, &psrc, &pdst, &psrect, &pdrect);
+        ret = rga_job_add(&job, psrc, psrect, pdst, pdrect, plan->passes[i].usage);
+    }
+
+    /* The intermediate buffers are given back here, a multi-pass operation is always synchronous. */
+    if (ret == IM_STATUS_SUCCESS)
+        ret = rga_job_submit(&job, 1);
+
+    for (int i = 0; i < num; i++)
+        rga_pool_put(&bufs[i]);
+
+    return ret;
+}
+
+IM_API IM_STATUS imqueryplan(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                             im_rect srect, im_rect drect, im_rect prect, int usage, im_plan_t *plan) {
+    IM_STATUS ret;
+
+    if (plan == NULL) {
+        imErrorMsg("Plan is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    memset(plan, 0, sizeof(im_plan_t));
+
+    if ((usage & IM_ALPHA_BLEND_MASK) && rga_is_buffer_valid(pat))
+        ret = imcheck_composite(src, dst, pat, srect, drect, prect, usage);
+    else
+        ret = imcheck(src, dst, srect, drect, usage);
+
+    if (ret > 0) {
+        rga_plan_add_pass(plan, srect.width > 0 ? srect.width : src.width,
+                          srect.height > 0 ? srect.height : src.height,
+                          drect.width > 0 ? drect.width : dst.width,
+                          drect.height > 0 ? drect.height : dst.height,
+                          usage & IM_HAL_TRANSFORM_MASK);
+        rga_plan_set_format(&plan->passes[0], src.format, dst.format, dst.color_space_mode);
+
+        return IM_STATUS_SUCCESS;
+    }
+
+    return rga_plan_build(src, dst, srect, drect, usage, plan);
+}
+
+/*
+ * ImPipeline
+ *
+ * fold() walks the stages keeping the image as it is at each point of the chain: the
+ * source region it comes from (in source pixels, fractional until the end), its size
+ * before the transform, and the transform so far as a flip followed by a rotation.
+ */
+ImPipeline::ImPipeline() : mFolded(false) {
+}
+
+ImPipeline& ImPipeline::add(int type, im_rect rect, int arg0, int arg1) {
+    Stage stage;
+
+    stage.type = type;
+    stage.rect = rect;
+    stage.arg0 = arg0;
+    stage.arg1 = arg1;
+    mStages.push_back(stage);
+    mFolded = false;
+
+    return *this;
+}
+
+ImPipeline& ImPipeline::crop(im_rect rect) {
+    return add(STAGE_CROP, rect, 0, 0);
+}
+
+ImPipeline& ImPipeline::resize(int width, int height) {
+    im_rect rect = {0, 0, width, height};
+
+    return add(STAGE_RESIZE, rect, 0, 0);
+}
+
+ImPipeline& ImPipeline::cvtcolor(int format, int mode) {
+    im_rect rect = {0, 0, 0, 0};
+
+    return add(STAGE_CVTCOLOR, rect, format, mode);
+}
+
+ImPipeline& ImPipeline::rotate(int rotation) {
+    im_rect rect = {0, 0, 0, 0};
+
+    return add(STAGE_ROTATE, rect, rotation, 0);
+}
+
+ImPipeline& ImPipeline::flip(int mode) {
+    im_rect rect = {0, 0, 0, 0};
+
+    return add(STAGE_FLIP, rect, mode, 0);
+}
+
+void ImPipeline::reset() {
+    mStages.clear();
+    mFolded = false;
+}
+
+IM_STATUS ImPipeline::fold(const rga_buffer_t &src) {
+    double rx = 0, ry = 0, rw = src.width, rh = src.height;
+    int uw = src.width, uh = src.height;
+    int flip = 0, rot = 0;
+    int format = -1, mode = 0;
+    int width, height;
+    bool yuv;
+    im_rect rect;
+
+    if (mFolded && mSrcWidth == src.width && mSrcHeight == src.height && mSrcFormat == src.format)
+        return IM_STATUS_SUCCESS;
+
+    mFolded = false;
+
+    for (size_t i = 0; i < mStages.size(); i++) {
+        const Stage &stage = mStages[i];
+        bool swap = rot == 90 || rot == 270;
+
+        width = swap ? uh : uw;
+        height = swap ? uw : uh;
+
+        switch (stage.type) {
+            case STAGE_CROP:
+                rect = stage.rect;
+                if (rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+                    rect.x + rect.width > width || rect.y + rect.height > height) {
+                    imErrorMsg("Pipeline crop rect is outside of the image.");
+                    return IM_STATUS_INVALID_PARAM;
+                }
+
+                /* back to the orientation of the source, undo the rotation then the flip */
+                if (rot == 90)
+                    rect = rga_tile_transform_rect(rect, width, height, IM_HAL_TRANSFORM_ROT_270);
+                else if (rot == 180)
+                    rect = rga_tile_transform_rect(rect, width, height, IM_HAL_TRANSFORM_ROT_180);
+                else if (rot == 270)
+                    rect = rga_tile_transform_rect(rect, width, height, IM_HAL_TRANSFORM_ROT_90);
+                if (flip)
+                    rect = rga_tile_transform_rect(rect, uw, uh, IM_HAL_TRANSFORM_FLIP_H);
+
+                rx += rect.x * rw / uw;
+                ry += rect.y * rh / uh;
+                rw = rect.width * rw / uw;
+                rh = rect.height * rh / uh;
+                uw = rect.width;
+                uh = rect.height;
+                break;
+
+            case STAGE_RESIZE:
+                if (stage.rect.width <= 0 || stage.rect.height <= 0) {
+                    imErrorMsg("Pipeline resize to an empty size.");
+                    return IM_STATUS_INVALID_PARAM;
+                }
+                uw = swap ? stage.rect.height : stage.rect.width;
+                uh = swap ? stage.rect.width : stage.rect.height;
+                break;
+
+            case STAGE_CVTCOLOR:
+                format = stage.arg0;
+                if (stage.arg1)
+                    mode = stage.arg1;
+                break;
+
+            case STAGE_ROTATE:
+                switch (stage.arg0) {
+                    case IM_HAL_TRANSFORM_ROT_90:
+                        rot = (rot + 90) % 360;
+                        break;
+                    case IM_HAL_TRANSFORM_ROT_180:
+                        rot = (rot + 180) % 360;
+                        break;
+                    case IM_HAL_TRANSFORM_ROT_270:
+                        rot = (rot + 270) % 360;
+                        break;
+                    default:
+                        imErrorMsg("Pipeline rotation must be one of IM_HAL_TRANSFORM_ROT_*.");
+                        return IM_STATUS_INVALID_PARAM;
+                }
+                break;
+
+            case STAGE_FLIP:
+                /* a mirror after a rotation r is the mirror before a rotation -r */
+                if (stage.arg0 == IM_HAL_TRANSFORM_FLIP_H) {
+                    rot = (360 - rot) % 360;
+                } else if (stage.arg0 == IM_HAL_TRANSFORM_FLIP_V) {
+                    rot = (540 - rot) % 360;
+                } else {
+                    imErrorMsg("Pipeline flip must be IM_HAL_TRANSFORM_FLIP_H or IM_HAL_TRANSFORM_FLIP_V.");
+                    return IM_STATUS_INVALID_PARAM;
+                }
+                flip ^= 1;
+                break;
+        }
+    }
+
+    /* whole pixels, and whole chroma samples for yuv */
+    yuv = NormalRgaIsYuvFormat(RkRgaGetRgaFormat(src.format));
+    mSrcRect.x = (int)(rx + 0.5);
+    mSrcRect.y = (int)(ry + 0.5);
+    mSrcRect.width = (int)(rx + rw + 0.5) - mSrcRect.x;
+    mSrcRect.height = (int)(ry + rh + 0.5) - mSrcRect.y;
+    if (yuv) {
+        mSrcRect.x &= ~1;
+        mSrcRect.y &= ~1;
+        mSrcRect.width &= ~1;
+        mSrcRect.height &= ~1;
+    }
+    if (mSrcRect.width <= 0 || mSrcRect.height <= 0) {
+        imErrorMsg("Pipeline crops the image to nothing.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    mDstRect.x = 0;
+    mDstRect.y = 0;
+    mDstRect.width = (rot == 90 || rot == 270) ? uh : uw;
+    mDstRect.height = (rot == 90 || rot == 270) ? uw : uh;
+
+    mUsage = 0;
+    if (rot == 90)
+        mUsage |= IM_HAL_TRANSFORM_ROT_90;
+    else if (rot == 180)
+        mUsage |= IM_HAL_TRANSFORM_ROT_180;
+    else if (rot == 270)
+        mUsage |= IM_HAL_TRANSFORM_ROT_270;
+    if (flip)
+        mUsage |= IM_HAL_TRANSFORM_FLIP_H;
+
+    mDstFormat = format;
+    mColorSpaceMode = mode;
+    mSrcWidth = src.width;
+    mSrcHeight = src.height;
+    mSrcFormat = src.format;
+    mFolded = true;
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS ImPipeline::run(rga_buffer_t src, rga_buffer_t dst, int sync) {
+    rga_buffer_t pat;
+    im_rect prect;
+    IM_STATUS ret;
+
+    ret = fold(src);
+    if (ret != IM_STATUS_SUCCESS)
+        return ret;
+
+    if (mDstRect.width > dst.width || mDstRect.height > dst.height) {
+        imErrorMsg("Pipeline output is larger than dst.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (mDstFormat != -1)
+        dst.format = mDstFormat;
+    if (mColorSpaceMode)
+        dst.color_space_mode = mColorSpaceMode;
+
+    empty_structure(NULL, NULL, &pat, NULL, NULL, &prect);
+
+    return improcess(src, dst, pat, mSrcRect, mDstRect, prect, mUsage | (sync ? 0 : IM_SYNC));
+}
+
+IM_STATUS ImPipeline::query(rga_buffer_t src, rga_buffer_t dst, im_plan_t *plan) {
+    rga_buffer_t pat;
+    im_rect prect;
+    IM_STATUS ret;
+
+    ret = fold(src);
+    if (ret != IM_STATUS_SUCCESS)
+        return ret;
+
+    if (mDstFormat != -1)
+        dst.format = mDstFormat;
+    if (mColorSpaceMode)
+        dst.color_space_mode = mColorSpaceMode;
+
+    empty_structure(NULL, NULL, &pat, NULL, NULL, &prect);
+
+    return imqueryplan(src, dst, pat, mSrcRect, mDstRect, prect, mUsage, plan);
+}
+
+IM_API IM_STATUS imendJob(im_job_handle_t job, int sync, IM_STATUS *task_status, int num) {
+    IM_STATUS ret;
+
+    if (job == NULL) {
+        imErrorMsg("Job is NULL, please call imbeginJob() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    ret = rga_job_submit(job, sync);
+
+    if (task_status != NULL)
+        for (int i = 0; i < num && i < (int)job->tasks.size(); i++)
+            task_status[i] = job->tasks[i].status;
+
+    delete job;
+
+    return ret;
+}
+
+IM_API IM_STATUS imcancelJob(im_job_handle_t job) {
+    if (job == NULL) {
+        imErrorMsg("Job is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    delete job;
+
+    return IM_STATUS_SUCCESS;
+}
+
+/*
+ * Compiled operations
+ *
+ * imcompile() does the checks and the request building of rga_task_prepare() once,
+ * imexecute() only puts the addresses of new buffers into a copy of the prepared
+ * task and submits it. The desc is never written after imcompile(), several threads
+ * may execute it at the same time.
+ */
+struct im_desc {
+    im_task_t task;
+    /* the buffers the task was prepared for, new ones must have the same geometry */
+    rga_buffer_t src;
+    rga_buffer_t dst;
+    rga_buffer_t pat;
+};
+
+static bool rga_desc_match(const rga_buffer_t &compiled, const rga_buffer_t &buf) {
+    return compiled.width == buf.width && compiled.height == buf.height &&
+           compiled.wstride == buf.wstride && compiled.hstride == buf.hstride &&
+           compiled.format == buf.format;
+}
+
+/* replace the address of a prepared rga_info_t, the rest of it stays as checked */
+static IM_STATUS rga_desc_patch(const rga_buffer_t &compiled, const rga_buffer_t &buf,
+                                rga_info_t *info, const char *name) {
+    if (!rga_desc_match(compiled, buf)) {
+        imErrorMsg((string(name) + " does not have the size, stride and format the desc was compiled for.").c_str());
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    info->fd = 0;
+    info->virAddr = NULL;
+    info->phyAddr = NULL;
+
+    return rga_set_buffer_info(buf, info);
+}
+
+IM_API IM_STATUS imcompile(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                           im_rect srect, im_rect drect, im_rect prect, int usage, im_desc_handle_t *desc) {
+    im_desc_handle_t d;
+    im_capability_t cap;
+    im_plan_t plan;
+    IM_STATUS ret;
+
+    if (desc == NULL) {
+        imErrorMsg("Desc is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+    *desc = NULL;
+
+    /* only what improcess() does as one task can be compiled */
+    if (rga_tile_required(src, dst, srect, drect, usage, &cap)) {
+        imErrorMsg("Larger than one pass of the rga can take, use improcess().");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    d = new(std::nothrow) im_desc;
+    if (d == NULL) {
+        imErrorMsg("Failed to alloc desc.");
+        return IM_STATUS_OUT_OF_MEMORY;
+    }
+
+    ret = rga_task_prepare(src, dst, pat, srect, drect, prect, usage, &d->task);
+    if (ret > 0 && d->task.soft &&
+        rga_plan_build(src, dst, srect, drect, usage, &plan) == IM_STATUS_SUCCESS && plan.num_passes > 1) {
+        imErrorMsg("Needs several passes of the rga, use improcess().");
+        ret = IM_STATUS_NOT_SUPPORTED;
+    }
+    if (ret <= 0) {
+        delete d;
+        return ret;
+    }
+
+    d->src = src;
+    d->dst = dst;
+    d->pat = pat;
+    *desc = d;
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS imexecute_t(im_desc_handle_t desc, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat) {
+    im_task_t task;
+    IM_STATUS ret;
+
+    if (desc == NULL) {
+        imErrorMsg("Desc is NULL, please call imcompile() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    task = desc->task;
+
+    if (~task.usage & IM_COLOR_FILL) {
+        ret = rga_desc_patch(desc->src, src, &task.srcinfo, "src");
+        if (ret <= 0)
+            return ret;
+    }
+
+    ret = rga_desc_patch(desc->dst, dst, &task.dstinfo, "dst");
+    if (ret <= 0)
+        return ret;
+
+    if (task.pat_enable && rga_is_buffer_valid(pat)) {
+        ret = rga_desc_patch(desc->pat, pat, &task.patinfo, "pat");
+        if (ret <= 0)
+            return ret;
+    }
+
+    return rga_task_submit(&task);
+}
+
+IM_API IM_STATUS imexecute(im_desc_handle_t desc, int src_fd, int dst_fd) {
+    rga_buffer_t src, dst;
+
+    if (desc == NULL) {
+        imErrorMsg("Desc is NULL, please call imcompile() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    src = desc->src;
+    src.fd = src_fd;
+    src.vir_addr = NULL;
+    src.phy_addr = NULL;
+
+    dst = desc->dst;
+    dst.fd = dst_fd;
+    dst.vir_addr = NULL;
+    dst.phy_addr = NULL;
+
+    return imexecute_t(desc, src, dst, desc->pat);
+}
+
+IM_API IM_STATUS imdestroyDesc(im_desc_handle_t desc) {
+    if (desc == NULL) {
+        imErrorMsg("Desc is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    delete desc;
+
+    return IM_STATUS_SUCCESS;
+}
+
+/*
+ * Multi-rect fill
+ *
+ * The first rect goes through the full check, the others only through the rect
+ * checks against the same dst and reuse its prepared task. A rect smaller than
+ * RGA_FILL_CPU_PIXELS on a buffer the cpu can reach directly costs less to fill
+ * on the cpu than the ioctl of a request, it is filled by the cpu backend as
+ * long as it does not overlap a rect left to the rga, so that the order of the
+ * overlapping rects is kept.
+ */
+#define RGA_FILL_CPU_PIXELS     (128 * 128)
+
+static IM_STATUS rga_fill_rect_check(const rga_buffer_t &dst, const im_rect &rect, bool yuv) {
+    if (rect.width < 2 || rect.height < 2) {
+        imErrorMsg("Invaild fill rect, unsupported width and height less than 2.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (rect.x < 0 || rect.y < 0) {
+        imErrorMsg("Illegal fill rect, the parameter cannot be negative.");
+        return IM_STATUS_ILLEGAL_PARAM;
+    }
+
+    if (rect.x + rect.width > dst.wstride || rect.y + rect.height > dst.hstride) {
+        imErrorMsg("Invaild fill rect, the sum of widtn and height of rect needs to be less than dst wstride or hstride.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (yuv && ((rect.x % 2) || (rect.y % 2) || (rect.width % 2) || (rect.height % 2))) {
+        imErrorMsg("Err yuv not align to 2.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    return IM_STATUS_SUCCESS;
+}
+
+static bool rga_rect_overlap(const im_rect &a, const im_rect &b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+           a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+/* the fill tasks of the rects, appended to job only if all of them are valid */
+static IM_STATUS rga_job_add_fills(im_job_handle_t job, rga_buffer_t dst, const im_rect *rects,
+                                   const int *colors, int num, int usage) {
+    im_task_t first;
+    rga_buffer_t src, pat;
+    im_rect srect, prect;
+    vector<bool> cpu;
+    bool yuv, changed;
+    IM_STATUS ret;
+
+    if (rects == NULL || colors == NULL || num <= 0) {
+        imErrorMsg("Fill rects or colors is NULL, or the number of rects is invalid.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    empty_structure(&src, NULL, &pat, &srect, NULL, &prect);
+
+    dst.color = colors[0];
+    ret = rga_task_prepare(src, dst, pat, srect, rects[0], prect, usage, &first);
+    if (ret <= 0)
+        return ret;
+
+    yuv = NormalRgaIsYuvFormat(RkRgaGetRgaFormat(dst.format));
+    for (int i = 1; i < num; i++) {
+        ret = rga_fill_rect_check(dst, rects[i], yuv);
+        if (ret <= 0)
+            return ret;
+    }
+
+    /* tiny rects on the cpu, unless they overlap one the rga fills */
+    cpu.resize(num);
+    for (int i = 0; i < num; i++)
+        cpu[i] = !first.soft && dst.vir_addr != NULL && dst.phy_addr == NULL && dst.fd <= 0 &&
+                 rkRga.RkRgaGetBackendMode() == RGA_BACKEND_AUTO &&
+                 rkRga.RkRgaGetBackend() == RGA_BACKEND_HW &&
+                 SoftRgaIsFormatSupported(RkRgaGetRgaFormat(dst.format)) &&
+                 (long)rects[i].width * rects[i].height < RGA_FILL_CPU_PIXELS;
+    do {
+        changed = false;
+        for (int i = 0; i < num; i++) {
+            if (!cpu[i])
+                continue;
+            for (int j = 0; j < num; j++) {
+                if (!cpu[j] && rga_rect_overlap(rects[i], rects[j])) {
+                    cpu[i] = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    } while (changed);
+
+    /* the cpu rects first, so that the last task of the job is one the rga completes */
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < num; i++) {
+            im_task_t task;
+
+            if (cpu[i] != (pass == 0))
+                continue;
+
+            task = first;
+            rga_set_rect(&task.dstinfo.rect, rects[i].x, rects[i].y, rects[i].width, rects[i].height,
+                         dst.wstride, dst.hstride, dst.format);
+            task.dstinfo.color = colors[i];
+            task.soft = task.soft || cpu[i];
+            job->tasks.push_back(task);
+        }
+    }
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS imfillArrayColors_t(rga_buffer_t dst, const im_rect *rects, const int *colors, int num, int sync) {
+    im_job job;
+    int usage = IM_COLOR_FILL;
+    IM_STATUS ret;
+
+    if (sync == 0)
+        usage |= IM_SYNC;
+
+    ret = rga_job_add_fills(&job, dst, rects, colors, num, usage);
+    if (ret != IM_STATUS_SUCCESS)
+        return ret;
+
+    return rga_job_submit(&job, sync);
+}
+
+IM_API IM_STATUS imfillArray_t(rga_buffer_t dst, const im_rect *rects, int num, int color, int sync) {
+    vector<int> colors;
+
+    if (num <= 0) {
+        imErrorMsg("The number of fill rects is invalid.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    colors.assign(num, color);
+
+    return imfillArrayColors_t(dst, rects, &colors[0], num, sync);
+}
+
+/*
+ * NN preprocess
+ *
+ * The resize/csc pass, with the quantize when the rga does it, and the fill of the
+ * letterbox borders are one job on the tensor, or on an intermediate of the pool for
+ * NCHW. The cpu is only left the split to planes, and the quantize the rga cannot do.
+ */
+static void rga_nn_content(const im_rect &srect, const rga_buffer_t &dst, int resize, im_rect *content) {
+    content->x = 0;
+    content->y = 0;
+    content->width = dst.width;
+    content->height = dst.height;
+
+    if (resize != IM_NN_RESIZE_LETTERBOX)
+        return;
+
+    /* a border the rga cannot fill (less than 2) is stretched over instead */
+    if ((long)srect.width * dst.height > (long)srect.height * dst.width) {
+        int height = (int)(((long)dst.width * srect.height * 2 + srect.width) / (srect.width * 2));
+
+        if (dst.height - height >= 4) {
+            content->height = height;
+            content->y = (dst.height - height) / 2;
+        }
+    } else {
+        int width = (int)(((long)dst.height * srect.width * 2 + srect.height) / (srect.height * 2));
+
+        if (dst.width - width >= 4) {
+            content->width = width;
+            content->x = (dst.width - width) / 2;
+        }
+    }
+}
+
+/* the NN quantize of the rga on a 0xAABBGGRR color, for the borders it does not go through */
+static int rga_nn_quantize_color(int color, const im_nn_t &nn) {
+    int scale[3] = { nn.scale_r, nn.scale_g, nn.scale_b };
+    int offset[3] = { nn.offset_r, nn.offset_g, nn.offset_b };
+    unsigned int out = (unsigned int)color & 0xff000000;
+
+    for (int c = 0; c < 3; c++) {
+        int v = (color >> (c * 8)) & 0xff;
+        int off = (offset[c] & 0x100) ? -(offset[c] & 0xff) : (offset[c] & 0xff);
+
+        v = ((v + off) * (scale[c] & 0x3ff)) >> 8;
+        v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        out |= (unsigned int)v << (c * 8);
+    }
+
+    return (int)out;
+}
+
+static IM_STATUS rga_nn_submit(rga_buffer_t src, im_rect srect, rga_buffer_t dst, const im_rect &content,
+                               const im_nn_preprocess_t *param, bool *rga_quant) {
+    im_job job;
+    im_task_t task;
+    rga_buffer_t no_src, pat;
+    im_rect no_rect, prect, borders[2];
+    int usage = 0, num = 0;
+    IM_STATUS ret;
+
+    empty_structure(&no_src, NULL, &pat, &no_rect, NULL, &prect);
+
+    if (*rga_quant) {
+        usage |= IM_NN_QUANTIZE;
+        dst.nn = param->nn;
+    }
+
+    ret = rga_task_prepare(src, dst, pat, srect, content, prect, usage, &task);
+    /* the cpu backend has no NN quantize */
+    if (ret > 0 && *rga_quant && (task.soft || rkRga.RkRgaGetBackend() == RGA_BACKEND_SW)) {
+        *rga_quant = false;
+        usage &= ~IM_NN_QUANTIZE;
+        ret = rga_task_prepare(src, dst, pat, srect, content, prect, usage, &task);
+    }
+
+    if (content.y > 0) {
+        im_rect top = { 0, 0, dst.width, content.y };
+        im_rect bottom = { 0, content.y + content.height, dst.width, dst.height - content.y - content.height };
+
+        borders[num++] = top;
+        borders[num++] = bottom;
+    } else if (content.x > 0) {
+        im_rect left = { 0, 0, content.x, dst.height };
+        im_rect right = { content.x + content.width, 0, dst.width - content.x - content.width, dst.height };
+
+        borders[num++] = left;
+        borders[num++] = right;
+    }
+    dst.color = *rga_quant ? rga_nn_quantize_color(param->pad_color, param->nn) : param->pad_color;
+
+    /* more than one pass of the rga, go through improcess() and leave the quantize to the cpu */
+    if (ret <= 0) {
+        *rga_quant = false;
+
+        if (num > 0) {
+            ret = imfillArray_t(dst, borders, num, param->pad_color, 1);
+            if (ret != IM_STATUS_SUCCESS)
+                return ret;
+        }
+
+        return improcess(src, dst, pat, srect, content, prect, 0);
+    }
+
+    /* the borders last, the sync fill of the rga then also covers a resize done by the cpu */
+    job.tasks.push_back(task);
+    for (int i = 0; i < num; i++) {
+        ret = rga_task_prepare(no_src, dst, pat, no_rect, borders[i], prect, IM_COLOR_FILL, &task);
+        if (ret <= 0)
+            return ret;
+        job.tasks.push_back(task);
+    }
+
+    return rga_job_submit(&job, 1);
+}
+
+/* the cpu view of a buffer, the physical address is of no use there */
+static IM_STATUS rga_nn_cpu_info(const rga_buffer_t &buf, rga_info_t *info) {
+    memset(info, 0, sizeof(rga_info_t));
+    info->fd = -1;
+
+    if (buf.fd > 0) {
+        info->fd = buf.fd;
+    } else if (buf.vir_addr != NULL) {
+        info->virAddr = buf.vir_addr;
+    } else {
+        imErrorMsg("The NN tensor layout and quantize by the cpu need a fd or virtual address.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    rga_set_rect(&info->rect, 0, 0, buf.width, buf.height, buf.wstride, buf.hstride, buf.format);
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS imnnpreprocess(const rga_buffer_t src, rga_buffer_t dst, im_rect srect,
+                                const im_nn_preprocess_t *param, im_rect *content) {
+    rga_pool_buffer_t poolbuf;
+    rga_buffer_t target;
+    rga_info_t tinfo, dinfo;
+    rga_nn_t nn;
+    im_rect rect;
+    bool planar, rga_quant;
+    IM_STATUS ret;
+
+    if (param == NULL) {
+        imErrorMsg("NN preprocess param is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (dst.format != RK_FORMAT_RGB_888 && dst.format != RK_FORMAT_BGR_888) {
+        imErrorMsg("NN tensor must be RGB_888 or BGR_888.");
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    if (param->resize < IM_NN_RESIZE_STRETCH || param->resize > IM_NN_RESIZE_LETTERBOX ||
+        param->layout < IM_NN_LAYOUT_NHWC || param->layout > IM_NN_LAYOUT_NCHW ||
+        param->quantize < IM_NN_QUANT_NONE || param->quantize > IM_NN_QUANT_CPU) {
+        imErrorMsg("Invalid resize, layout or quantize mode of NN preprocess.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (srect.width <= 0 || srect.height <= 0) {
+        srect.x = 0;
+        srect.y = 0;
+        srect.width = src.width;
+        srect.height = src.height;
+    }
+
+    if (srect.width <= 0 || srect.height <= 0 || dst.width <= 0 || dst.height <= 0) {
+        imErrorMsg("Invalid src rect or tensor size.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    rga_nn_content(srect, dst, param->resize, &rect);
+    if (content != NULL)
+        *content = rect;
+
+    planar = param->layout == IM_NN_LAYOUT_NCHW;
+    rga_quant = param->quantize == IM_NN_QUANT_AUTO;
+
+    /* NCHW: the rga writes NHWC to an intermediate, split to planes by the cpu */
+    target = dst;
+    if (planar) {
+        ret = rga_pool_get_buffer(dst.width, dst.height, dst.format, &poolbuf, &target);
+        if (ret != IM_STATUS_SUCCESS)
+            return ret;
+    }
+
+    ret = rga_nn_submit(src, srect, target, rect, param, &rga_quant);
+    /* the NN quantize is on few rga, do it again with the cpu quantize */
+    if (ret != IM_STATUS_SUCCESS && rga_quant) {
+        rga_quant = false;
+        ret = rga_nn_submit(src, srect, target, rect, param, &rga_quant);
+    }
+
+    if (ret == IM_STATUS_SUCCESS && (planar || (param->quantize != IM_NN_QUANT_NONE && !rga_quant))) {
+        memset(&nn, 0, sizeof(rga_nn_t));
+        nn.scale_r = param->nn.scale_r;
+        nn.scale_g = param->nn.scale_g;
+        nn.scale_b = param->nn.scale_b;
+        nn.offset_r = param->nn.offset_r;
+        nn.offset_g = param->nn.offset_g;
+        nn.offset_b = param->nn.offset_b;
+
+        ret = rga_nn_cpu_info(target, &tinfo);
+        if (ret == IM_STATUS_SUCCESS)
+            ret = rga_nn_cpu_info(dst, &dinfo);
+        if (ret == IM_STATUS_SUCCESS &&
+            SoftRgaNNTensor(&tinfo, &dinfo, (param->quantize != IM_NN_QUANT_NONE && !rga_quant) ? &nn : NULL,
+                            planar)) {
+            imErrorMsg("Failed to convert the NN tensor on the cpu, query log to find the cause of failure.");
+            ret = IM_STATUS_FAILED;
+        }
+    }
+
+    if (planar)
+        rga_pool_put(&poolbuf);
+
+    return ret;
+}
+
+/*
+ * The RGA driver has no fence support, so fenced jobs are run in order by a
+ * worker thread of the context they were submitted on, the shared context has
+ * one as well. It waits for the acquire fence, runs the job and signals the
+ * release fence, which is an eventfd. Like a sync_file it polls readable once
+ * signaled, so poll()/sync_wait() work on it. A job waiting for its acquire
+ * fence only holds back the jobs of its own context.
+ *
+ * The jobs queued behind one without acquire fence, on the same context, are
+ * submitted back to back with RGA_BLIT_ASYNC and retired together by a single
+ * flush, so that the rga is kept busy by one thread. Their release fences are
+ * signaled and their callbacks called, in order, after the flush.
+ *
+ * A failed or dropped job signals its release fence as well, so that nothing
+ * waits forever. The value written to the eventfd tells the status apart, see
+ * rga_fence_value(), and imwait() returns it.
+ */
+typedef struct im_async_job {
+    im_job_handle_t job;
+    int acquire_fence_fd;
+    int release_fence_fd;   /* -1 for a job with a callback only */
+    im_callback_t callback;
+    void *cookie;
+} im_async_job_t;
+
+typedef struct im_async_queue {
+    im_ctx_t ctx;
+    deque<im_async_job_t> jobs;
+    pthread_cond_t cond;
+    pthread_cond_t idle_cond;
+    int pending;            /* queued or running */
+    bool exit;              /* set by imdestroyContext(), the worker frees the queue */
+} im_async_queue_t;
+
+static pthread_mutex_t rga_async_lock = PTHREAD_MUTEX_INITIALIZER;
+/* the queues of the contexts that submitted fenced jobs, NULL for the shared one */
+static map<im_ctx_t, im_async_queue_t *> rga_async_queues;
+
+/* 1 for a job done, 2 - status for one that failed, never 0 */
+static uint64_t rga_fence_value(IM_STATUS status) {
+    if (status == IM_STATUS_SUCCESS || status == IM_STATUS_NOERROR)
+        return 1;
+
+    return (uint64_t)(2 - (int64_t)status);
+}
+
+/* the release fences of librga are the only eventfds it waits on */
+static bool rga_is_release_fence(int fence_fd) {
+    char path[64], link[64];
+    ssize_t len;
+
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fence_fd);
+    len = readlink(path, link, sizeof(link) - 1);
+    if (len <= 0)
+        return false;
+    link[len] = '\0';
+
+    return strcmp(link, "anon_inode:[eventfd]") == 0;
+}
+
+static IM_STATUS rga_wait_fence(int fence_fd, int timeout) {
+    struct pollfd fds;
+    int ret;
+
+    fds.fd = fence_fd;
+    fds.events = POLLIN;
+
+    do {
+        ret = poll(&fds, 1, timeout);
+        if (ret > 0) {
+            if (fds.revents & (POLLERR | POLLNVAL)) {
+                imErrorMsg("Fence is in error state.");
+                return IM_STATUS_FAILED;
+            }
+            return IM_STATUS_SUCCESS;
+        } else if (ret == 0) {
+            imErrorMsg("Wait fence timeout.");
+            return IM_STATUS_FAILED;
+        }
+    } while (errno == EINTR || errno == EAGAIN);
+
+    ALOGE("rga_im2d: wait fence %d fail: %s", fence_fd, strerror(errno));
+    imErrorMsg("Wait fence failed.");
+    return IM_STATUS_FAILED;
+}
+
+static void* rga_async_worker(void *arg) {
+    im_async_queue_t *queue = (im_async_queue_t *)arg;
+    vector<im_async_job_t> batch;
+    vector<IM_STATUS> status;
+    IM_STATUS ret;
+    uint64_t signal;
+    bool submitted;
+
+    imbindContext(queue->ctx);
+
+    while (1) {
+        pthread_mutex_lock(&rga_async_lock);
+        while (queue->jobs.empty() && !queue->exit)
+            pthread_cond_wait(&queue->cond, &rga_async_lock);
+
+        if (queue->jobs.empty()) {
+            pthread_mutex_unlock(&rga_async_lock);
+            break;
+        }
+
+        batch.clear();
+        batch.push_back(queue->jobs.front());
+        queue->jobs.pop_front();
+        while (batch[0].acquire_fence_fd < 0 && !queue->jobs.empty() &&
+               batch.size() < RGA_ASYNC_BATCH &&
+               queue->jobs.front().acquire_fence_fd < 0) {
+            batch.push_back(queue->jobs.front());
+            queue->jobs.pop_front();
+        }
+        pthread_mutex_unlock(&rga_async_lock);
+
+        ret = IM_STATUS_SUCCESS;
+        if (batch[0].acquire_fence_fd >= 0) {
+            ret = rga_wait_fence(batch[0].acquire_fence_fd, RGA_ACQUIRE_FENCE_TIMEOUT);
+            if (ret != IM_STATUS_SUCCESS) {
+                ALOGE("rga_im2d: acquire fence %d is not signaled, drop the job.", batch[0].acquire_fence_fd);
+            }
+            close(batch[0].acquire_fence_fd);
+        }
+
+        status.assign(batch.size(), ret);
+        submitted = false;
+        if (ret == IM_STATUS_SUCCESS) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                status[i] = rga_job_submit(batch[i].job, batch.size() == 1);
+                if (status[i] != IM_STATUS_SUCCESS) {
+                    ALOGE("rga_im2d: fenced job failed, %s", imStrError_t(status[i]));
+                } else {
+                    submitted = true;
+                }
+            }
+
+            if (batch.size() > 1 && submitted && rkRga.RkRgaFlush()) {
+                ALOGE("rga_im2d: flush of %zu fenced jobs failed.", batch.size());
+                for (size_t i = 0; i < batch.size(); i++)
+                    if (status[i] == IM_STATUS_SUCCESS)
+                        status[i] = IM_STATUS_FAILED;
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            delete batch[i].job;
+
+            /* Signal even on failure, a consumer must never wait forever. */
+            if (batch[i].release_fence_fd >= 0) {
+                signal = rga_fence_value(status[i]);
+                if (write(batch[i].release_fence_fd, &signal, sizeof(signal)) != sizeof(signal)) {
+                    ALOGE("rga_im2d: signal release fence fail: %s", strerror(errno));
+                }
+                close(batch[i].release_fence_fd);
+            }
+
+            if (batch[i].callback)
+                batch[i].callback(status[i], batch[i].cookie);
+        }
+
+        pthread_mutex_lock(&rga_async_lock);
+        queue->pending -= batch.size();
+        if (queue->pending == 0)
+            pthread_cond_broadcast(&queue->idle_cond);
+        pthread_mutex_unlock(&rga_async_lock);
+    }
+
+    pthread_cond_destroy(&queue->cond);
+    pthread_cond_destroy(&queue->idle_cond);
+    delete queue;
+
+    return NULL;
+}
+
+/* The queue of ctx, with its worker started. Called with rga_async_lock held. */
+static im_async_queue_t *rga_async_get_queue(im_ctx_t ctx) {
+    map<im_ctx_t, im_async_queue_t *>::iterator it;
+    im_async_queue_t *queue;
+    pthread_t worker;
+
+    it = rga_async_queues.find(ctx);
+    if (it != rga_async_queues.end())
+        return it->second;
+
+    queue = new(std::nothrow) im_async_queue_t;
+    if (queue == NULL)
+        return NULL;
+
+    queue->ctx = ctx;
+    queue->pending = 0;
+    queue->exit = false;
+    pthread_cond_init(&queue->cond, NULL);
+    pthread_cond_init(&queue->idle_cond, NULL);
+
+    if (pthread_create(&worker, NULL, rga_async_worker, queue) != 0) {
+        ALOGE("rga_im2d: create async worker fail.");
+        pthread_cond_destroy(&queue->cond);
+        pthread_cond_destroy(&queue->idle_cond);
+        delete queue;
+        return NULL;
+    }
+    pthread_detach(worker);
+
+    rga_async_queues[ctx] = queue;
+
+    return queue;
+}
+
+/* Wait for the fenced jobs of ctx, then stop its worker if stop is set. */
+static void rga_async_drain(im_ctx_t ctx, bool stop) {
+    map<im_ctx_t, im_async_queue_t *>::iterator it;
+    im_async_queue_t *queue;
+
+    pthread_mutex_lock(&rga_async_lock);
+
+    it = rga_async_queues.find(ctx);
+    if (it != rga_async_queues.end()) {
+        queue = it->second;
+        while (queue->pending > 0)
+            pthread_cond_wait(&queue->idle_cond, &rga_async_lock);
+
+        if (stop) {
+            rga_async_queues.erase(it);
+            queue->exit = true;
+            pthread_cond_signal(&queue->cond);
+        }
+    }
+
+    pthread_mutex_unlock(&rga_async_lock);
+}
+
+static IM_STATUS rga_async_submit(im_job_handle_t job, int acquire_fence_fd, int *release_fence_fd,
+                                  im_callback_t callback, void *cookie) {
+    im_async_job_t async_job;
+    im_async_queue_t *queue;
+
+    async_job.job = job;
+    async_job.acquire_fence_fd = -1;
+    async_job.release_fence_fd = -1;
+    async_job.callback = callback;
+    async_job.cookie = cookie;
+
+    if (release_fence_fd != NULL) {
+        /* non blocking, imwait() must not hang on a value another waiter holds */
+        async_job.release_fence_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (async_job.release_fence_fd < 0) {
+            ALOGE("rga_im2d: create release fence fail: %s", strerror(errno));
+            imErrorMsg("Failed to create release fence.");
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+
+        *release_fence_fd = dup(async_job.release_fence_fd);
+        if (*release_fence_fd < 0)
+            goto err_release;
+    }
+
+    /* The caller keeps the ownership of its acquire fence. */
+    if (acquire_fence_fd >= 0) {
+        async_job.acquire_fence_fd = dup(acquire_fence_fd);
+        if (async_job.acquire_fence_fd < 0)
+            goto err_acquire;
+    }
+
+    pthread_mutex_lock(&rga_async_lock);
+
+    queue = rga_async_get_queue(rga_thread_ctx);
+    if (queue == NULL) {
+        pthread_mutex_unlock(&rga_async_lock);
+        goto err_worker;
+    }
+
+    queue->jobs.push_back(async_job);
+    queue->pending++;
+    pthread_cond_signal(&queue->cond);
+
+    pthread_mutex_unlock(&rga_async_lock);
+
+    return IM_STATUS_SUCCESS;
+
+err_worker:
+    if (async_job.acquire_fence_fd >= 0)
+        close(async_job.acquire_fence_fd);
+err_acquire:
+    if (release_fence_fd != NULL) {
+        close(*release_fence_fd);
+        *release_fence_fd = -1;
+    }
+err_release:
+    if (async_job.release_fence_fd >= 0)
+        close(async_job.release_fence_fd);
+    imErrorMsg("Failed to submit fenced job.");
+    return IM_STATUS_FAILED;
+}
+
+IM_API IM_STATUS improcess_fence(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                 im_rect srect, im_rect drect, im_rect prect,
+                                 int acquire_fence_fd, int *release_fence_fd, int usage) {
+    im_job_handle_t job;
+    IM_STATUS ret;
+
+    /* No release fence requested, behave as improcess() once the acquire fence signaled. */
+    if (release_fence_fd == NULL) {
+        if (acquire_fence_fd >= 0) {
+            ret = rga_wait_fence(acquire_fence_fd, RGA_ACQUIRE_FENCE_TIMEOUT);
+            if (ret != IM_STATUS_SUCCESS)
+                return ret;
+        }
+
+        return improcess(src, dst, pat, srect, drect, prect, usage);
+    }
+
+    *release_fence_fd = -1;
+
+    job = imbeginJob();
+    if (job == NULL)
+        return IM_STATUS_OUT_OF_MEMORY;
+
+    ret = imaddTask(job, src, dst, pat, srect, drect, prect, usage);
+    if (ret != IM_STATUS_SUCCESS) {
+        imcancelJob(job);
+        return ret;
+    }
+
+    ret = rga_async_submit(job, acquire_fence_fd, release_fence_fd, NULL, NULL);
+    if (ret != IM_STATUS_SUCCESS)
+        imcancelJob(job);
+
+    return ret;
+}
+
+IM_API IM_STATUS imendJobAsync(im_job_handle_t job, int acquire_fence_fd, int *release_fence_fd) {
+    IM_STATUS ret;
+
+    if (job == NULL) {
+        imErrorMsg("Job is NULL, please call imbeginJob() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (release_fence_fd == NULL) {
+        imErrorMsg("Release fence is NULL.");
+        imcancelJob(job);
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    *release_fence_fd = -1;
+
+    ret = rga_async_submit(job, acquire_fence_fd, release_fence_fd, NULL, NULL);
+    if (ret != IM_STATUS_SUCCESS)
+        imcancelJob(job);
+
+    return ret;
+}
+
+IM_API IM_STATUS improcess_callback(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                    im_rect srect, im_rect drect, im_rect prect, int usage,
+                                    im_callback_t callback, void *cookie) {
+    im_job_handle_t job;
+    IM_STATUS ret;
+
+    if (callback == NULL) {
+        imErrorMsg("Callback is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    job = imbeginJob();
+    if (job == NULL)
+        return IM_STATUS_OUT_OF_MEMORY;
+
+    ret = imaddTask(job, src, dst, pat, srect, drect, prect, usage);
+    if (ret != IM_STATUS_SUCCESS) {
+        imcancelJob(job);
+        return ret;
+    }
+
+    ret = rga_async_submit(job, -1, NULL, callback, cookie);
+    if (ret != IM_STATUS_SUCCESS)
+        imcancelJob(job);
+
+    return ret;
+}
+
+IM_API IM_STATUS imendJobCallback(im_job_handle_t job, im_callback_t callback, void *cookie) {
+    IM_STATUS ret;
+
+    if (job == NULL) {
+        imErrorMsg("Job is NULL, please call imbeginJob() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (callback == NULL) {
+        imErrorMsg("Callback is NULL.");
+        imcancelJob(job);
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    ret = rga_async_submit(job, -1, NULL, callback, cookie);
+    if (ret != IM_STATUS_SUCCESS)
+        imcancelJob(job);
+
+    return ret;
+}
+
+/*
+ * Mosaic
+ *
+ * The background is filled only where no opaque tile goes: dst minus the opaque
+ * drects, as disjoint rects. When a piece is too thin for the rga, or there are
+ * too many of them, the whole dst is filled instead. A tile of the same source
+ * geometry, srect, drect size, rotation and alpha as an earlier one reuses its
+ * prepared task, only the src address and the dst position are replaced.
+ */
+#define RGA_MOSAIC_MAX_FILLS    32
+
+static void rga_rect_subtract(vector<im_rect> &rects, const im_rect &cut) {
+    vector<im_rect> out;
+
+    for (size_t i = 0; i < rects.size(); i++) {
+        const im_rect &r = rects[i];
+        int top, bottom;
+
+        if (!rga_rect_overlap(r, cut)) {
+            out.push_back(r);
+            continue;
+        }
+
+        top = cut.y > r.y ? cut.y : r.y;
+        bottom = cut.y + cut.height < r.y + r.height ? cut.y + cut.height : r.y + r.height;
+
+        if (top > r.y) {
+            im_rect above = { r.x, r.y, r.width, top - r.y };
+            out.push_back(above);
+        }
+        if (bottom < r.y + r.height) {
+            im_rect below = { r.x, bottom, r.width, r.y + r.height - bottom };
+            out.push_back(below);
+        }
+        if (cut.x > r.x) {
+            im_rect left = { r.x, top, cut.x - r.x, bottom - top };
+            out.push_back(left);
+        }
+        if (cut.x + cut.width < r.x + r.width) {
+            im_rect right = { cut.x + cut.width, top, r.x + r.width - cut.x - cut.width, bottom - top };
+            out.push_back(right);
+        }
+    }
+
+    rects.swap(out);
+}
+
+static bool rga_mosaic_same(const im_mosaic_tile_t &a, const im_rect &asrect,
+                            const im_mosaic_tile_t &b, const im_rect &bsrect) {
+    return rga_desc_match(a.src, b.src) &&
+           asrect.x == bsrect.x && asrect.y == bsrect.y &&
+           asrect.width == bsrect.width && asrect.height == bsrect.height &&
+           a.drect.width == b.drect.width && a.drect.height == b.drect.height &&
+           a.rotation == b.rotation && a.global_alpha == b.global_alpha;
+}
+
+static IM_STATUS rga_mosaic_drect_check(const rga_buffer_t &dst, const im_rect &rect, bool yuv) {
+    if (rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+        rect.x + rect.width > dst.width || rect.y + rect.height > dst.height) {
+        imErrorMsg("Invalid mosaic drect, it must be inside dst.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (yuv && ((rect.x % 2) || (rect.y % 2))) {
+        imErrorMsg("Err yuv not align to 2.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS imaddMosaic(im_job_handle_t job, rga_buffer_t dst, const im_mosaic_tile_t *tiles, int num,
+                             int bg_color) {
+    im_job fills;
+    vector<im_task_t> tasks;
+    vector<im_rect> srects, bg;
+    vector<int> template_of;
+    rga_buffer_t pat;
+    im_rect prect, full = { 0, 0, dst.width, dst.height };
+    bool yuv;
+    IM_STATUS ret;
+
+    if (job == NULL) {
+        imErrorMsg("Job is NULL, please call imbeginJob() first.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    if (tiles == NULL || num <= 0) {
+        imErrorMsg("Mosaic tiles is NULL, or the number of tiles is invalid.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    empty_structure(NULL, NULL, &pat, NULL, NULL, &prect);
+    yuv = NormalRgaIsYuvFormat(RkRgaGetRgaFormat(dst.format));
+
+    srects.resize(num);
+    template_of.assign(num, -1);
+    tasks.resize(num);
+
+    for (int i = 0; i < num; i++) {
+        const im_mosaic_tile_t &tile = tiles[i];
+        rga_buffer_t src = tile.src;
+        bool blend = tile.global_alpha > 0 && tile.global_alpha < 255;
+        int usage = tile.rotation;
+
+        if (tile.rotation & ~IM_HAL_TRANSFORM_MASK) {
+            imErrorMsg("Invalid mosaic tile rotation.");
+            return IM_STATUS_INVALID_PARAM;
+        }
+
+        srects[i] = tile.srect;
+        if (srects[i].width <= 0 || srects[i].height <= 0) {
+            srects[i].x = 0;
+            srects[i].y = 0;
+            srects[i].width = src.width;
+            srects[i].height = src.height;
+        }
+
+        ret = rga_mosaic_drect_check(dst, tile.drect, yuv);
+        if (ret != IM_STATUS_SUCCESS)
+            return ret;
+
+        for (int j = 0; j < i; j++) {
+            if (template_of[j] < 0 && rga_mosaic_same(tiles[j], srects[j], tile, srects[i])) {
+                template_of[i] = j;
+                break;
+            }
+        }
+
+        if (template_of[i] >= 0) {
+            int j = template_of[i];
+
+            tasks[i] = tasks[j];
+            ret = rga_desc_patch(tiles[j].src, src, &tasks[i].srcinfo, "src");
+            if (ret <= 0)
+                return ret;
+            rga_set_rect(&tasks[i].dstinfo.rect, tile.drect.x, tile.drect.y, tile.drect.width, tile.drect.height,
+                         dst.wstride, dst.hstride, dst.format);
+            continue;
+        }
+
+        if (blend) {
+            usage |= IM_ALPHA_BLEND_SRC_OVER;
+            src.global_alpha = tile.global_alpha;
+        }
+
+        ret = rga_task_prepare(src, dst, pat, srects[i], tile.drect, prect, usage, &tasks[i]);
+        if (ret <= 0)
+            return ret;
+    }
+
+    /* the background under the blended tiles and between the tiles */
+    bg.push_back(full);
+    for (int i = 0; i < num; i++)
+        if (tiles[i].global_alpha <= 0 || tiles[i].global_alpha >= 255)
+            rga_rect_subtract(bg, tiles[i].drect);
+
+    if (bg.size() > RGA_MOSAIC_MAX_FILLS)
+        bg.assign(1, full);
+    for (size_t i = 0; i < bg.size(); i++) {
+        if (rga_fill_rect_check(dst, bg[i], yuv) != IM_STATUS_SUCCESS) {
+            bg.assign(1, full);
+            break;
+        }
+    }
+
+    if (!bg.empty()) {
+        vector<int> colors(bg.size(), bg_color);
+
+        ret = rga_job_add_fills(&fills, dst, &bg[0], &colors[0], (int)bg.size(), IM_COLOR_FILL);
+        if (ret != IM_STATUS_SUCCESS)
+            return ret;
+    }
+
+    job->tasks.insert(job->tasks.end(), fills.tasks.begin(), fills.tasks.end());
+    job->tasks.insert(job->tasks.end(), tasks.begin(), tasks.end());
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API IM_STATUS immosaic(rga_buffer_t dst, const im_mosaic_tile_t *tiles, int num, int bg_color,
+                          int acquire_fence_fd, int *release_fence_fd) {
+    im_job_handle_t job;
+    IM_STATUS ret;
+
+    if (release_fence_fd != NULL)
+        *release_fence_fd = -1;
+
+    job = imbeginJob();
+    if (job == NULL)
+        return IM_STATUS_OUT_OF_MEMORY;
+
+    ret = imaddMosaic(job, dst, tiles, num, bg_color);
+    if (ret != IM_STATUS_SUCCESS) {
+        imcancelJob(job);
+        return ret;
+    }
+
+    /* No release fence requested, synchronous once the acquire fence signaled. */
+    if (release_fence_fd == NULL) {
+        if (acquire_fence_fd >= 0) {
+            ret = rga_wait_fence(acquire_fence_fd, RGA_ACQUIRE_FENCE_TIMEOUT);
+            if (ret != IM_STATUS_SUCCESS) {
+                imcancelJob(job);
+                return ret;
+            }
+        }
+
+        return imendJob(job, 1, NULL, 0);
+    }
+
+    ret = rga_async_submit(job, acquire_fence_fd, release_fence_fd, NULL, NULL);
+    if (ret != IM_STATUS_SUCCESS)
+        imcancelJob(job);
+
+    return ret;
+}
+
+IM_API IM_STATUS imwait(int fence_fd, int timeout) {
+    uint64_t value;
+    IM_STATUS ret;
+
+    if (fence_fd < 0)
+        return IM_STATUS_SUCCESS;
+
+    if (!rga_is_release_fence(fence_fd))
+        return rga_wait_fence(fence_fd, timeout);
+
+    /*
+     * Read the status of the job and write it back, the fence stays signaled
+     * for the other waiters. A concurrent imwait() holds the value in between.
+     */
+    while (1) {
+        ret = rga_wait_fence(fence_fd, timeout);
+        if (ret != IM_STATUS_SUCCESS)
+            return ret;
+
+        if (read(fence_fd, &value, sizeof(value)) == sizeof(value))
+            break;
+        if (errno != EAGAIN && errno != EINTR)
+            return IM_STATUS_SUCCESS;
+    }
+
+    if (write(fence_fd, &value, sizeof(value)) != sizeof(value))
+        ALOGE("rga_im2d: signal release fence again fail: %s", strerror(errno));
+
+    if (value == 1)
+        return IM_STATUS_SUCCESS;
+
+    imErrorMsg("The job of the fence failed.");
+    return (IM_STATUS)(2 - (int64_t)value);
+}
+
+IM_API IM_STATUS imsync(void) {
+    int ret = 0;
+
+    /* the fenced jobs of the context first, then what it submitted with RGA_BLIT_ASYNC */
+    rga_async_drain(rga_thread_ctx, false);
+
+    ret = rkRga.RkRgaFlush();
+    if (ret)
+        return IM_STATUS_FAILED;
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API im_ctx_t imcreateContext(void) {
+    im_ctx_t ctx;
+    int ret;
+
+    if (rkRga.RkRgaInit() || !rkRga.RkRgaIsReady()) {
+        imErrorMsg("RGA device is not available.");
+        return NULL;
+    }
+
+    ctx = new(std::nothrow) im_context;
+    if (ctx == NULL) {
+        imErrorMsg("Failed to alloc context.");
+        return NULL;
+    }
+
+    ret = rkRga.RkRgaCreateContext(&ctx->rga);
+    if (ret) {
+        delete ctx;
+        imErrorMsg("Failed to create context.");
+        return NULL;
+    }
+
+    return ctx;
+}
+
+IM_API IM_STATUS imdestroyContext(im_ctx_t ctx) {
+    if (ctx == NULL) {
+        imErrorMsg("Context is NULL.");
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    /* the fenced jobs submitted with ctx may still be queued */
+    rga_async_drain(ctx, true);
+
+    if (rga_thread_ctx == ctx)
+        imbindContext(NULL);
+
+    rkRga.RkRgaDestroyContext(ctx->rga);
+    delete ctx;
+
+    return IM_STATUS_SUCCESS;
+}
+
+IM_API im_ctx_t imbindContext(im_ctx_t ctx) {
+    im_ctx_t prev = rga_thread_ctx;
+
+    rga_thread_ctx = ctx;
+    rkRga.RkRgaBindContext(ctx ? ctx->rga : NULL);
+
+    return prev;
+}
+
+/* f on ctx, the context bound to the calling thread is kept */
+template <typename F, typename... Args>
+static IM_STATUS rga_ctx_call(im_ctx_t ctx, F f, Args... args) {
+    im_ctx_t prev = imbindContext(ctx);
+    IM_STATUS ret;
+
+    ret = f(args...);
+    imbindContext(prev);
+
+    return ret;
+}
+
+IM_API IM_STATUS imresize_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, double fx, double fy, int interpolation, int sync) {
+    return rga_ctx_call(ctx, imresize_t, src, dst, fx, fy, interpolation, sync);
+}
+
+IM_API IM_STATUS imcrop_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, im_rect rect, int sync) {
+    return rga_ctx_call(ctx, imcrop_t, src, dst, rect, sync);
+}
+
+IM_API IM_STATUS imrotate_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int rotation, int sync) {
+    return rga_ctx_call(ctx, imrotate_t, src, dst, rotation, sync);
+}
+
+IM_API IM_STATUS imflip_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int mode, int sync) {
+    return rga_ctx_call(ctx, imflip_t, src, dst, mode, sync);
+}
+
+IM_API IM_STATUS imfill_ctx(im_ctx_t ctx, rga_buffer_t dst, im_rect rect, int color, int sync) {
+    return rga_ctx_call(ctx, imfill_t, dst, rect, color, sync);
+}
+
+IM_API IM_STATUS imfillArray_ctx(im_ctx_t ctx, rga_buffer_t dst, const im_rect *rects, int num, int color, int sync) {
+    return rga_ctx_call(ctx, imfillArray_t, dst, rects, num, color, sync);
+}
+
+IM_API IM_STATUS imfillArrayColors_ctx(im_ctx_t ctx, rga_buffer_t dst, const im_rect *rects, const int *colors, int num, int sync) {
+    return rga_ctx_call(ctx, imfillArrayColors_t, dst, rects, colors, num, sync);
+}
+
+IM_API IM_STATUS impalette_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t lut, int sync) {
+    return rga_ctx_call(ctx, impalette_t, src, dst, lut, sync);
+}
+
+IM_API IM_STATUS imtranslate_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int x, int y, int sync) {
+    return rga_ctx_call(ctx, imtranslate_t, src, dst, x, y, sync);
+}
+
+IM_API IM_STATUS imcopy_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int sync) {
+    return rga_ctx_call(ctx, imcopy_t, src, dst, sync);
+}
+
+IM_API IM_STATUS imblend_ctx(im_ctx_t ctx, const rga_buffer_t srcA, const rga_buffer_t srcB, rga_buffer_t dst, int mode, int sync) {
+    return rga_ctx_call(ctx, imblend_t, srcA, srcB, dst, mode, sync);
+}
+
+IM_API IM_STATUS imcvtcolor_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, int sfmt, int dfmt, int mode, int sync) {
+    return rga_ctx_call(ctx, imcvtcolor_t, src, dst, sfmt, dfmt, mode, sync);
+}
+
+IM_API IM_STATUS imquantize_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, im_nn_t nn_info, int sync) {
+    return rga_ctx_call(ctx, imquantize_t, src, dst, nn_info, sync);
+}
+
+IM_API IM_STATUS imnnpreprocess_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, im_rect srect,
+                                    const im_nn_preprocess_t *param, im_rect *content) {
+    return rga_ctx_call(ctx, imnnpreprocess, src, dst, srect, param, content);
+}
+
+IM_API IM_STATUS imrop_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int rop_code, int sync) {
+    return rga_ctx_call(ctx, imrop_t, src, dst, rop_code, sync);
+}
+
+IM_API IM_STATUS improcess_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                               im_rect srect, im_rect drect, im_rect prect, int usage) {
+    return rga_ctx_call(ctx, improcess, src, dst, pat, srect, drect, prect, usage);
+}
+
+IM_API IM_STATUS imexecute_ctx(im_ctx_t ctx, im_desc_handle_t desc, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat) {
+    return rga_ctx_call(ctx, imexecute_t, desc, src, dst, pat);
+}
+
+IM_API IM_STATUS imendJob_ctx(im_ctx_t ctx, im_job_handle_t job, int sync, IM_STATUS *task_status, int num) {
+    return rga_ctx_call(ctx, imendJob, job, sync, task_status, num);
+}
+
+IM_API IM_STATUS improcess_fence_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                     im_rect srect, im_rect drect, im_rect prect,
+                                     int acquire_fence_fd, int *release_fence_fd, int usage) {
+    return rga_ctx_call(ctx, improcess_fence, src, dst, pat, srect, drect, prect, acquire_fence_fd, release_fence_fd, usage);
+}
+
+IM_API IM_STATUS imendJobAsync_ctx(im_ctx_t ctx, im_job_handle_t job, int acquire_fence_fd, int *release_fence_fd) {
+    return rga_ctx_call(ctx, imendJobAsync, job, acquire_fence_fd, release_fence_fd);
+}
+
+IM_API IM_STATUS improcess_callback_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                        im_rect srect, im_rect drect, im_rect prect, int usage,
+                                        im_callback_t callback, void *cookie) {
+    return rga_ctx_call(ctx, improcess_callback, src, dst, pat, srect, drect, prect, usage, callback, cookie);
+}
+
+IM_API IM_STATUS imendJobCallback_ctx(im_ctx_t ctx, im_job_handle_t job, im_callback_t callback, void *cookie) {
+    return rga_ctx_call(ctx, imendJobCallback, job, callback, cookie);
+}
+
+IM_API IM_STATUS immosaic_ctx(im_ctx_t ctx, rga_buffer_t dst, const im_mosaic_tile_t *tiles, int num, int bg_color,
+                              int acquire_fence_fd, int *release_fence_fd) {
+    return rga_ctx_call(ctx, immosaic, dst, tiles, num, bg_color, acquire_fence_fd, release_fence_fd);
+}
+
+IM_API IM_STATUS imsync_ctx(im_ctx_t ctx) {
+    return rga_ctx_call(ctx, imsync);
 }
 
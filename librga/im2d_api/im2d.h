@@ -115,6 +115,7 @@ typedef enum {
     IM_RGA_INFO_PERFORMANCE_520         = 1 << 27,
     IM_RGA_INFO_PERFORMANCE_600         = 1 << 28,
     IM_RGA_INFO_PERFORMANCE_MASK        = 0x1C000000,
+    IM_RGA_INFO_FEATURE_PORTER_DUFF     = 1 << 29,  /* all IM_ALPHA_BLEND_* modes */
 } IM_RGA_INFO_USAGE;
 
 /* Status codes, returned by any blit function */
@@ -177,6 +178,7 @@ typedef enum {
     RGA_2_LITE0                = 0x4,
     RGA_2_LITE1                = 0x5,
     RGA_2_ENHANCE              = 0x6,
+    RGA_SOFT                   = 0x7,     /* cpu backend, no rga device */
 } RGA_VERSION_NUM;
 
 //struct AHardwareBuffer AHardwareBuffer;
@@ -198,6 +200,31 @@ typedef struct im_nn {
     int offset_b;               /* offset on B channal */
 } im_nn_t;
 
+/* NN preprocess, see imnnpreprocess() */
+typedef enum {
+    IM_NN_RESIZE_STRETCH        = 0,    /* fill the whole tensor */
+    IM_NN_RESIZE_LETTERBOX,             /* keep the aspect ratio, center and pad */
+} IM_NN_RESIZE_MODE;
+
+typedef enum {
+    IM_NN_LAYOUT_NHWC           = 0,    /* interleaved, the layout of dst.format */
+    IM_NN_LAYOUT_NCHW,                  /* one plane of wstride x hstride per channel */
+} IM_NN_LAYOUT;
+
+typedef enum {
+    IM_NN_QUANT_NONE            = 0,
+    IM_NN_QUANT_AUTO,                   /* by the rga (RV1126/RV1109), else by the cpu */
+    IM_NN_QUANT_CPU,                    /* by the cpu, for the rga without NN quantize */
+} IM_NN_QUANT_MODE;
+
+typedef struct im_nn_preprocess {
+    int resize;                 /* IM_NN_RESIZE_MODE */
+    int layout;                 /* IM_NN_LAYOUT */
+    int quantize;               /* IM_NN_QUANT_MODE */
+    int pad_color;              /* letterbox border, 0xAABBGGRR like imfill, before the quantize */
+    im_nn_t nn;                 /* scale/offset of the quantize, like imquantize */
+} im_nn_preprocess_t;
+
 /* im_info definition */
 typedef struct {
     void* vir_addr;                     /* virtual address */
@@ -216,6 +243,42 @@ typedef struct {
 	int rop_code;
 } rga_buffer_t;
 
+/* RGA capability, probed once per process and cached */
+typedef struct {
+    int version;                        /* RGA_VERSION_NUM */
+    char version_str[16];               /* version string reported by the driver */
+    int max_input_width;                /* max input resolution */
+    int max_input_height;
+    int max_output_width;               /* max output resolution */
+    int max_output_height;
+    int scale_limit;                    /* max up/down scaling factor of a single pass */
+    long input_format;                  /* IM_RGA_INFO_SUPPORT_FORMAT_INPUT_* */
+    long output_format;                 /* IM_RGA_INFO_SUPPORT_FORMAT_OUTPUT_* */
+    int performance;                    /* expected performance, M pix/s */
+    long usage;                         /* IM_RGA_INFO_USAGE, same as rga_get_info() */
+} im_capability_t;
+
+#define IM_MAX_PASSES 8
+
+/* A pass of the rga, see imqueryplan() */
+typedef struct {
+    int src_width;
+    int src_height;
+    int src_format;
+    int dst_width;
+    int dst_height;
+    int dst_format;
+    int usage;                          /* IM_HAL_TRANSFORM_* done by the pass */
+    int color_space_mode;               /* conversion done by the pass */
+} im_pass_t;
+
+/* How improcess() carries out an operation */
+typedef struct {
+    int num_passes;
+    im_pass_t passes[IM_MAX_PASSES];
+    long cost;                          /* pixels read and written by all passes */
+} im_plan_t;
+
 /*
  * @return error message string
  */
@@ -288,6 +351,27 @@ IM_API rga_buffer_t wrapbuffer_virtualaddr_t(void* vir_addr, int width, int heig
 IM_API rga_buffer_t wrapbuffer_physicaladdr_t(void* phy_addr, int width, int height, int wstride, int hstride, int format);
 IM_API rga_buffer_t wrapbuffer_fd_t(int fd, int width, int height, int wstride, int hstride, int format);
 
+/*
+ * wrapbuffer_handle()/wrapbuffer_GraphicBuffer()/wrapbuffer_AHardwareBuffer() keep
+ * what they resolved through gralloc for the last buffers they saw, a buffer that is
+ * wrapped again is resolved without querying gralloc. The entry of a freed buffer is
+ * dropped by imreleasebuffercache(), or else once the handle address is reused.
+ * Android only, the counters stay 0 elsewhere.
+ */
+typedef struct {
+    unsigned long long hits;
+    unsigned long long misses;
+    int entries;                        /* buffers cached */
+    int capacity;                       /* most buffers cached */
+} im_buffer_cache_info_t;
+
+/*
+ * query the gralloc handle cache, hit rate is hits / (hits + misses)
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imquerybuffercache(im_buffer_cache_info_t *info);
+
 /*
  * Get RGA basic information, supported resolution, supported format, etc.
  *
@@ -305,6 +389,26 @@ IM_API rga_buffer_t wrapbuffer_fd_t(int fd, int width, int height, int wstride,
  */
 IM_API long rga_get_info();
 
+/*
+ * Query the cached RGA capability.
+ * The hardware is probed on first use only, through the RockchipRga device,
+ * and the result (or the failure) is kept for the whole process.
+ *
+ * @param cap
+ *      capability to be filled in.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imquerycapability(im_capability_t *cap);
+
+/*
+ * Drop the cached RGA capability and probe the hardware again.
+ * Mainly intended for tests.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imrefreshcapability(void);
+
 /*
  * Query RGA basic information, supported resolution, supported format, etc.
  *
@@ -565,6 +669,59 @@ IM_API IM_STATUS imflip_t (const rga_buffer_t src, rga_buffer_t dst, int mode, i
     })
 IM_API IM_STATUS imfill_t(rga_buffer_t dst, im_rect rect, int color, int sync);
 
+/*
+ * fill several rects of a buffer in one call
+ *
+ * The rects are checked and prepared once and submitted together; the ones too
+ * small to be worth a rga request are filled by the cpu in auto mode. Rects
+ * are filled in order, where they overlap the later one wins.
+ *
+ * @param dst
+ * @param rects
+ * @param colors
+ *      one color per rect, for imfillArrayColors
+ * @param num
+ *      number of rects
+ * @param color
+ * @param sync
+ *      wait until operation complete
+ *
+ * @returns success or else negative error code.
+ */
+#define imfillArray(buf, rects, num, color, ...) \
+    ({ \
+        IM_STATUS ret = IM_STATUS_SUCCESS; \
+        int args[] = {__VA_ARGS__}; \
+        int argc = sizeof(args)/sizeof(int); \
+        if (argc == 0) { \
+            ret = imfillArray_t(buf, rects, num, color, 1); \
+        } else if (argc == 1){ \
+            ret = imfillArray_t(buf, rects, num, color, args[0]); \
+        } else { \
+            ret = IM_STATUS_INVALID_PARAM; \
+            printf("invalid parameter\n"); \
+        } \
+        ret; \
+    })
+
+#define imfillArrayColors(buf, rects, colors, num, ...) \
+    ({ \
+        IM_STATUS ret = IM_STATUS_SUCCESS; \
+        int args[] = {__VA_ARGS__}; \
+        int argc = sizeof(args)/sizeof(int); \
+        if (argc == 0) { \
+            ret = imfillArrayColors_t(buf, rects, colors, num, 1); \
+        } else if (argc == 1){ \
+            ret = imfillArrayColors_t(buf, rects, colors, num, args[0]); \
+        } else { \
+            ret = IM_STATUS_INVALID_PARAM; \
+            printf("invalid parameter\n"); \
+        } \
+        ret; \
+    })
+IM_API IM_STATUS imfillArray_t(rga_buffer_t dst, const im_rect *rects, int num, int color, int sync);
+IM_API IM_STATUS imfillArrayColors_t(rga_buffer_t dst, const im_rect *rects, const int *colors, int num, int sync);
+
 /*
  * palette
  *
@@ -765,6 +922,29 @@ IM_API IM_STATUS imcvtcolor_t(rga_buffer_t src, rga_buffer_t dst, int sfmt, int
 
 IM_API IM_STATUS imquantize_t(const rga_buffer_t src, rga_buffer_t dst, im_nn_t nn_info, int sync);
 
+/*
+ * nn preprocess
+ *
+ * Resize (stretch or letterbox), color convert and quantize src into the
+ * input tensor of a network, in one rga pass. The letterbox borders are
+ * filled in the same job, a NCHW layout and a quantize the rga cannot do
+ * are done by the cpu afterwards.
+ *
+ * @param src
+ * @param dst
+ *      the tensor, RGB_888 or BGR_888 of the network input size.
+ *      NCHW: channel c is the plane at c * wstride * hstride bytes.
+ * @param srect
+ *      the region of src, the whole image if width/height is 0.
+ * @param param
+ * @param content
+ *      optional, the rect of dst the image is placed in.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imnnpreprocess(const rga_buffer_t src, rga_buffer_t dst, im_rect srect,
+                                const im_nn_preprocess_t *param, im_rect *content);
+
 /*
  * ROP
  *
@@ -802,17 +982,391 @@ IM_API IM_STATUS imrop_t(const rga_buffer_t src, rga_buffer_t dst, int rop_code,
  * @param ...
  *      wait until operation complete
  *
+ * A copy, resize, cvtcolor, rotate or flip larger than the resolution limits of
+ * imquerycapability() is split into tiles and submitted as one batch. A scaled one
+ * goes through temporary buffers and always completes before returning.
+ *
  * @returns success or else negative error code.
  */
 IM_API IM_STATUS improcess(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat, im_rect srect, im_rect drect, im_rect prect, int usage);
 
 /*
- * block until all execution is complete
+ * query the passes improcess() takes for an operation
+ *
+ * What the rga cannot do in one pass, a scaling beyond the scale limit or a rotation
+ * by 90/270 together with a scaling, is done by improcess() as a chain of passes
+ * through intermediate buffers, always synchronously.
+ *
+ * @param src
+ * @param dst
+ * @param pat
+ * @param srect
+ * @param drect
+ * @param prect
+ * @param usage
+ *      same as improcess().
+ * @param plan
+ *      the passes, num_passes is 1 when the rga does it in one pass.
+ *
+ * @returns success or else negative error code if the rga cannot do it.
+ */
+IM_API IM_STATUS imqueryplan(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                             im_rect srect, im_rect drect, im_rect prect, int usage, im_plan_t *plan);
+
+/*
+ * Batch job
+ * Collect several operations, check them once when they are added, and submit
+ * them back-to-back with a single completion point.
+ *
+ *  im_job_handle_t job = imbeginJob();
+ *  imaddTask(job, src, dst, pat, srect, drect, prect, usage);
+ *  ...
+ *  imendJob(job, 1, NULL, 0);
+ */
+typedef struct im_job* im_job_handle_t;
+
+/*
+ * begin a batch job
+ *
+ * @returns a job handle, or NULL on failure.
+ */
+IM_API im_job_handle_t imbeginJob(void);
+
+/*
+ * check an operation and add it to the job
+ *
+ * @param job
+ * @param src
+ * @param dst
+ * @param pat
+ * @param srect
+ * @param drect
+ * @param prect
+ * @param usage
+ *      same as improcess(), IM_SYNC is ignored.
+ *
+ * @returns success or else negative error code of the check.
+ *      A task that failed the check is kept in the job and reported by imendJob(),
+ *      but never submitted.
+ */
+IM_API IM_STATUS imaddTask(im_job_handle_t job, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                           im_rect srect, im_rect drect, im_rect prect, int usage);
+
+/*
+ * submit all tasks of the job, then release the job
+ *
+ * @param job
+ * @param sync
+ *      wait until all tasks complete, otherwise use imsync().
+ * @param task_status
+ *      optional, status of each task in add order.
+ * @param num
+ *      number of entries of task_status.
+ *
+ * @returns success or else the first negative error code of the tasks.
+ */
+IM_API IM_STATUS imendJob(im_job_handle_t job, int sync, IM_STATUS *task_status, int num);
+
+/*
+ * release the job without submitting it
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imcancelJob(im_job_handle_t job);
+
+/*
+ * Compiled operation
+ * Check an operation once and run it again and again on new buffers of the same
+ * size, stride and format, without the checks and the request building of
+ * improcess() on every call.
+ *
+ *  im_desc_handle_t desc;
+ *  imcompile(src, dst, pat, srect, drect, prect, usage, &desc);
+ *  for (;;)
+ *      imexecute(desc, src_fd, dst_fd);
+ *  imdestroyDesc(desc);
+ */
+typedef struct im_desc* im_desc_handle_t;
+
+/*
+ * check an operation and prepare its request
+ *
+ * @param src
+ * @param dst
+ * @param pat
+ * @param srect
+ * @param drect
+ * @param prect
+ * @param usage
+ *      same as improcess(). An operation improcess() splits into tiles or passes
+ *      cannot be compiled.
+ * @param desc
+ *      the compiled operation, to be released with imdestroyDesc().
+ *
+ * @returns success or else negative error code of the check.
+ */
+IM_API IM_STATUS imcompile(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                           im_rect srect, im_rect drect, im_rect prect, int usage, im_desc_handle_t *desc);
+
+/*
+ * run a compiled operation on new buffers
+ *
+ * @param desc
+ * @param src
+ * @param dst
+ * @param pat
+ *      same size, stride and format as the ones given to imcompile(). pat is
+ *      optional, the compiled one is used if it is empty.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imexecute_t(im_desc_handle_t desc, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat);
+
+/*
+ * run a compiled operation on new dma-buf fds, the pat is the compiled one
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imexecute(im_desc_handle_t desc, int src_fd, int dst_fd);
+
+/*
+ * release a compiled operation
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imdestroyDesc(im_desc_handle_t desc);
+
+/*
+ * process with fences
+ * The job waits for acquire_fence_fd and signals the returned release fence
+ * when it is complete, without any global barrier like imsync().
+ *
+ * @param src
+ * @param dst
+ * @param pat
+ * @param srect
+ * @param drect
+ * @param prect
+ * @param acquire_fence_fd
+ *      optional, -1 if none. librga duplicates it, the caller keeps the ownership.
+ * @param release_fence_fd
+ *      release fence of this job, to be closed by the caller.
+ *      If NULL, the operation is synchronous once the acquire fence signaled.
+ * @param usage
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS improcess_fence(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                 im_rect srect, im_rect drect, im_rect prect,
+                                 int acquire_fence_fd, int *release_fence_fd, int usage);
+
+/*
+ * submit all tasks of the job with fences, then release the job
+ *
+ * @param job
+ * @param acquire_fence_fd
+ *      optional, -1 if none. librga duplicates it, the caller keeps the ownership.
+ * @param release_fence_fd
+ *      release fence of the whole job, to be closed by the caller.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imendJobAsync(im_job_handle_t job, int acquire_fence_fd, int *release_fence_fd);
+
+/*
+ * completion callback of improcess_callback()/imendJobCallback()
+ *
+ * @param status
+ *      status of the job once it is complete.
+ * @param cookie
+ *      the cookie given with the job.
+ */
+typedef void (*im_callback_t)(IM_STATUS status, void *cookie);
+
+/*
+ * process and call back on completion
+ * The call returns once the job is queued. The jobs with a callback or a fence
+ * are run in order by one completion thread of the calling thread's context,
+ * which calls the callback when the job is complete. A callback runs on that
+ * thread: it must be short and must not wait for other queued jobs, with
+ * imsync() or imwait().
+ *
+ * @param src
+ * @param dst
+ * @param pat
+ * @param srect
+ * @param drect
+ * @param prect
+ * @param usage
+ * @param callback
+ * @param cookie
+ *      passed to the callback.
+ *
+ * @returns success or else negative error code, the callback is not called then.
+ */
+IM_API IM_STATUS improcess_callback(rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                    im_rect srect, im_rect drect, im_rect prect, int usage,
+                                    im_callback_t callback, void *cookie);
+
+/*
+ * submit all tasks of the job and call back when the whole job is complete,
+ * then release the job
+ *
+ * @param job
+ * @param callback
+ * @param cookie
+ *
+ * @returns success or else negative error code, the callback is not called then.
+ */
+IM_API IM_STATUS imendJobCallback(im_job_handle_t job, im_callback_t callback, void *cookie);
+
+/* a source of immosaic()/imaddMosaic() */
+typedef struct im_mosaic_tile {
+    rga_buffer_t src;
+    im_rect srect;              /* the whole src if width/height is 0 */
+    im_rect drect;              /* where it goes in dst, scaled to fit */
+    int rotation;               /* 0 or IM_HAL_TRANSFORM_ROT_90/180/270, FLIP_H/V */
+    int global_alpha;           /* 0 or 255 opaque, else blended over what is below */
+} im_mosaic_tile_t;
+
+/*
+ * add a mosaic (video wall) to a job
+ * The part of dst no opaque tile covers is filled with bg_color, then the tiles
+ * are drawn in order, a later one over an earlier one. The tiles of the same
+ * source geometry, rects size, rotation and alpha are checked once. Nothing is
+ * added if a tile is invalid. The job is then ended by imendJob(),
+ * imendJobAsync() or imendJobCallback().
+ *
+ * @param job
+ * @param dst
+ * @param tiles
+ * @param num
+ * @param bg_color
+ *      0xAABBGGRR like imfill.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imaddMosaic(im_job_handle_t job, rga_buffer_t dst, const im_mosaic_tile_t *tiles, int num,
+                             int bg_color);
+
+/*
+ * compose tiles into dst as one job, see imaddMosaic()
+ *
+ * @param acquire_fence_fd
+ *      optional, -1 if none. librga duplicates it, the caller keeps the ownership.
+ * @param release_fence_fd
+ *      release fence of the whole mosaic, to be closed by the caller.
+ *      If NULL, the operation is synchronous once the acquire fence signaled.
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS immosaic(rga_buffer_t dst, const im_mosaic_tile_t *tiles, int num, int bg_color,
+                          int acquire_fence_fd, int *release_fence_fd);
+
+/*
+ * wait for a fence
+ * A release fence of librga is signaled by a job that failed or was dropped, its
+ * acquire fence not signaled in time, as well. poll()/sync_wait() only tell that
+ * the job is over, imwait() returns its status.
+ *
+ * @param fence_fd
+ * @param timeout
+ *      ms, -1 means forever.
+ *
+ * @returns success, or else the error of the job or of the wait.
+ */
+IM_API IM_STATUS imwait(int fence_fd, int timeout);
+
+/*
+ * block until all execution of the calling thread's context is complete
  *
  * @returns success or else negative error code.
  */
 IM_API IM_STATUS imsync(void);
 
+/*
+ * Context
+ * A context has a device session and intermediate buffers of its own, so that
+ * the operations of independent threads or pipelines do not contend with each
+ * other. A thread uses the shared context of the process until it binds one.
+ * Error messages (imStrError()) are kept per thread.
+ *
+ *  im_ctx_t ctx = imcreateContext();
+ *  improcess_ctx(ctx, src, dst, pat, srect, drect, prect, usage);
+ *  imcopy_ctx(ctx, src, dst, 1);
+ *  ...
+ *  imdestroyContext(ctx);
+ */
+typedef struct im_context* im_ctx_t;
+
+/*
+ * create a context
+ *
+ * @returns a context, or NULL on failure.
+ */
+IM_API im_ctx_t imcreateContext(void);
+
+/*
+ * destroy a context, once the fenced jobs submitted with it are complete
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imdestroyContext(im_ctx_t ctx);
+
+/*
+ * make the calling thread run its operations on a context
+ *
+ * @param ctx
+ *      NULL goes back to the shared context.
+ *
+ * @returns the context bound before, NULL for the shared one.
+ */
+IM_API im_ctx_t imbindContext(im_ctx_t ctx);
+
+/*
+ * the operations on a context
+ * Each one is the call of the same name without _ctx, the _t form for the calls
+ * with default arguments, run on ctx instead of the context bound to the calling
+ * thread, which is kept. ctx is NULL for the shared context. The fenced and
+ * callback jobs go to the completion thread of ctx, imsync_ctx() waits for them.
+ * imexecute_ctx() takes the buffers of imexecute_t().
+ *
+ * imbeginJob(), imaddTask(), imaddMosaic(), imcancelJob(), imcompile(),
+ * imqueryplan() and imcheck() only build or check the work and run nothing, they
+ * need no context.
+ */
+IM_API IM_STATUS imresize_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, double fx, double fy, int interpolation, int sync);
+IM_API IM_STATUS imcrop_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, im_rect rect, int sync);
+IM_API IM_STATUS imrotate_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int rotation, int sync);
+IM_API IM_STATUS imflip_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int mode, int sync);
+IM_API IM_STATUS imfill_ctx(im_ctx_t ctx, rga_buffer_t dst, im_rect rect, int color, int sync);
+IM_API IM_STATUS imfillArray_ctx(im_ctx_t ctx, rga_buffer_t dst, const im_rect *rects, int num, int color, int sync);
+IM_API IM_STATUS imfillArrayColors_ctx(im_ctx_t ctx, rga_buffer_t dst, const im_rect *rects, const int *colors, int num, int sync);
+IM_API IM_STATUS impalette_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t lut, int sync);
+IM_API IM_STATUS imtranslate_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int x, int y, int sync);
+IM_API IM_STATUS imcopy_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int sync);
+IM_API IM_STATUS imblend_ctx(im_ctx_t ctx, const rga_buffer_t srcA, const rga_buffer_t srcB, rga_buffer_t dst, int mode, int sync);
+IM_API IM_STATUS imcvtcolor_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, int sfmt, int dfmt, int mode, int sync);
+IM_API IM_STATUS imquantize_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, im_nn_t nn_info, int sync);
+IM_API IM_STATUS imnnpreprocess_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, im_rect srect,
+                                    const im_nn_preprocess_t *param, im_rect *content);
+IM_API IM_STATUS imrop_ctx(im_ctx_t ctx, const rga_buffer_t src, rga_buffer_t dst, int rop_code, int sync);
+IM_API IM_STATUS improcess_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                               im_rect srect, im_rect drect, im_rect prect, int usage);
+IM_API IM_STATUS imexecute_ctx(im_ctx_t ctx, im_desc_handle_t desc, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat);
+IM_API IM_STATUS imendJob_ctx(im_ctx_t ctx, im_job_handle_t job, int sync, IM_STATUS *task_status, int num);
+IM_API IM_STATUS improcess_fence_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                     im_rect srect, im_rect drect, im_rect prect,
+                                     int acquire_fence_fd, int *release_fence_fd, int usage);
+IM_API IM_STATUS imendJobAsync_ctx(im_ctx_t ctx, im_job_handle_t job, int acquire_fence_fd, int *release_fence_fd);
+IM_API IM_STATUS improcess_callback_ctx(im_ctx_t ctx, rga_buffer_t src, rga_buffer_t dst, rga_buffer_t pat,
+                                        im_rect srect, im_rect drect, im_rect prect, int usage,
+                                        im_callback_t callback, void *cookie);
+IM_API IM_STATUS imendJobCallback_ctx(im_ctx_t ctx, im_job_handle_t job, im_callback_t callback, void *cookie);
+IM_API IM_STATUS immosaic_ctx(im_ctx_t ctx, rga_buffer_t dst, const im_mosaic_tile_t *tiles, int num, int bg_color,
+                              int acquire_fence_fd, int *release_fence_fd);
+IM_API IM_STATUS imsync_ctx(im_ctx_t ctx);
+
 #ifdef __cplusplus
 }
 #endif
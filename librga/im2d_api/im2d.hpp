@@ -22,6 +22,79 @@
 #include "im2d.h"
 #include "RgaUtils.h"
 
+#include <vector>
+
+/*
+ * A chain of crop/resize/cvtcolor/rotate/flip stages, run as one operation.
+ *
+ * The stages are folded into one source rect, output size, format and transform,
+ * so the whole chain is one improcess(): a single RGA pass when the hardware can do
+ * it, otherwise the fewest passes with pooled intermediate buffers (see
+ * imqueryplan()). The folding is kept for the buffer geometry it was made for, so a
+ * pipeline can be run frame after frame with new buffers of the same geometry.
+ *
+ *  ImPipeline pipe;
+ *  pipe.crop(rect).resize(640, 640).cvtcolor(RK_FORMAT_RGB_888).rotate(IM_HAL_TRANSFORM_ROT_90);
+ *  for (;;)
+ *      pipe.run(src, dst);
+ *
+ * Every stage works on the output of the previous one: a crop rect is in the
+ * coordinates of the image as it is at that point of the chain.
+ */
+class ImPipeline {
+  public:
+    ImPipeline();
+
+    ImPipeline& crop(im_rect rect);
+    ImPipeline& resize(int width, int height);
+    /* mode is the color_space_mode of the conversion, see imcvtcolor() */
+    ImPipeline& cvtcolor(int format, int mode = 0);
+    /* IM_HAL_TRANSFORM_ROT_90/180/270 */
+    ImPipeline& rotate(int rotation);
+    /* IM_HAL_TRANSFORM_FLIP_H/V */
+    ImPipeline& flip(int mode);
+    /* remove all stages */
+    void reset();
+
+    /*
+     * Run the chain from src into dst. The result is written at the top-left of dst,
+     * which must be large enough for it.
+     */
+    IM_STATUS run(rga_buffer_t src, rga_buffer_t dst, int sync = 1);
+    /* the passes run() does for this geometry, for diagnostics */
+    IM_STATUS query(rga_buffer_t src, rga_buffer_t dst, im_plan_t *plan);
+
+  private:
+    enum {
+        STAGE_CROP = 0,
+        STAGE_RESIZE,
+        STAGE_CVTCOLOR,
+        STAGE_ROTATE,
+        STAGE_FLIP,
+    };
+
+    struct Stage {
+        int type;
+        im_rect rect;
+        int arg0;
+        int arg1;
+    };
+
+    IM_STATUS fold(const rga_buffer_t &src);
+    ImPipeline& add(int type, im_rect rect, int arg0, int arg1);
+
+    std::vector<Stage> mStages;
+
+    /* the folded operation and the geometry it is valid for */
+    bool mFolded;
+    int mSrcWidth, mSrcHeight, mSrcFormat;
+    im_rect mSrcRect;
+    im_rect mDstRect;
+    int mDstFormat;
+    int mColorSpaceMode;
+    int mUsage;
+};
+
 #ifdef ANDROID
 
 #include <ui/GraphicBuffer.h>
@@ -31,6 +104,13 @@ using namespace android;
 IM_API rga_buffer_t wrapbuffer_handle(buffer_handle_t hnd);
 IM_API rga_buffer_t wrapbuffer_GraphicBuffer(sp<GraphicBuffer> buf);
 
+/*
+ * drop what the wrapbuffer_* helpers cached for a buffer, to call before freeing it
+ *
+ * @returns success or else negative error code.
+ */
+IM_API IM_STATUS imreleasebuffercache(buffer_handle_t hnd);
+
 #if USE_AHARDWAREBUFFER
 #include <android/hardware_buffer.h>
 IM_API rga_buffer_t wrapbuffer_AHardwareBuffer(AHardwareBuffer *buf);
@@ -59,6 +59,13 @@ int  c_RkRgaBlit(rga_info_t *src, rga_info_t *dst, rga_info_t *src1);
 int  c_RkRgaColorFill(rga_info_t *dst);
 int  c_RkRgaFlush();
 
+/* intermediate buffer pool, see RockchipRga::RkRgaPoolTrim() */
+int  c_RkRgaPoolQuery(rga_pool_info_t *info);
+size_t c_RkRgaPoolTrim(int idle_ms);
+
+/* palette table cache, see RockchipRga::RkRgaPaletteCacheQuery() */
+int  c_RkRgaPaletteCacheQuery(rga_palette_cache_info_t *info);
+
 #ifndef ANDROID /* linux */
 int c_RkRgaGetAllocBuffer(bo_t *bo_info, int width, int height, int bpp);
 int c_RkRgaGetAllocBufferCache(bo_t *bo_info, int width, int height, int bpp);
@@ -66,6 +73,11 @@ int c_RkRgaGetMmap(bo_t *bo_info);
 int c_RkRgaUnmap(bo_t *bo_info);
 int c_RkRgaFree(bo_t *bo_info);
 int c_RkRgaGetBufferFd(bo_t *bo_info, int *fd);
+
+/* pool of the buffers above, see RockchipRga::RkRgaAllocPoolTrim() */
+int  c_RkRgaAllocPoolQuery(rga_alloc_pool_info_t *info);
+size_t c_RkRgaAllocPoolTrim(size_t keep);
+void c_RkRgaAllocPoolSetBudget(size_t budget);
 #endif /* #ifndef ANDROID */
 
 #ifdef __cplusplus
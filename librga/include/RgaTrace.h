@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co., Ltd.
+ * Authors:
+ *  Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _rga_trace_h_
+#define _rga_trace_h_
+
+#include <stdint.h>
+
+/*
+ * Trace of the requests submitted to /dev/rga, written by NormalRga when
+ * vendor.rga.trace (Android) or RGA_TRACE (Linux) names a file, or a directory
+ * ending with '/' to get one rga-<pid>.trace per process in it.
+ *
+ * The file is a rga_trace_header_t followed by one rga_trace_record_t per
+ * request, in the byte order of the device. Only the geometry and the mode of
+ * the requests are kept, not the addresses or the pixels, so that a trace can
+ * be replayed on other buffers and on any backend (see samples/rga_replay).
+ */
+#define RGA_TRACE_MAGIC         "RGATRACE"
+#define RGA_TRACE_VERSION       1
+
+/* rga_trace_record_t.op */
+#define RGA_TRACE_OP_BLIT       1
+#define RGA_TRACE_OP_FILL       2
+#define RGA_TRACE_OP_PALETTE    3
+
+/* rga_trace_record_t.flags */
+#define RGA_TRACE_ASYNC         (1 << 0)    /* duration is the submission only */
+#define RGA_TRACE_SRC1          (1 << 1)    /* pat is the src1 of a blit */
+
+typedef struct rga_trace_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t record_size;       /* sizeof(rga_trace_record_t) of the writer */
+    int32_t  pid;
+    float    driver_version;    /* of /dev/rga */
+    int64_t  start_ns;          /* CLOCK_REALTIME when the trace started */
+} rga_trace_header_t;
+
+/* an image of the request, format is a RK_FORMAT_* */
+typedef struct rga_trace_image {
+    int32_t xoffset;
+    int32_t yoffset;
+    int32_t width;
+    int32_t height;
+    int32_t wstride;
+    int32_t hstride;
+    int32_t format;
+} rga_trace_image_t;
+
+typedef struct rga_trace_record {
+    uint32_t op;
+    uint32_t flags;
+    int64_t  time_ns;           /* submission, from the start of the trace */
+    int64_t  duration_ns;       /* spent in the driver */
+    int32_t  ret;               /* 0 or the negative errno of the request */
+
+    /* the rga_info_t of the call */
+    int32_t  rotation;
+    int32_t  blend;
+    uint32_t color;
+    int32_t  scale_mode;
+    int32_t  color_space_mode;
+    int32_t  rop_code;
+
+    /* the rga_req built from it */
+    uint8_t  render_mode;
+    uint8_t  rotate_mode;
+    uint8_t  req_scale_mode;
+    uint8_t  alpha_rop_flag;
+    uint8_t  alpha_rop_mode;
+    uint8_t  PD_mode;
+    uint8_t  yuv2rgb_mode;
+    uint8_t  palette_mode;
+
+    rga_trace_image_t src;
+    rga_trace_image_t dst;
+    rga_trace_image_t pat;      /* src1 of a blit or lut of a palette */
+} rga_trace_record_t;
+
+#endif
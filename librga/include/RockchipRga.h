@@ -35,6 +35,21 @@
 #include "RgaUtils.h"
 #include "rga.h"
 
+struct rgaPool;
+
+/*
+ * Where RockchipRga runs the work. Selected by "RGA_BACKEND" (Linux) or
+ * "vendor.rga.backend" (Android): hw, sw or auto, default auto. auto uses
+ * /dev/rga when it can be opened and the CPU implementation otherwise.
+ */
+typedef enum {
+    RGA_BACKEND_AUTO = 0,
+    RGA_BACKEND_HW,
+    RGA_BACKEND_SW,
+} RGA_BACKEND_TYPE;
+
+struct rgaBackend;
+
 //////////////////////////////////////////////////////////////////////////////////
 #ifndef ANDROID
 #include "RgaSingleton.h"
@@ -68,6 +83,17 @@ namespace android {
         int         RkRgaUnmap(bo_t *bo_info);
         int         RkRgaFree(bo_t *bo_info);
         int         RkRgaGetBufferFd(bo_t *bo_info, int *fd);
+
+        /*
+         * the buffers of RkRgaGetAllocBuffer*() released by RkRgaFree() are kept
+         * mapped for reuse within a byte budget, "RGA_ALLOC_POOL_MB" or 32M by
+         * default, 0 disables it. RkRgaAllocPoolTrim() releases cached buffers,
+         * least recently freed first, until at most keep bytes are cached and
+         * returns the bytes released.
+         */
+        int         RkRgaAllocPoolQuery(rga_alloc_pool_info_t *info);
+        size_t      RkRgaAllocPoolTrim(size_t keep);
+        void        RkRgaAllocPoolSetBudget(size_t budget);
 #else
         int         RkRgaGetBufferFd(buffer_handle_t handle, int *fd);
         int         RkRgaGetHandleMapCpuAddress(buffer_handle_t handle, void **buf);
@@ -77,6 +103,45 @@ namespace android {
         int         RkRgaCollorFill(rga_info *dst);
         int         RkRgaCollorPalette(rga_info *src, rga_info *dst, rga_info *lut);
         int         RkRgaFlush();
+        int         RkRgaGetVersion(char *version, int size);
+
+        /* run on the CPU whatever backend is active, for work the hardware cannot do. */
+        int         RkRgaSoftBlit(rga_info *src, rga_info *dst, rga_info *src1);
+        int         RkRgaSoftCollorFill(rga_info *dst);
+
+        /*
+         * contexts of their own, with a device session and buffer pool not shared
+         * with other threads. RkRgaBindContext() makes the calling thread submit to
+         * ctx, NULL goes back to the shared one; it returns the one bound before.
+         */
+        int         RkRgaCreateContext(void **ctx);
+        int         RkRgaDestroyContext(void *ctx);
+        void *      RkRgaBindContext(void *ctx);
+
+        /*
+         * intermediate buffers of multi-pass operations, NULL until initialized.
+         * RkRgaPoolTrim() releases the cached buffers unused for idle_ms and
+         * returns the bytes released, 0 releases all of them.
+         */
+        struct rgaPool *RkRgaGetPool();
+        int         RkRgaPoolQuery(rga_pool_info_t *info);
+        size_t      RkRgaPoolTrim(int idle_ms);
+
+        /* the palette table uploads RkRgaCollorPalette() skipped and did */
+        int         RkRgaPaletteCacheQuery(rga_palette_cache_info_t *info);
+
+        /* RGA_BACKEND_HW or RGA_BACKEND_SW once initialized. */
+        int         RkRgaGetBackend();
+        /* the configured mode, RGA_BACKEND_AUTO allows per operation fallback. */
+        inline int  RkRgaGetBackendMode() {
+            return mBackendMode;
+        }
+        /*
+         * deinit and init again on the backend name, "hw", "sw" or "auto" as in
+         * RGA_BACKEND, whatever the environment says. The contexts of the previous
+         * backend must be destroyed before.
+         */
+        int         RkRgaSetBackend(const char *name);
 
 
         void        RkRgaSetLogOnceFlag(int log) {
@@ -94,10 +159,18 @@ namespace android {
         RockchipRga();
         ~RockchipRga();
       private:
+        /* NormalRga until initialized, its calls fail with -ENODEV then. */
+        const struct rgaBackend *RkRgaBackend();
+        int         RkRgaInitBackend(int mode);
+        /* the context bound to the calling thread, or else the shared one */
+        void *      RkRgaContext();
+
         bool                            mSupportRga;
         int                             mLogOnce;
         int                             mLogAlways;
         void *                          mContext;
+        int                             mBackendMode;
+        const struct rgaBackend *       mBackend;
 
         friend class Singleton<RockchipRga>;
     };
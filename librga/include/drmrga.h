@@ -166,6 +166,57 @@ typedef struct rga_info {
 } rga_info_t;
 
 
+/*
+   state of the pool of intermediate buffers, see RkRgaPoolQuery()
+   @value size:       bytes allocated, in use or cached
+   @value in_use:     bytes handed out
+   @value high_water: the most bytes allocated at a time
+   @value count:      buffers allocated
+   @value dma:        the buffers are dma-buf
+ */
+typedef struct rga_pool_info {
+    size_t size;
+    size_t in_use;
+    size_t high_water;
+    int count;
+    int dma;
+} rga_pool_info_t;
+
+/*
+   state of the pool of RkRgaGetAllocBuffer() buffers, see RkRgaAllocPoolQuery()
+   @value budget:     most bytes kept cached
+   @value cached:     bytes freed and kept for reuse
+   @value in_use:     bytes handed out by the pool
+   @value high_water: the most bytes cached and in use at a time
+   @value cached_count/in_use_count: buffers cached and handed out
+   @value hits:       allocations served by a cached buffer
+   @value misses:     allocations of a new buffer
+   @value evictions:  cached buffers released by the budget or a trim
+ */
+typedef struct rga_alloc_pool_info {
+    size_t budget;
+    size_t cached;
+    size_t in_use;
+    size_t high_water;
+    int cached_count;
+    int in_use_count;
+    long hits;
+    long misses;
+    long evictions;
+} rga_alloc_pool_info_t;
+
+/*
+   state of the palette table cache, see RkRgaPaletteCacheQuery()
+   @value enabled:    the table upload is skipped for the lut of the last upload
+   @value hits:       palette calls that skipped the upload
+   @value misses:     palette calls that uploaded the table
+ */
+typedef struct rga_palette_cache_info {
+    int enabled;
+    long hits;
+    long misses;
+} rga_palette_cache_info_t;
+
 typedef struct drm_rga {
     rga_rect_t src;
     rga_rect_t dst;
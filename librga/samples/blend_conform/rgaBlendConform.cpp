@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2020 Rockchip Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rgaBlendConform: every IM_ALPHA_BLEND_* mode of imblend()/imcomposite() against
+ * a cpu reference of the Porter-Duff equations on premultiplied RGBA_8888.
+ *
+ * The result must match the reference exactly, except src over and dst over
+ * which the rga computes with 8 bit alpha factors (a + a / 128) / 256 and the cpu
+ * backend mirrors that, they may be off by one. Exits non zero on a mismatch or
+ * on a mode that fails. Without /dev/rga, run it with --backend sw.
+ */
+
+#include "im2d_api/im2d.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "RockchipRga.h"
+#include "RgaUtils.h"
+#include "rga.h"
+
+#define CONFORM_WIDTH       64
+#define CONFORM_HEIGHT      32
+
+/* Porter-Duff factors */
+enum {
+    F_ZERO = 0,
+    F_ONE,
+    F_SA,
+    F_ISA,
+    F_DA,
+    F_IDA,
+};
+
+typedef struct {
+    int mode;
+    const char *name;
+    int fs;                 /* src factor */
+    int fd;                 /* dst factor */
+    int tolerance;
+} conform_mode_t;
+
+static const conform_mode_t conform_modes[] = {
+    { IM_ALPHA_BLEND_SRC,      "src",      F_ONE,  F_ZERO, 0 },
+    { IM_ALPHA_BLEND_DST,      "dst",      F_ZERO, F_ONE,  0 },
+    { IM_ALPHA_BLEND_SRC_OVER, "src_over", F_ONE,  F_ISA,  1 },
+    { IM_ALPHA_BLEND_DST_OVER, "dst_over", F_IDA,  F_ONE,  1 },
+    { IM_ALPHA_BLEND_SRC_IN,   "src_in",   F_DA,   F_ZERO, 0 },
+    { IM_ALPHA_BLEND_DST_IN,   "dst_in",   F_ZERO, F_SA,   0 },
+    { IM_ALPHA_BLEND_SRC_OUT,  "src_out",  F_IDA,  F_ZERO, 0 },
+    { IM_ALPHA_BLEND_DST_OUT,  "dst_out",  F_ZERO, F_ISA,  0 },
+    { IM_ALPHA_BLEND_SRC_ATOP, "src_atop", F_DA,   F_ISA,  0 },
+    { IM_ALPHA_BLEND_DST_ATOP, "dst_atop", F_IDA,  F_SA,   0 },
+    { IM_ALPHA_BLEND_XOR,      "xor",      F_IDA,  F_ISA,  0 },
+};
+
+static int conform_factor(int f, int sa, int da) {
+    switch (f) {
+        case F_ONE:
+            return 255;
+        case F_SA:
+            return sa;
+        case F_ISA:
+            return 255 - sa;
+        case F_DA:
+            return da;
+        case F_IDA:
+            return 255 - da;
+    }
+
+    return 0;
+}
+
+static void conform_reference(const conform_mode_t *m, const uint8_t *s, const uint8_t *d, uint8_t *out, int pixels) {
+    for (int i = 0; i < pixels; i++, s += 4, d += 4, out += 4) {
+        int fs = conform_factor(m->fs, s[3], d[3]);
+        int fd = conform_factor(m->fd, s[3], d[3]);
+
+        for (int c = 0; c < 4; c++) {
+            int v = (s[c] * fs + d[c] * fd + 127) / 255;
+            out[c] = v > 255 ? 255 : v;
+        }
+    }
+}
+
+/* premultiplied pixels, with the alpha extremes every few pixels */
+static void conform_pattern(uint8_t *buf, int pixels, unsigned int seed) {
+    for (int i = 0; i < pixels; i++, buf += 4) {
+        int a;
+
+        seed = seed * 1103515245 + 12345;
+        a = (seed >> 16) & 0xff;
+        if (i % 7 == 0)
+            a = 0;
+        else if (i % 5 == 0)
+            a = 255;
+        for (int c = 0; c < 3; c++) {
+            seed = seed * 1103515245 + 12345;
+            buf[c] = ((seed >> 16) & 0xff) * a / 255;
+        }
+        buf[3] = a;
+    }
+}
+
+/* a onto b in place, or onto c when composite is set */
+static int conform_run(const conform_mode_t *m, bool composite) {
+    int pixels = CONFORM_WIDTH * CONFORM_HEIGHT;
+    size_t size = (size_t)pixels * 4;
+    uint8_t *a = (uint8_t *)malloc(size), *b = (uint8_t *)malloc(size);
+    uint8_t *c = (uint8_t *)malloc(size), *ref = (uint8_t *)malloc(size);
+    rga_buffer_t fg, bg, dst;
+    int max_diff = 0, bad = 0;
+    IM_STATUS ret;
+
+    if (!a || !b || !c || !ref) {
+        printf("%-10s out of memory\n", m->name);
+        free(a); free(b); free(c); free(ref);
+        return -1;
+    }
+
+    conform_pattern(a, pixels, 1);
+    conform_pattern(b, pixels, 2);
+    memset(c, 0, size);
+    conform_reference(m, a, b, ref, pixels);
+
+    fg = wrapbuffer_virtualaddr(a, CONFORM_WIDTH, CONFORM_HEIGHT, RK_FORMAT_RGBA_8888);
+    bg = wrapbuffer_virtualaddr(b, CONFORM_WIDTH, CONFORM_HEIGHT, RK_FORMAT_RGBA_8888);
+    dst = wrapbuffer_virtualaddr(c, CONFORM_WIDTH, CONFORM_HEIGHT, RK_FORMAT_RGBA_8888);
+
+    if (composite)
+        ret = imcomposite(fg, bg, dst, m->mode);
+    else
+        ret = imblend(fg, bg, m->mode);
+
+    if (ret == IM_STATUS_SUCCESS) {
+        const uint8_t *out = composite ? c : b;
+
+        for (size_t i = 0; i < size; i++) {
+            int diff = abs(out[i] - ref[i]);
+
+            if (diff > max_diff)
+                max_diff = diff;
+            if (diff > m->tolerance && bad++ == 0)
+                printf("%-10s pixel %zu channel %zu: 0x%02x, expected 0x%02x\n", m->name,
+                       i / 4, i % 4, out[i], ref[i]);
+        }
+    }
+
+    printf("%-10s %-9s %-8s max diff %d, %d mismatch(es)\n", m->name, composite ? "composite" : "blend",
+           ret == IM_STATUS_SUCCESS ? "ok" : imStrError_t(ret), max_diff, bad);
+
+    free(a);
+    free(b);
+    free(c);
+    free(ref);
+
+    return ret == IM_STATUS_SUCCESS && bad == 0 ? 0 : -1;
+}
+
+static void conform_usage(void) {
+    printf("usage: rgaBlendConform [options]\n"
+           "  --backend <name>     hw, sw or auto, see RGA_BACKEND\n"
+           "  --help\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *backend = NULL;
+    int failed = 0;
+    int opt, option_index = 0;
+
+    static struct option options[] = {
+        { "backend", required_argument, NULL, 'b' },
+        {    "help",       no_argument, NULL, 'h' },
+        {      NULL,                 0, NULL, 0   },
+    };
+
+    while ((opt = getopt_long(argc, argv, "h", options, &option_index)) != -1) {
+        switch (opt) {
+            case 'b':
+                backend = optarg;
+                break;
+            case 'h':
+            default:
+                conform_usage();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    /* librga picked its backend from RGA_BACKEND when it was loaded */
+    if (backend != NULL && RockchipRga::get().RkRgaSetBackend(backend)) {
+        printf("Failed to init the %s backend.\n", backend);
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(conform_modes) / sizeof(conform_modes[0]); i++) {
+        failed += conform_run(&conform_modes[i], false) != 0;
+        failed += conform_run(&conform_modes[i], true) != 0;
+    }
+
+    printf("%d failure(s)\n", failed);
+
+    return failed ? 1 : 0;
+}
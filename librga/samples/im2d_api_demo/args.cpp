@@ -31,7 +31,7 @@ void help_function() {
     printf( "   usage: rgaImDemo [--help/-h] [--while/-w=(time)] [--querystring/--querystring=<options>]\n"
             "                    [--copy] [--resize=<up/down>] [--crop] [--rotate=90/180/270]\n"
             "                    [--flip=H/V] [--translate] [--blend] [--cvtcolor]\n"
-            "                    [--fill=blue/green/red]\n");
+            "                    [--fill=blue/green/red] [--batch]\n");
     printf( "\t --help/-h     Call help\n"
             "\t --while/w     Set the loop mode. Users can set the number of cycles by themselves.\n"
             "\t --querystring You can print the version or support information corresponding to the current version of RGA according to the options.\n"
@@ -54,7 +54,8 @@ void help_function() {
             "\t --translate   Translate the image by RGA.Default translation (300,300).\n"
             "\t --blend       Blend the image by RGA.Default, Porter-Duff 'SRC over DST'.\n"
             "\t --cvtcolor    Modify the image format and color space by RGA.The default is RGBA8888 to NV12.\n"
-            "\t --fill        Fill the image by RGA to blue, green, red, when you set the option to the corresponding color.\n");
+            "\t --fill        Fill the image by RGA to blue, green, red, when you set the option to the corresponding color.\n"
+            "\t --batch       Copy the image as 4x4 tiles by RGA, one call per tile and then as one batch job, and compare the throughput.\n");
     printf("=============================================================================================\n\n");
 }
 
@@ -72,6 +73,7 @@ int readArguments(int argc, char *argv[], int* parm) {
         {       "blend",       no_argument, NULL, MODE_BLEND_CHAR         },
         {    "cvtcolor",       no_argument, NULL, MODE_CVTCOLOR_CHAR      },
         {        "fill", required_argument, NULL, MODE_FILL_CHAR          },
+        {       "batch",       no_argument, NULL, MODE_BATCH_CHAR         },
         {        "help",       no_argument, NULL, 'h'                     },
         {		"while", required_argument, NULL, 'w'                     },
         {         NULL ,                 0, NULL, 0                       },
@@ -164,6 +166,12 @@ int readArguments(int argc, char *argv[], int* parm) {
                 mode_code |= MODE_FILL;
                 return mode_code;
 
+            case MODE_BATCH_CHAR :
+                printf("im2d batch ..\n");
+
+                mode_code |= MODE_BATCH;
+                return mode_code;
+
             case 'h' :
                 help_function();
                 mode_code |= MODE_NONE;
@@ -33,6 +33,7 @@ typedef enum _mode_code {
     MODE_BLEND,
     MODE_CVTCOLOR,
     MODE_FILL,
+    MODE_BATCH,
     MODE_WHILE,
     MODE_NONE,
     MODE_MAX
@@ -48,6 +49,7 @@ typedef enum _mode_code {
 #define MODE_BLEND_CHAR           (char) (MODE_BLEND      +'0')
 #define MODE_CVTCOLOR_CHAR        (char) (MODE_CVTCOLOR   +'0')
 #define MODE_FILL_CHAR            (char) (MODE_FILL       +'0')
+#define MODE_BATCH_CHAR           (char) (MODE_BATCH      +'0')
 #define MODE_NONE_CHAR            (char) (MODE_NONE       +'0')
 
 #define BLUE_COLOR  0xffff0000
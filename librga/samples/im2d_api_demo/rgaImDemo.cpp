@@ -59,6 +59,10 @@
 #define DST_FORMAT RK_FORMAT_RGBA_8888
 #endif
 
+/********** Batch set **********/
+#define BATCH_TILE_COLS 4
+#define BATCH_TILE_ROWS 4
+
 struct timeval start, end;
 long usec1;
 
@@ -655,6 +659,77 @@ int main(int argc, char*  argv[]) {
 
 	            break;
 
+	        case MODE_BATCH :     //rgaImDemo --batch
+	        {
+	            const int tile_num = BATCH_TILE_COLS * BATCH_TILE_ROWS;
+	            IM_STATUS task_status[BATCH_TILE_COLS * BATCH_TILE_ROWS];
+	            im_job_handle_t job;
+	            rga_buffer_t pat;
+	            im_rect pat_rect;
+	            long usec_single, usec_batch;
+
+	            memset(&pat, 0, sizeof(pat));
+	            memset(&pat_rect, 0, sizeof(pat_rect));
+
+	            src_rect.width  = src.width / BATCH_TILE_COLS;
+	            src_rect.height = src.height / BATCH_TILE_ROWS;
+	            dst_rect.width  = src_rect.width;
+	            dst_rect.height = src_rect.height;
+
+	            /* one improcess() per tile */
+	            gettimeofday(&start, NULL);
+
+	            for (int i = 0; i < tile_num; i++) {
+	                src_rect.x = (i % BATCH_TILE_COLS) * src_rect.width;
+	                src_rect.y = (i / BATCH_TILE_COLS) * src_rect.height;
+	                dst_rect.x = src_rect.x;
+	                dst_rect.y = src_rect.y;
+
+	                STATUS = improcess(src, dst, pat, src_rect, dst_rect, pat_rect, 0);
+	                if (STATUS <= 0) {
+	                    printf("tile[%d] failed, %s\n", i, imStrError(STATUS));
+	                    break;
+	                }
+	            }
+
+	            gettimeofday(&end, NULL);
+	            usec_single = 1000000 * (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec);
+
+	            /* all tiles in one job */
+	            gettimeofday(&start, NULL);
+
+	            job = imbeginJob();
+	            if (job == NULL) {
+	                printf("%s, %s\n", __FUNCTION__, imStrError());
+	                return ERROR;
+	            }
+
+	            for (int i = 0; i < tile_num; i++) {
+	                src_rect.x = (i % BATCH_TILE_COLS) * src_rect.width;
+	                src_rect.y = (i / BATCH_TILE_COLS) * src_rect.height;
+	                dst_rect.x = src_rect.x;
+	                dst_rect.y = src_rect.y;
+
+	                imaddTask(job, src, dst, pat, src_rect, dst_rect, pat_rect, 0);
+	            }
+
+	            STATUS = imendJob(job, 1, task_status, tile_num);
+
+	            gettimeofday(&end, NULL);
+	            usec_batch = 1000000 * (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec);
+
+	            for (int i = 0; i < tile_num; i++)
+	                if (task_status[i] <= 0)
+	                    printf("task[%d] failed, %s\n", i, imStrError(task_status[i]));
+
+	            printf("single .... %d tasks cost time %ld us, %.1f tasks/s\n", tile_num, usec_single,
+	                   usec_single > 0 ? tile_num * 1000000.0 / usec_single : 0);
+	            printf("batch  .... %d tasks cost time %ld us, %.1f tasks/s, %s\n", tile_num, usec_batch,
+	                   usec_batch > 0 ? tile_num * 1000000.0 / usec_batch : 0, imStrError(STATUS));
+
+	            break;
+	        }
+
 	        case MODE_NONE :
 
 	            printf("%s, Unknown mode\n", __FUNCTION__);
@@ -0,0 +1,657 @@
+/*
+ * Copyright (C) 2020 Rockchip Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rgaImBench: im2d throughput and latency over operations x formats x resolutions
+ * x sync/async/compiled.
+ *
+ * Every operation is one job of one task: imbeginJob()/imaddTask() is the setup
+ * (checks and request building), imendJob() the submission to the driver. In sync
+ * mode each job waits for its completion and the latency is setup + submission. In
+ * async mode the jobs are queued back-to-back and completed by a final imsync(),
+ * the latency is what the caller is blocked for.
+ *
+ * In compiled mode the operation is checked once by imcompile() and every run is a
+ * synchronous imexecute_t(), the cpu column against the one of sync mode is the
+ * saving per call of a compiled operation, reported as "saved".
+ *
+ * Without /dev/rga, run it with --backend sw on the cpu backend.
+ */
+
+#include "im2d_api/im2d.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "RockchipRga.h"
+#include "RgaUtils.h"
+#include "rga.h"
+
+#define BENCH_ITERATIONS    50
+#define BENCH_WARMUP        3
+#define BENCH_BUF_ALIGN     64
+
+enum {
+    BENCH_OP_COPY = 0,
+    BENCH_OP_RESIZE_DOWN,
+    BENCH_OP_RESIZE_UP,
+    BENCH_OP_CROP,
+    BENCH_OP_ROTATE,
+    BENCH_OP_FLIP,
+    BENCH_OP_CVTCOLOR,
+    BENCH_OP_FILL,
+    BENCH_OP_BLEND,
+    BENCH_OP_MAX
+};
+
+enum {
+    BENCH_MODE_ASYNC = 0,
+    BENCH_MODE_SYNC,
+    BENCH_MODE_COMPILED,
+    BENCH_MODE_MAX
+};
+
+static const char *bench_mode_names[BENCH_MODE_MAX] = {
+    "async", "sync", "compiled",
+};
+
+static const char *bench_op_names[BENCH_OP_MAX] = {
+    "copy", "resize_down", "resize_up", "crop", "rotate90", "flip", "cvtcolor", "fill", "blend",
+};
+
+typedef struct {
+    const char *name;
+    int format;
+} bench_format_t;
+
+static const bench_format_t bench_formats[] = {
+    { "rgba8888", RK_FORMAT_RGBA_8888 },
+    { "bgra8888", RK_FORMAT_BGRA_8888 },
+    { "rgb888",   RK_FORMAT_RGB_888 },
+    { "rgb565",   RK_FORMAT_RGB_565 },
+    { "nv12",     RK_FORMAT_YCbCr_420_SP },
+    { "nv21",     RK_FORMAT_YCrCb_420_SP },
+    { "i420",     RK_FORMAT_YCbCr_420_P },
+};
+
+typedef struct {
+    int width;
+    int height;
+} bench_size_t;
+
+typedef struct {
+    int op;
+    const bench_format_t *format;
+    bench_size_t size;
+    int mode;
+
+    IM_STATUS status;
+    int iterations;
+    double mpix_s;
+    double p50_us;
+    double p99_us;
+    double setup_us;        /* mean imbeginJob() + imaddTask(), 0 when compiled */
+    double submit_us;       /* mean imendJob() or imexecute_t() */
+    double cpu_us;          /* process cpu time per operation */
+    double saved_us;        /* compiled: cpu time per call saved against sync */
+} bench_result_t;
+
+typedef struct {
+    void *addr;
+    rga_buffer_t buf;
+} bench_buffer_t;
+
+static int64_t bench_now_us(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int bench_alloc(bench_buffer_t *b, int width, int height, int format) {
+    size_t size = (size_t)(width * height * get_bpp_from_format(format));
+
+    if (posix_memalign(&b->addr, BENCH_BUF_ALIGN, size)) {
+        b->addr = NULL;
+        return -1;
+    }
+
+    /* a pattern rather than zero pages, the cpu backend must really read it */
+    for (size_t i = 0; i < size; i++)
+        ((uint8_t *)b->addr)[i] = (uint8_t)(i * 7 + (i >> 10));
+
+    b->buf = wrapbuffer_virtualaddr(b->addr, width, height, format);
+    return 0;
+}
+
+static void bench_free(bench_buffer_t *b) {
+    free(b->addr);
+    b->addr = NULL;
+}
+
+static double bench_percentile(std::vector<double> &v, double p) {
+    size_t i;
+
+    if (v.empty())
+        return 0;
+
+    std::sort(v.begin(), v.end());
+    i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[std::min(i, v.size() - 1)];
+}
+
+static bool bench_is_yuv(int format) {
+    return format == RK_FORMAT_YCbCr_420_SP || format == RK_FORMAT_YCrCb_420_SP ||
+           format == RK_FORMAT_YCbCr_420_P;
+}
+
+/*
+ * The buffers and the improcess() arguments of an operation. Returns false if the
+ * operation makes no sense for the format.
+ */
+static bool bench_setup(int op, int format, int w, int h,
+                        int *sw, int *sh, int *sfmt, int *dw, int *dh, int *dfmt,
+                        im_rect *srect, im_rect *drect, int *usage, long *pixels) {
+    *sw = w;
+    *sh = h;
+    *sfmt = format;
+    *dw = w;
+    *dh = h;
+    *dfmt = format;
+    *usage = 0;
+    memset(srect, 0, sizeof(*srect));
+    memset(drect, 0, sizeof(*drect));
+
+    switch (op) {
+        case BENCH_OP_COPY:
+            break;
+        case BENCH_OP_RESIZE_DOWN:
+            *dw = w / 2;
+            *dh = h / 2;
+            break;
+        case BENCH_OP_RESIZE_UP:
+            *sw = w / 2;
+            *sh = h / 2;
+            break;
+        case BENCH_OP_CROP:
+            *dw = w / 2;
+            *dh = h / 2;
+            srect->x = w / 4;
+            srect->y = h / 4;
+            srect->width = w / 2;
+            srect->height = h / 2;
+            *usage = IM_CROP;
+            break;
+        case BENCH_OP_ROTATE:
+            *dw = h;
+            *dh = w;
+            *usage = IM_HAL_TRANSFORM_ROT_90;
+            break;
+        case BENCH_OP_FLIP:
+            *usage = IM_HAL_TRANSFORM_FLIP_H;
+            break;
+        case BENCH_OP_CVTCOLOR:
+            *dfmt = bench_is_yuv(format) ? RK_FORMAT_RGBA_8888 : RK_FORMAT_YCbCr_420_SP;
+            break;
+        case BENCH_OP_FILL:
+            drect->width = w;
+            drect->height = h;
+            *usage = IM_COLOR_FILL;
+            break;
+        case BENCH_OP_BLEND:
+            if (format != RK_FORMAT_RGBA_8888 && format != RK_FORMAT_BGRA_8888)
+                return false;
+            *usage = IM_ALPHA_BLEND_SRC_OVER;
+            break;
+    }
+
+    /* the larger side of the operation, what bounds its speed */
+    if (op == BENCH_OP_CROP)
+        *pixels = (long)*dw * *dh;
+    else
+        *pixels = std::max((long)*sw * *sh, (long)*dw * *dh);
+    return true;
+}
+
+static void bench_run(bench_result_t *r, int iterations, int warmup) {
+    bench_buffer_t src, dst;
+    rga_buffer_t pat;
+    im_rect srect, drect, prect;
+    int sw, sh, sfmt, dw, dh, dfmt, usage;
+    long pixels;
+    std::vector<double> latency;
+    int64_t setup = 0, submit = 0, wall = 0, cpu = 0;
+    im_desc_handle_t desc = NULL;
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+
+    r->status = IM_STATUS_NOT_SUPPORTED;
+    r->iterations = 0;
+
+    if (!bench_setup(r->op, r->format->format, r->size.width, r->size.height,
+                     &sw, &sh, &sfmt, &dw, &dh, &dfmt, &srect, &drect, &usage, &pixels))
+        return;
+
+    memset(&src, 0, sizeof(src));
+    memset(&dst, 0, sizeof(dst));
+    if (bench_alloc(&src, sw, sh, sfmt) || bench_alloc(&dst, dw, dh, dfmt)) {
+        r->status = IM_STATUS_OUT_OF_MEMORY;
+        goto out;
+    }
+
+    memset(&pat, 0, sizeof(pat));
+    memset(&prect, 0, sizeof(prect));
+    dst.buf.color = 0xff00ff00;
+    if (r->op == BENCH_OP_FILL)
+        src.buf = pat;
+
+    if (r->mode == BENCH_MODE_COMPILED) {
+        ret = imcompile(src.buf, dst.buf, pat, srect, drect, prect, usage, &desc);
+        if (ret != IM_STATUS_SUCCESS) {
+            r->status = ret;
+            goto out;
+        }
+    }
+
+    for (int i = -warmup; i < iterations; i++) {
+        im_job_handle_t job;
+        int64_t t0, t1, t2;
+
+        if (i == 0) {
+            /* the warmup ran async jobs too, start from an idle device */
+            imsync();
+            wall = bench_now_us(CLOCK_MONOTONIC);
+            cpu = bench_now_us(CLOCK_PROCESS_CPUTIME_ID);
+        }
+
+        if (desc != NULL) {
+            t0 = bench_now_us(CLOCK_MONOTONIC);
+            ret = imexecute_t(desc, src.buf, dst.buf, pat);
+            t2 = bench_now_us(CLOCK_MONOTONIC);
+            if (ret != IM_STATUS_SUCCESS)
+                break;
+
+            if (i >= 0) {
+                submit += t2 - t0;
+                latency.push_back(t2 - t0);
+            }
+            continue;
+        }
+
+        t0 = bench_now_us(CLOCK_MONOTONIC);
+        job = imbeginJob();
+        if (job == NULL) {
+            ret = IM_STATUS_OUT_OF_MEMORY;
+            break;
+        }
+        ret = imaddTask(job, src.buf, dst.buf, pat, srect, drect, prect, usage);
+        if (ret != IM_STATUS_SUCCESS) {
+            imcancelJob(job);
+            break;
+        }
+        t1 = bench_now_us(CLOCK_MONOTONIC);
+        ret = imendJob(job, r->mode == BENCH_MODE_SYNC, NULL, 0);
+        t2 = bench_now_us(CLOCK_MONOTONIC);
+        if (ret != IM_STATUS_SUCCESS)
+            break;
+
+        if (i >= 0) {
+            setup += t1 - t0;
+            submit += t2 - t1;
+            latency.push_back(t2 - t0);
+        }
+    }
+
+    if (ret != IM_STATUS_SUCCESS) {
+        r->status = ret;
+        goto out;
+    }
+
+    if (imsync() != IM_STATUS_SUCCESS) {
+        r->status = IM_STATUS_FAILED;
+        goto out;
+    }
+    wall = bench_now_us(CLOCK_MONOTONIC) - wall;
+    cpu = bench_now_us(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+
+    r->status = IM_STATUS_SUCCESS;
+    r->iterations = iterations;
+    r->mpix_s = wall > 0 ? (double)pixels * iterations / wall : 0;
+    r->setup_us = (double)setup / iterations;
+    r->submit_us = (double)submit / iterations;
+    r->cpu_us = (double)cpu / iterations;
+    r->p50_us = bench_percentile(latency, 0.50);
+    r->p99_us = bench_percentile(latency, 0.99);
+
+out:
+    if (desc != NULL)
+        imdestroyDesc(desc);
+    bench_free(&src);
+    bench_free(&dst);
+}
+
+static const char *bench_status(IM_STATUS status) {
+    switch (status) {
+        case IM_STATUS_SUCCESS:
+            return "ok";
+        case IM_STATUS_NOT_SUPPORTED:
+            return "not_supported";
+        case IM_STATUS_OUT_OF_MEMORY:
+            return "out_of_memory";
+        case IM_STATUS_INVALID_PARAM:
+            return "invalid_param";
+        case IM_STATUS_ILLEGAL_PARAM:
+            return "illegal_param";
+        default:
+            return "failed";
+    }
+}
+
+static void bench_print(const bench_result_t *r) {
+    printf("%-12s %-9s %5dx%-5d %-8s %10.1f %10.1f %10.1f %9.1f %9.1f %9.1f %9.1f  %s\n",
+           bench_op_names[r->op], r->format->name, r->size.width, r->size.height,
+           bench_mode_names[r->mode], r->mpix_s, r->p50_us, r->p99_us,
+           r->setup_us, r->submit_us, r->cpu_us, r->saved_us, bench_status(r->status));
+}
+
+static void bench_write_csv(FILE *f, const std::vector<bench_result_t> &results) {
+    fprintf(f, "op,format,width,height,mode,iterations,mpix_s,p50_us,p99_us,setup_us,submit_us,cpu_us,saved_us,status\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result_t *r = &results[i];
+
+        fprintf(f, "%s,%s,%d,%d,%s,%d,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%s\n",
+                bench_op_names[r->op], r->format->name, r->size.width, r->size.height,
+                bench_mode_names[r->mode], r->iterations, r->mpix_s, r->p50_us, r->p99_us,
+                r->setup_us, r->submit_us, r->cpu_us, r->saved_us, bench_status(r->status));
+    }
+}
+
+/* "RGA version : RGA_2\n" -> "RGA_2" */
+static std::string bench_version(void) {
+    std::string s(querystring(RGA_VERSION));
+    size_t pos = s.find(':');
+
+    if (pos != std::string::npos)
+        s = s.substr(pos + 1);
+    while (!s.empty() && (s[0] == ' ' || s[0] == '\t'))
+        s.erase(0, 1);
+    while (!s.empty() && (s[s.size() - 1] == '\n' || s[s.size() - 1] == ' '))
+        s.erase(s.size() - 1);
+
+    return s;
+}
+
+static void bench_write_json(FILE *f, const std::vector<bench_result_t> &results) {
+    fprintf(f, "{\n  \"version\": \"%s\",\n  \"results\": [\n", bench_version().c_str());
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result_t *r = &results[i];
+
+        fprintf(f, "    {\"op\": \"%s\", \"format\": \"%s\", \"width\": %d, \"height\": %d, "
+                "\"mode\": \"%s\", \"iterations\": %d, \"mpix_s\": %.2f, \"p50_us\": %.1f, "
+                "\"p99_us\": %.1f, \"setup_us\": %.1f, \"submit_us\": %.1f, \"cpu_us\": %.1f, "
+                "\"saved_us\": %.1f, \"status\": \"%s\"}%s\n",
+                bench_op_names[r->op], r->format->name, r->size.width, r->size.height,
+                bench_mode_names[r->mode], r->iterations, r->mpix_s, r->p50_us, r->p99_us,
+                r->setup_us, r->submit_us, r->cpu_us, r->saved_us, bench_status(r->status),
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static int bench_write(const char *path, const std::vector<bench_result_t> &results, bool json) {
+    FILE *f = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+
+    if (f == NULL) {
+        printf("Failed to open %s\n", path);
+        return -1;
+    }
+
+    if (json)
+        bench_write_json(f, results);
+    else
+        bench_write_csv(f, results);
+
+    if (f != stdout)
+        fclose(f);
+    return 0;
+}
+
+/* split a comma separated list */
+static std::vector<std::string> bench_split(const char *arg) {
+    std::vector<std::string> out;
+    std::string s(arg);
+    size_t pos = 0, next;
+
+    while ((next = s.find(',', pos)) != std::string::npos) {
+        out.push_back(s.substr(pos, next - pos));
+        pos = next + 1;
+    }
+    out.push_back(s.substr(pos));
+
+    return out;
+}
+
+static void bench_usage(void) {
+    printf("usage: rgaImBench [options]\n"
+           "  --ops <list>         %s", bench_op_names[0]);
+    for (int i = 1; i < BENCH_OP_MAX; i++)
+        printf(",%s", bench_op_names[i]);
+    printf("\n"
+           "  --formats <list>     rgba8888,bgra8888,rgb888,rgb565,nv12,nv21,i420 (default: rgba8888,nv12)\n"
+           "  --sizes <list>       WxH,... (default: 640x480,1280x720,1920x1080,3840x2160)\n"
+           "  --mode <list>        sync,async,compiled, both for sync,async (default: all)\n"
+           "  --iterations <n>     timed runs of each case (default: %d)\n"
+           "  --warmup <n>         untimed runs before (default: %d)\n"
+           "  --backend <name>     hw, sw or auto, see RGA_BACKEND\n"
+           "  --csv <file>         write the results as csv, - for stdout\n"
+           "  --json <file>        write the results as json, - for stdout\n"
+           "  --help\n", BENCH_ITERATIONS, BENCH_WARMUP);
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<int> ops;
+    std::vector<const bench_format_t *> formats;
+    std::vector<bench_size_t> sizes;
+    std::vector<int> modes;
+    std::vector<bench_result_t> results;
+    const char *csv = NULL, *json = NULL, *backend = NULL;
+    int iterations = BENCH_ITERATIONS, warmup = BENCH_WARMUP;
+    int opt, option_index = 0;
+    std::vector<std::string> list;
+
+    static struct option options[] = {
+        {        "ops", required_argument, NULL, 'o' },
+        {    "formats", required_argument, NULL, 'f' },
+        {      "sizes", required_argument, NULL, 's' },
+        {       "mode", required_argument, NULL, 'm' },
+        { "iterations", required_argument, NULL, 'n' },
+        {     "warmup", required_argument, NULL, 'w' },
+        {    "backend", required_argument, NULL, 'b' },
+        {        "csv", required_argument, NULL, 'c' },
+        {       "json", required_argument, NULL, 'j' },
+        {       "help",       no_argument, NULL, 'h' },
+        {         NULL,                 0, NULL, 0   },
+    };
+
+    while ((opt = getopt_long(argc, argv, "h", options, &option_index)) != -1) {
+        switch (opt) {
+            case 'o':
+                list = bench_split(optarg);
+                for (size_t i = 0; i < list.size(); i++) {
+                    int op;
+
+                    for (op = 0; op < BENCH_OP_MAX; op++)
+                        if (list[i] == bench_op_names[op])
+                            break;
+                    if (op == BENCH_OP_MAX) {
+                        printf("Unknown op %s\n", list[i].c_str());
+                        return -1;
+                    }
+                    ops.push_back(op);
+                }
+                break;
+            case 'f':
+                list = bench_split(optarg);
+                for (size_t i = 0; i < list.size(); i++) {
+                    size_t f;
+
+                    for (f = 0; f < sizeof(bench_formats) / sizeof(bench_formats[0]); f++)
+                        if (list[i] == bench_formats[f].name)
+                            break;
+                    if (f == sizeof(bench_formats) / sizeof(bench_formats[0])) {
+                        printf("Unknown format %s\n", list[i].c_str());
+                        return -1;
+                    }
+                    formats.push_back(&bench_formats[f]);
+                }
+                break;
+            case 's':
+                list = bench_split(optarg);
+                for (size_t i = 0; i < list.size(); i++) {
+                    bench_size_t size;
+
+                    if (sscanf(list[i].c_str(), "%dx%d", &size.width, &size.height) != 2 ||
+                        size.width < 4 || size.height < 4) {
+                        printf("Invalid size %s\n", list[i].c_str());
+                        return -1;
+                    }
+                    /* even sizes, so that halves stay valid for yuv 420 */
+                    size.width &= ~3;
+                    size.height &= ~3;
+                    sizes.push_back(size);
+                }
+                break;
+            case 'm':
+                list = bench_split(optarg);
+                for (size_t i = 0; i < list.size(); i++) {
+                    int mode;
+
+                    if (list[i] == "both") {
+                        modes.push_back(BENCH_MODE_SYNC);
+                        modes.push_back(BENCH_MODE_ASYNC);
+                        continue;
+                    }
+                    for (mode = 0; mode < BENCH_MODE_MAX; mode++)
+                        if (list[i] == bench_mode_names[mode])
+                            break;
+                    if (mode == BENCH_MODE_MAX) {
+                        printf("Unknown mode %s\n", list[i].c_str());
+                        return -1;
+                    }
+                    modes.push_back(mode);
+                }
+                break;
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'w':
+                warmup = atoi(optarg);
+                break;
+            case 'b':
+                backend = optarg;
+                break;
+            case 'c':
+                csv = optarg;
+                break;
+            case 'j':
+                json = optarg;
+                break;
+            case 'h':
+            default:
+                bench_usage();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    if (iterations <= 0 || warmup < 0) {
+        bench_usage();
+        return -1;
+    }
+
+    /* librga picked its backend from RGA_BACKEND when it was loaded */
+    if (backend != NULL && RockchipRga::get().RkRgaSetBackend(backend)) {
+        printf("Failed to init the %s backend.\n", backend);
+        return -1;
+    }
+
+    if (ops.empty())
+        for (int op = 0; op < BENCH_OP_MAX; op++)
+            ops.push_back(op);
+    if (formats.empty()) {
+        formats.push_back(&bench_formats[0]);
+        formats.push_back(&bench_formats[4]);
+    }
+    if (sizes.empty()) {
+        const bench_size_t defaults[] = { {640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160} };
+
+        sizes.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+    }
+    if (modes.empty()) {
+        modes.push_back(BENCH_MODE_SYNC);
+        modes.push_back(BENCH_MODE_ASYNC);
+        modes.push_back(BENCH_MODE_COMPILED);
+    }
+
+    printf("%s", querystring(RGA_VERSION));
+    printf("%-12s %-9s %11s %-8s %10s %10s %10s %9s %9s %9s %9s  %s\n",
+           "op", "format", "size", "mode", "MPix/s", "p50(us)", "p99(us)",
+           "setup", "submit", "cpu", "saved", "status");
+
+    for (size_t o = 0; o < ops.size(); o++) {
+        for (size_t f = 0; f < formats.size(); f++) {
+            for (size_t s = 0; s < sizes.size(); s++) {
+                for (size_t m = 0; m < modes.size(); m++) {
+                    bench_result_t r;
+
+                    memset(&r, 0, sizeof(r));
+                    r.op = ops[o];
+                    r.format = formats[f];
+                    r.size = sizes[s];
+                    r.mode = modes[m];
+
+                    bench_run(&r, iterations, warmup);
+                    /* against the sync run of the same case, the same work done by improcess() */
+                    if (r.mode == BENCH_MODE_COMPILED && r.status == IM_STATUS_SUCCESS) {
+                        for (size_t i = 0; i < results.size(); i++) {
+                            const bench_result_t *sync = &results[i];
+
+                            if (sync->op == r.op && sync->format == r.format &&
+                                sync->size.width == r.size.width && sync->size.height == r.size.height &&
+                                sync->mode == BENCH_MODE_SYNC && sync->status == IM_STATUS_SUCCESS)
+                                r.saved_us = sync->cpu_us - r.cpu_us;
+                        }
+                    }
+                    bench_print(&r);
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+
+    if (csv && bench_write(csv, results, false))
+        return -1;
+    if (json && bench_write(json, results, true))
+        return -1;
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+LOCAL_PATH:= $(call my-dir)
+#======================================================================
+#
+#rgaReplay
+#
+#======================================================================
+include $(CLEAR_VARS)
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS += -Wall -Werror -Wunreachable-code
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../.. \
+    $(LOCAL_PATH)/../../include
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils \
+    libui \
+    libhardware \
+    librga
+
+LOCAL_HEADER_LIBRARIES += \
+    libutils_headers \
+    libcutils_headers \
+    libhardware_headers \
+    liblog_headers
+
+LOCAL_CFLAGS += -DANDROID_7_DRM -DANDROID
+
+ifneq (1,$(strip $(shell expr $(PLATFORM_VERSION) \< 8.0)))
+LOCAL_CFLAGS += -DANDROID_8
+endif
+
+LOCAL_SRC_FILES:= \
+    rgaReplay.cpp
+
+LOCAL_MODULE:= rgaReplay
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2020 Rockchip Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rgaReplay: re-issue a trace of rga requests (see RgaTrace.h) and compare the
+ * throughput with the one recorded on the device.
+ *
+ * Every request runs on buffers of its recorded geometry, allocated once per
+ * stride, height and format and filled with a pattern; the pixels of the device
+ * are not in the trace. The requests go through RockchipRga, so --backend sw
+ * replays a trace of a device on the cpu backend of any host.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <vector>
+#include <map>
+
+#include "RockchipRga.h"
+#include "RgaUtils.h"
+#include "RgaTrace.h"
+#include "rga.h"
+
+#define REPLAY_BUF_ALIGN    64
+
+/* the image of the request a buffer is for */
+enum {
+    REPLAY_SRC = 0,
+    REPLAY_DST,
+    REPLAY_PAT,
+};
+
+typedef struct {
+    long count;
+    long failed;
+    double mpix;            /* dst pixels */
+    int64_t recorded_ns;    /* duration of the requests on the device */
+    int64_t replay_ns;      /* duration of the requests here */
+} replay_stat_t;
+
+static const char *replay_op_names[] = { "total", "blit", "fill", "palette" };
+
+static std::map<uint64_t, void *> replay_buffers;
+
+static int64_t replay_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * a buffer large enough for the image, shared by the images of the same role and
+ * geometry. The trace does not say which images were the same memory, a src and
+ * a dst of the same geometry must not turn the request into an in-place one.
+ */
+static void *replay_buffer(const rga_trace_image_t *image, int role) {
+    int wstride = image->wstride > 0 ? image->wstride : image->width;
+    int hstride = image->hstride > 0 ? image->hstride : image->height;
+    uint64_t key = ((uint64_t)(uint16_t)wstride << 48) | ((uint64_t)(uint16_t)hstride << 32) |
+                   ((uint64_t)role << 24) | ((uint32_t)image->format & 0xffffff);
+    std::map<uint64_t, void *>::iterator it = replay_buffers.find(key);
+    size_t size;
+    void *addr;
+
+    if (it != replay_buffers.end())
+        return it->second;
+
+    /* 4 bytes per pixel covers every format of the trace, 10 bit yuv included */
+    size = (size_t)wstride * hstride * 4;
+    if (size == 0 || posix_memalign(&addr, REPLAY_BUF_ALIGN, size))
+        return NULL;
+
+    for (size_t i = 0; i < size; i++)
+        ((uint8_t *)addr)[i] = (uint8_t)(i * 7 + (i >> 10));
+
+    replay_buffers[key] = addr;
+    return addr;
+}
+
+static int replay_set_info(rga_info_t *info, const rga_trace_image_t *image, int role) {
+    memset(info, 0, sizeof(*info));
+    info->fd = -1;
+    info->mmuFlag = 1;
+    info->virAddr = replay_buffer(image, role);
+    if (info->virAddr == NULL)
+        return -1;
+
+    rga_set_rect(&info->rect, image->xoffset, image->yoffset, image->width, image->height,
+                 image->wstride > 0 ? image->wstride : image->width,
+                 image->hstride > 0 ? image->hstride : image->height, image->format);
+    return 0;
+}
+
+static int replay_record(const rga_trace_record_t *r) {
+    RockchipRga &rkRga(RockchipRga::get());
+    rga_info_t src, dst, pat;
+
+    if (r->op != RGA_TRACE_OP_FILL && replay_set_info(&src, &r->src, REPLAY_SRC))
+        return -ENOMEM;
+    if (replay_set_info(&dst, &r->dst, REPLAY_DST))
+        return -ENOMEM;
+    if ((r->op == RGA_TRACE_OP_PALETTE || (r->flags & RGA_TRACE_SRC1)) && r->pat.width > 0 &&
+        replay_set_info(&pat, &r->pat, REPLAY_PAT))
+        return -ENOMEM;
+
+    src.rotation = r->rotation;
+    src.blend = r->blend;
+    src.scale_mode = r->scale_mode;
+    src.rop_code = r->rop_code;
+    dst.color = r->color;
+    dst.color_space_mode = r->color_space_mode;
+    dst.sync_mode = (r->flags & RGA_TRACE_ASYNC) ? RGA_BLIT_ASYNC : RGA_BLIT_SYNC;
+
+    switch (r->op) {
+        case RGA_TRACE_OP_BLIT:
+            return rkRga.RkRgaBlit(&src, &dst, (r->flags & RGA_TRACE_SRC1) ? &pat : NULL);
+        case RGA_TRACE_OP_FILL:
+            return rkRga.RkRgaCollorFill(&dst);
+        case RGA_TRACE_OP_PALETTE:
+            return rkRga.RkRgaCollorPalette(&src, &dst, r->pat.width > 0 ? &pat : NULL);
+        default:
+            return -EINVAL;
+    }
+}
+
+static int replay_load(const char *path, rga_trace_header_t *header, std::vector<rga_trace_record_t> *records) {
+    FILE *f = fopen(path, "rb");
+    std::vector<uint8_t> raw;
+
+    if (f == NULL) {
+        printf("Failed to open %s\n", path);
+        return -1;
+    }
+
+    if (fread(header, sizeof(*header), 1, f) != 1 ||
+        memcmp(header->magic, RGA_TRACE_MAGIC, sizeof(header->magic)) != 0) {
+        printf("%s is not a rga trace\n", path);
+        fclose(f);
+        return -1;
+    }
+    if (header->version != RGA_TRACE_VERSION || header->record_size < sizeof(rga_trace_record_t)) {
+        printf("%s: unsupported trace version %u, record size %u\n", path,
+               header->version, header->record_size);
+        fclose(f);
+        return -1;
+    }
+
+    /* a newer writer may append fields to the record, keep the ones known here */
+    raw.resize(header->record_size);
+    while (fread(&raw[0], header->record_size, 1, f) == 1) {
+        rga_trace_record_t record;
+
+        memcpy(&record, &raw[0], sizeof(record));
+        records->push_back(record);
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static void replay_print(const char *name, const replay_stat_t *s) {
+    double recorded_ms = s->recorded_ns / 1e6, replay_ms = s->replay_ns / 1e6;
+
+    printf("%-8s %8ld %8ld %10.1f %12.2f %12.2f %14.1f %14.1f\n", name, s->count, s->failed, s->mpix,
+           recorded_ms, replay_ms,
+           recorded_ms > 0 ? s->mpix * 1000 / recorded_ms : 0,
+           replay_ms > 0 ? s->mpix * 1000 / replay_ms : 0);
+}
+
+static void replay_usage(void) {
+    printf("usage: rgaReplay [options] <trace>\n"
+           "  --backend <name>     hw, sw or auto, see RGA_BACKEND\n"
+           "  --loops <n>          replay the trace n times (default: 1)\n"
+           "  --paced              keep the recorded spacing of the requests\n"
+           "  --help\n");
+}
+
+int main(int argc, char *argv[]) {
+    rga_trace_header_t header;
+    std::vector<rga_trace_record_t> records;
+    replay_stat_t stats[4];
+    int loops = 1;
+    long recorded_failed = 0;
+    bool paced = false;
+    int64_t start, span = 0;
+    const char *backend = NULL;
+    int opt, option_index = 0;
+
+    static struct option options[] = {
+        { "backend", required_argument, NULL, 'b' },
+        {   "loops", required_argument, NULL, 'n' },
+        {   "paced",       no_argument, NULL, 'p' },
+        {    "help",       no_argument, NULL, 'h' },
+        {      NULL,                 0, NULL, 0   },
+    };
+
+    while ((opt = getopt_long(argc, argv, "h", options, &option_index)) != -1) {
+        switch (opt) {
+            case 'b':
+                backend = optarg;
+                break;
+            case 'n':
+                loops = atoi(optarg);
+                break;
+            case 'p':
+                paced = true;
+                break;
+            case 'h':
+            default:
+                replay_usage();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    if (optind != argc - 1 || loops <= 0) {
+        replay_usage();
+        return -1;
+    }
+
+    /* librga picked its backend from RGA_BACKEND when it was loaded */
+    if (backend != NULL && RockchipRga::get().RkRgaSetBackend(backend)) {
+        printf("Failed to init the %s backend.\n", backend);
+        return -1;
+    }
+
+    if (replay_load(argv[optind], &header, &records))
+        return -1;
+
+    printf("trace %s: pid %d, driver %.2f, %zu requests\n", argv[optind], header.pid,
+           header.driver_version, records.size());
+    if (records.empty())
+        return 0;
+
+    memset(stats, 0, sizeof(stats));
+    start = replay_now_ns();
+
+    for (int loop = 0; loop < loops; loop++) {
+        int64_t loop_start = replay_now_ns();
+
+        for (size_t i = 0; i < records.size(); i++) {
+            const rga_trace_record_t *r = &records[i];
+            int64_t t0, t1;
+            int ret;
+
+            if (r->op < RGA_TRACE_OP_BLIT || r->op > RGA_TRACE_OP_PALETTE)
+                continue;
+
+            if (paced) {
+                int64_t wait = r->time_ns - records[0].time_ns - (replay_now_ns() - loop_start);
+
+                if (wait > 0)
+                    usleep(wait / 1000);
+            }
+
+            t0 = replay_now_ns();
+            ret = replay_record(r);
+            t1 = replay_now_ns();
+
+            /* the totals and the op */
+            for (int k = 0; k < 2; k++) {
+                replay_stat_t *s = &stats[k == 0 ? 0 : r->op];
+
+                s->count++;
+                s->failed += ret != 0;
+                s->mpix += (double)r->dst.width * r->dst.height / 1e6;
+                s->recorded_ns += r->duration_ns;
+                s->replay_ns += t1 - t0;
+            }
+        }
+    }
+
+    /* the async requests queued by the last loop */
+    RockchipRga::get().RkRgaFlush();
+    span = replay_now_ns() - start;
+
+    printf("%-8s %8s %8s %10s %12s %12s %14s %14s\n", "op", "count", "failed", "MPix",
+           "device(ms)", "replay(ms)", "device MPix/s", "replay MPix/s");
+    for (int k = 1; k < 4; k++)
+        if (stats[k].count)
+            replay_print(replay_op_names[k], &stats[k]);
+    replay_print(replay_op_names[0], &stats[0]);
+
+    printf("recorded span %.2f ms, replay wall %.2f ms for %d loop(s)\n",
+           (records.back().time_ns + records.back().duration_ns - records[0].time_ns) / 1e6,
+           span / 1e6, loops);
+    for (size_t i = 0; i < records.size(); i++)
+        recorded_failed += records[i].ret != 0;
+    if (recorded_failed)
+        printf("%ld requests of the trace had failed on the device\n", recorded_failed);
+
+    for (std::map<uint64_t, void *>::iterator it = replay_buffers.begin(); it != replay_buffers.end(); it++)
+        free(it->second);
+
+    return stats[0].failed ? 1 : 0;
+}
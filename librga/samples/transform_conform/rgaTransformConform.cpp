@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2020 Rockchip Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rgaTransformConform: every combination of IM_HAL_TRANSFORM_ROT_* and
+ * IM_HAL_TRANSFORM_FLIP_H/FLIP_V through improcess() against a cpu reference on
+ * RGBA_8888. im2d flips first and rotates clockwise after, so a rotation with both
+ * flips is the rotation plus 180: ROT_90|FLIP_H|FLIP_V must match ROT_270 and
+ * ROT_180|FLIP_H|FLIP_V the source.
+ *
+ * The result must match the reference exactly. Exits non zero on a mismatch or on
+ * a transform that fails. Without /dev/rga, run it with --backend sw.
+ */
+
+#include "im2d_api/im2d.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "RockchipRga.h"
+#include "RgaUtils.h"
+#include "rga.h"
+
+#define CONFORM_WIDTH       64
+#define CONFORM_HEIGHT      32
+
+static const struct {
+    int usage;
+    const char *name;
+} conform_rotations[] = {
+    { 0,                       "rot0"   },
+    { IM_HAL_TRANSFORM_ROT_90,  "rot90"  },
+    { IM_HAL_TRANSFORM_ROT_180, "rot180" },
+    { IM_HAL_TRANSFORM_ROT_270, "rot270" },
+}, conform_flips[] = {
+    { 0,                                                 ""      },
+    { IM_HAL_TRANSFORM_FLIP_H,                           "|h"    },
+    { IM_HAL_TRANSFORM_FLIP_V,                           "|v"    },
+    { IM_HAL_TRANSFORM_FLIP_H | IM_HAL_TRANSFORM_FLIP_V, "|h|v"  },
+};
+
+/* every pixel tells where it comes from */
+static void conform_pattern(uint32_t *buf, int width, int height) {
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            buf[y * width + x] = 0xff000000 | (y << 8) | x;
+}
+
+/* flip, then rotate clockwise by 90 as many times as the rotation asks */
+static void conform_reference(int usage, const uint32_t *src, uint32_t *out, int *out_width, int *out_height) {
+    int turns = (usage & IM_HAL_TRANSFORM_ROT_90) ? 1 :
+                (usage & IM_HAL_TRANSFORM_ROT_180) ? 2 :
+                (usage & IM_HAL_TRANSFORM_ROT_270) ? 3 : 0;
+
+    *out_width = turns % 2 ? CONFORM_HEIGHT : CONFORM_WIDTH;
+    *out_height = turns % 2 ? CONFORM_WIDTH : CONFORM_HEIGHT;
+
+    for (int y = 0; y < CONFORM_HEIGHT; y++) {
+        for (int x = 0; x < CONFORM_WIDTH; x++) {
+            int w = CONFORM_WIDTH, h = CONFORM_HEIGHT;
+            int tx = (usage & IM_HAL_TRANSFORM_FLIP_H) ? w - 1 - x : x;
+            int ty = (usage & IM_HAL_TRANSFORM_FLIP_V) ? h - 1 - y : y;
+
+            for (int i = 0; i < turns; i++) {
+                int nx = h - 1 - ty;
+
+                ty = tx;
+                tx = nx;
+                h = w;
+                w = *out_width + *out_height - h;
+            }
+
+            out[ty * *out_width + tx] = src[y * CONFORM_WIDTH + x];
+        }
+    }
+}
+
+static int conform_run(int usage, const char *name) {
+    int pixels = CONFORM_WIDTH * CONFORM_HEIGHT;
+    size_t size = (size_t)pixels * 4;
+    uint32_t *a = (uint32_t *)malloc(size), *b = (uint32_t *)malloc(size), *ref = (uint32_t *)malloc(size);
+    rga_buffer_t src, dst, pat;
+    im_rect srect, drect, prect;
+    int width, height, bad = 0;
+    IM_STATUS ret;
+
+    if (!a || !b || !ref) {
+        printf("%-12s out of memory\n", name);
+        free(a); free(b); free(ref);
+        return -1;
+    }
+
+    conform_pattern(a, CONFORM_WIDTH, CONFORM_HEIGHT);
+    memset(b, 0, size);
+    conform_reference(usage, a, ref, &width, &height);
+
+    memset(&pat, 0, sizeof(pat));
+    memset(&srect, 0, sizeof(srect));
+    memset(&drect, 0, sizeof(drect));
+    memset(&prect, 0, sizeof(prect));
+
+    src = wrapbuffer_virtualaddr(a, CONFORM_WIDTH, CONFORM_HEIGHT, RK_FORMAT_RGBA_8888);
+    dst = wrapbuffer_virtualaddr(b, width, height, RK_FORMAT_RGBA_8888);
+
+    ret = improcess(src, dst, pat, srect, drect, prect, usage);
+    if (ret == IM_STATUS_SUCCESS) {
+        for (int i = 0; i < pixels; i++) {
+            if (b[i] != ref[i] && bad++ == 0)
+                printf("%-12s pixel %d,%d: from %d,%d, expected from %d,%d\n", name,
+                       i % width, i / width, b[i] & 0xff, (b[i] >> 8) & 0xff,
+                       ref[i] & 0xff, (ref[i] >> 8) & 0xff);
+        }
+    }
+
+    printf("%-12s %-8s %d mismatch(es)\n", name, ret == IM_STATUS_SUCCESS ? "ok" : imStrError_t(ret), bad);
+
+    free(a);
+    free(b);
+    free(ref);
+
+    return ret == IM_STATUS_SUCCESS && bad == 0 ? 0 : -1;
+}
+
+static void conform_usage(void) {
+    printf("usage: rgaTransformConform [options]\n"
+           "  --backend <name>     hw, sw or auto, see RGA_BACKEND\n"
+           "  --help\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *backend = NULL;
+    int failed = 0;
+    int opt, option_index = 0;
+
+    static struct option options[] = {
+        { "backend", required_argument, NULL, 'b' },
+        {    "help",       no_argument, NULL, 'h' },
+        {      NULL,                 0, NULL, 0   },
+    };
+
+    while ((opt = getopt_long(argc, argv, "h", options, &option_index)) != -1) {
+        switch (opt) {
+            case 'b':
+                backend = optarg;
+                break;
+            case 'h':
+            default:
+                conform_usage();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    /* librga picked its backend from RGA_BACKEND when it was loaded */
+    if (backend != NULL && RockchipRga::get().RkRgaSetBackend(backend)) {
+        printf("Failed to init the %s backend.\n", backend);
+        return -1;
+    }
+
+    for (size_t r = 0; r < sizeof(conform_rotations) / sizeof(conform_rotations[0]); r++) {
+        for (size_t f = 0; f < sizeof(conform_flips) / sizeof(conform_flips[0]); f++) {
+            char name[32];
+            int usage = conform_rotations[r].usage | conform_flips[f].usage;
+
+            /* nothing to do */
+            if (usage == 0)
+                continue;
+
+            snprintf(name, sizeof(name), "%s%s", conform_rotations[r].name, conform_flips[f].name);
+            failed += conform_run(usage, name) != 0;
+        }
+    }
+
+    printf("%d failure(s)\n", failed);
+
+    return failed ? 1 : 0;
+}